@@ -10,13 +10,23 @@
 #include "libs/Kernel.h"
 #include "libs/Pin.h"
 #include "libs/ADC/adc.h"
-#include "libs/Pin.h"
-#include "libs/Median.h"
+#include "libs/SlowTicker.h"
+#include "Config.h"
+#include "ConfigValue.h"
+#include "checksumm.h"
+#include "platform_memory.h"
 
 #include <cstring>
 #include <algorithm>
 
 #include "mbed.h"
+#include "lpc17xx_gpdma.h"
+
+#define adc_dma_enable_checksum CHECKSUM("adc_dma_enable")
+
+// the lowest priority DMA channel
+#define ADC_DMA_CHANNEL 7
+#define ADC_DMA_CH LPC_GPDMACH7
 
 // This is an interface to the mbed.org ADC library you can find in libs/ADC/adc.h
 // TODO : Having the same name is confusing, should change that
@@ -31,11 +41,78 @@ static void sample_isr(int chan, uint32_t value)
 Adc::Adc()
 {
     instance = this;
+    memset(sample_buffers, 0, sizeof(sample_buffers));
+    memset(sample_sums, 0, sizeof(sample_sums));
+    memset(sample_heads, 0, sizeof(sample_heads));
+    memset(median_window, 0, sizeof(median_window));
+    dma_buffer= nullptr;
+    dma_read_index= 0;
+
     // ADC sample rate need to be fast enough to be able to read the enabled channels within the thermistor poll time
     // even though ther maybe 32 samples we only need one new one within the polling time
     const uint32_t sample_rate= 1000; // 1KHz sample rate
     this->adc = new mbed::ADC(sample_rate, 8);
-    this->adc->append(sample_isr);
+
+    if(THEKERNEL->config->value(adc_dma_enable_checksum)->by_default(false)->as_bool()) {
+        setup_dma();
+    } else {
+        this->adc->append(sample_isr);
+    }
+}
+
+// Have the GPDMA copy every burst mode conversion from ADGDR into a circular buffer, so there is no ADC interrupt at all
+void Adc::setup_dma()
+{
+    // DMA cannot access the local SRAM so the buffer has to be in AHB SRAM
+    dma_buffer= (uint32_t *)AHB0.alloc(dma_buffer_size * sizeof(uint32_t));
+    if(dma_buffer == nullptr) {
+        // fall back to the ISR
+        this->adc->append(sample_isr);
+        return;
+    }
+    memset(dma_buffer, 0, dma_buffer_size * sizeof(uint32_t));
+
+    // a linked list item pointing to itself restarts the transfer at the start of the buffer forever
+    static GPDMA_LLI_Type lli;
+    GPDMA_Channel_CFG_Type cfg;
+    cfg.ChannelNum= ADC_DMA_CHANNEL;
+    cfg.TransferSize= dma_buffer_size;
+    cfg.TransferWidth= GPDMA_WIDTH_WORD;
+    cfg.TransferType= GPDMA_TRANSFERTYPE_P2M;
+    cfg.SrcConn= GPDMA_CONN_ADC;
+    cfg.DstConn= 0;
+    cfg.SrcMemAddr= 0;
+    cfg.DstMemAddr= (uint32_t)dma_buffer;
+    cfg.DMALLI= (uint32_t)&lli;
+
+    GPDMA_Init();
+    GPDMA_Setup(&cfg);
+
+    lli.SrcAddr= (uint32_t)&LPC_ADC->ADGDR;
+    lli.DstAddr= (uint32_t)dma_buffer;
+    lli.NextLLI= (uint32_t)&lli;
+    lli.Control= ADC_DMA_CH->DMACCControl & ~GPDMA_DMACCxControl_I; // no terminal count interrupt
+
+    GPDMA_ChannelCmd(ADC_DMA_CHANNEL, ENABLE);
+
+    // drain the buffer well before the DMA can lap us, 64 entries at 1KHz sample rate is 64ms
+    THEKERNEL->slow_ticker->attach(100, this, &Adc::dma_tick);
+}
+
+// Feed the conversions the DMA has written since the last time into the filters, called from the SlowTicker
+uint32_t Adc::dma_tick(uint32_t)
+{
+    uint16_t write_index= (uint32_t *)ADC_DMA_CH->DMACCDestAddr - dma_buffer;
+    if(write_index >= dma_buffer_size) write_index= 0;
+
+    while(dma_read_index != write_index) {
+        uint32_t v= dma_buffer[dma_read_index];
+        if(v & (1UL << 31)) { // DONE bit, the channel is in bits 24-26
+            new_sample((v >> 24) & 0x07, v);
+        }
+        if(++dma_read_index >= dma_buffer_size) dma_read_index= 0;
+    }
+    return 0;
 }
 
 /*
@@ -58,66 +135,57 @@ void Adc::enable_pin(Pin *pin)
     PinName pin_name = this->_pin_to_pinname(pin);
     int channel = adc->_pin_to_channel(pin_name);
     memset(sample_buffers[channel], 0, sizeof(sample_buffers[0]));
+    memset(median_window[channel], 0, sizeof(median_window[0]));
+    sample_sums[channel]= 0;
+    sample_heads[channel]= 0;
 
     this->adc->burst(1);
     this->adc->setup(pin_name, 1);
+    // also needed to generate the DMA request
     this->adc->interrupt_state(pin_name, 1);
+    if(dma_buffer != nullptr) NVIC_DisableIRQ(ADC_IRQn);
+}
+
+static inline uint16_t median_of_3(uint16_t a, uint16_t b, uint16_t c)
+{
+    if(a > b) std::swap(a, b);
+    return (c <= a) ? a : (c >= b) ? b : c;
 }
 
-// Keeps the last 8 values for each channel
-// This is called in an ISR, so sample_buffers needs to be accessed atomically
+// Keeps the last num_samples values for each channel and their sum, takes constant time
+// This is called in an ISR, and read() only reads the sum which is a single atomic word
 void Adc::new_sample(int chan, uint32_t value)
 {
-    // Shuffle down and add new value to the end
     if(chan < num_channels) {
-        memmove(&sample_buffers[chan][0], &sample_buffers[chan][1], sizeof(sample_buffers[0]) - sizeof(sample_buffers[0][0]));
-        sample_buffers[chan][num_samples - 1] = (value >> 4) & 0xFFF; // the 12 bit ADC reading
+        // a median of the last 3 readings rejects single sample spikes
+        uint16_t *w= median_window[chan];
+        w[0]= w[1];
+        w[1]= w[2];
+        w[2]= (value >> 4) & 0xFFF; // the 12 bit ADC reading
+        uint16_t m= median_of_3(w[0], w[1], w[2]);
+
+        // replace the oldest value in the ring buffer and update the running sum
+        uint8_t h= sample_heads[chan];
+        sample_sums[chan] += m - sample_buffers[chan][h];
+        sample_buffers[chan][h]= m;
+        sample_heads[chan]= (h + 1) % num_samples;
     }
 }
 
-//#define USE_MEDIAN_FILTER
 // Read the filtered value ( burst mode ) on a given pin
 unsigned int Adc::read(Pin *pin)
 {
     PinName p = this->_pin_to_pinname(pin);
     int channel = adc->_pin_to_channel(p);
 
-    uint16_t median_buffer[num_samples];
-    // needs atomic access TODO maybe be able to use std::atomic here or some lockless mutex
-    __disable_irq();
-    memcpy(median_buffer, sample_buffers[channel], sizeof(median_buffer));
-    __enable_irq();
-
-#ifdef USE_MEDIAN_FILTER
-    // returns the median value of the last 8 samples
-    return median_buffer[quick_median(median_buffer, num_samples)];
-
-#elif defined(OVERSAMPLE)
-    // Oversample to get 2 extra bits of resolution
-    // weed out top and bottom worst values then oversample the rest
-    // put into a 4 element moving average and return the average of the last 4 oversampled readings
-    static uint16_t ave_buf[num_channels][4] =  { {0} };
-    std::sort(median_buffer, median_buffer + num_samples);
-    uint32_t sum = 0;
-    for (int i = num_samples / 4; i < (num_samples - (num_samples / 4)); ++i) {
-        sum += median_buffer[i];
-    }
-    // this slows down the rate of change a little bit
-    ave_buf[channel][3]= ave_buf[channel][2];
-    ave_buf[channel][2]= ave_buf[channel][1];
-    ave_buf[channel][1]= ave_buf[channel][0];
-    ave_buf[channel][0]= sum >> OVERSAMPLE;
-    return roundf((ave_buf[channel][0]+ave_buf[channel][1]+ave_buf[channel][2]+ave_buf[channel][3])/4.0F);
+    // no need to lock as the running sum is updated in a single write
+    uint32_t sum= sample_sums[channel];
 
+#ifdef OVERSAMPLE
+    // Oversample to get 2 extra bits of resolution from the average of all the samples
+    return ((sum << OVERSAMPLE) + (num_samples / 2)) / num_samples;
 #else
-    // sort the 8 readings and return the average of the middle 4
-    std::sort(median_buffer, median_buffer + num_samples);
-    int sum = 0;
-    for (int i = num_samples / 4; i < (num_samples - (num_samples / 4)); ++i) {
-        sum += median_buffer[i];
-    }
-    return sum / (num_samples / 2);
-
+    return (sum + (num_samples / 2)) / num_samples;
 #endif
 }
 
@@ -41,17 +41,28 @@ public:
 
 private:
     PinName _pin_to_pinname(Pin *pin);
+    void setup_dma();
+    uint32_t dma_tick(uint32_t);
     mbed::ADC *adc;
 
     static const int num_channels= 6;
 #ifdef OVERSAMPLE
-    // we need 4^n sample to oversample and we get double that to filter out spikes
+    // we need 4^n sample to oversample and we get double that to filter out noise
     static const int num_samples= powf(4, OVERSAMPLE)*2;
 #else
     static const int num_samples= 8;
 #endif
-    // buffers storing the last num_samples readings for each channel
+    // ring buffers storing the last num_samples readings for each channel, and the running sum of each buffer
     uint16_t sample_buffers[num_channels][num_samples];
+    uint32_t sample_sums[num_channels];
+    uint8_t sample_heads[num_channels];
+    // the last 3 raw readings of each channel for the median spike filter
+    uint16_t median_window[num_channels][3];
+
+    // when fed by GPDMA the conversions are written to a circular buffer in AHB SRAM and drained from a SlowTicker hook
+    static const int dma_buffer_size= 64;
+    uint32_t *dma_buffer;
+    uint16_t dma_read_index;
 };
 
 #endif
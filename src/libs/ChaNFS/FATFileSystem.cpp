@@ -64,6 +64,17 @@ FATFileSystem::~FATFileSystem() {
     }
 }
 
+// writes count consecutive sectors, override if the disk can write them all in one go
+int FATFileSystem::disk_write_blocks(const char *buffer, int sector, int count) {
+    for(int s = sector; s < sector + count; s++) {
+        FFSDEBUG(" disk_write(sector %d)\n", s);
+        int res = disk_write(buffer, s);
+        if(res) return res;
+        buffer += 512;
+    }
+    return 0;
+}
+
 FileHandle *FATFileSystem::open(const char* name, int flags) {
     FFSDEBUG("open(%s) on filesystem [%s], drv [%d]\n", name, _name, _fsid);
     char n[64];
@@ -5,4 +5,12 @@ extern "C"{
 
 // Hook is just a glorified FPointer
 
-Hook::Hook(){}
+Hook::Hook()
+{
+    interval= 0;
+    deadline= 0;
+    calls= 0;
+    max_exec= 0;
+    max_jitter= 0;
+    total_exec= 0;
+}
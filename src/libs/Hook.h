@@ -7,8 +7,14 @@
 class Hook : public FPointer {
     public:
         Hook();
-        int     interval;
-        int     countdown;
+        uint32_t interval;  // in timer ticks
+        uint32_t deadline;  // timer count when it is next due
+
+        // execution statistics in timer ticks, gathered by the SlowTicker
+        uint32_t calls;
+        uint32_t max_exec;
+        uint32_t max_jitter;
+        uint64_t total_exec;
 };
 
 #endif
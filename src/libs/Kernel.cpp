@@ -225,6 +225,9 @@ void Kernel::add_module(Module* module){
 // Adds a hook for a given module and event
 void Kernel::register_for_event(_EVENT_ENUM id_event, Module *mod){
     this->hooks[id_event].push_back(mod);
+#ifdef PERF_PROFILING
+    this->hook_stats[id_event].push_back({0, 0, 0});
+#endif
 }
 
 // Call a specific event with an argument
@@ -236,9 +239,20 @@ void Kernel::call_event(_EVENT_ENUM id_event, void * argument){
     }
 
     // send to all registered modules
+#ifdef PERF_PROFILING
+    std::vector<Module*> &h= hooks[id_event];
+    std::vector<Perf::stat_t> &stats= hook_stats[id_event];
+    for (size_t i = 0; i < h.size(); ++i) {
+        PERF_START(t);
+        (h[i]->*kernel_callback_functions[id_event])(argument);
+        // the handler may have unregistered itself
+        if(i < stats.size()) PERF_END(stats[i], t);
+    }
+#else
     for (auto m : hooks[id_event]) {
         (m->*kernel_callback_functions[id_event])(argument);
     }
+#endif
 
     if(id_event == ON_HALT && this->halted && !was_idle) {
         // we need to try to correct current positions if we were running
@@ -259,9 +273,54 @@ void Kernel::unregister_for_event(_EVENT_ENUM id_event, Module *mod)
 {
     for (auto i = hooks[id_event].begin(); i != hooks[id_event].end(); ++i) {
         if(*i == mod) {
+#ifdef PERF_PROFILING
+            hook_stats[id_event].erase(hook_stats[id_event].begin() + (i - hooks[id_event].begin()));
+#endif
             hooks[id_event].erase(i);
             return;
         }
     }
 }
 
+
+#ifdef PERF_PROFILING
+#include "StreamOutput.h"
+#include <algorithm>
+
+static const char *event_names[NUMBER_OF_DEFINED_EVENTS]= {
+    "main_loop", "console_line", "gcode", "idle", "second_tick", "get_data", "set_data", "halt", "enable"
+};
+
+// modules do not have names, the vtable address can be looked up in the map file to see which one it is
+void Kernel::print_event_stats(StreamOutput *stream)
+{
+    struct entry_t {
+        int event;
+        Module *module;
+        Perf::stat_t stat;
+    };
+
+    std::vector<entry_t> entries;
+    for (int e = 0; e < NUMBER_OF_DEFINED_EVENTS; ++e) {
+        for (size_t i = 0; i < hooks[e].size(); ++i) {
+            if(hook_stats[e][i].calls > 0) entries.push_back({e, hooks[e][i], hook_stats[e][i]});
+        }
+    }
+
+    // the most total time first
+    std::sort(entries.begin(), entries.end(), [](const entry_t& a, const entry_t& b) { return a.stat.total > b.stat.total; });
+
+    stream->printf("%-12s %-8s %-8s %10s %10s %10s %12s\n", "event", "module", "vtable", "calls", "avg us", "max us", "total ms");
+    for(auto& en : entries) {
+        stream->printf("%-12s %08lX %08lX ", event_names[en.event], (uint32_t)en.module, *(uint32_t*)en.module);
+        Perf::print_stat(stream, en.stat);
+    }
+}
+
+void Kernel::reset_event_stats()
+{
+    for(auto& v : hook_stats) {
+        for(auto& s : v) s.reset();
+    }
+}
+#endif
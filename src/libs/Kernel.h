@@ -13,6 +13,7 @@
 #define THEROBOT THEKERNEL->robot
 
 #include "Module.h"
+#include "Perf.h"
 #include <array>
 #include <vector>
 #include <string>
@@ -32,6 +33,7 @@ class Adc;
 class PublicData;
 class SimpleShell;
 class Configurator;
+class StreamOutput;
 
 class Kernel {
     public:
@@ -56,6 +58,11 @@ class Kernel {
 
         std::string get_query_string();
 
+#ifdef PERF_PROFILING
+        void print_event_stats(StreamOutput *stream);
+        void reset_event_stats();
+#endif
+
         // These modules are available to all other modules
         SerialConsole*    serial;
         StreamOutputPool* streams;
@@ -77,6 +84,10 @@ class Kernel {
     private:
         // When a module asks to be called for a specific event ( a hook ), this is where that request is remembered
         std::array<std::vector<Module*>, NUMBER_OF_DEFINED_EVENTS> hooks;
+#ifdef PERF_PROFILING
+        // time spent in each hook, in the same order as hooks
+        std::array<std::vector<Perf::stat_t>, NUMBER_OF_DEFINED_EVENTS> hook_stats;
+#endif
         struct {
             bool use_leds:1;
             bool halted:1;
@@ -0,0 +1,58 @@
+#include "MotionCurrent.h"
+#include "Kernel.h"
+#include "Config.h"
+#include "ConfigValue.h"
+#include "StepTicker.h"
+#include "us_ticker_api.h"
+
+MotionCurrent::MotionCurrent()
+{
+    for (int i = 0; i < 4; i++) {
+        phase_factor[i]= 1.0F;
+    }
+    hold_time= 0;
+    raised_time= 0;
+    phase= StepTicker::PHASE_IDLE;
+    dynamic= false;
+}
+
+void MotionCurrent::config_load(const uint16_t settings[5], uint16_t module_checksum, uint16_t name_checksum)
+{
+    float values[5];
+    float defaults[5]= { 1.0F, 1.0F, 1.0F, 1.0F, 100 };
+    for (int i = 0; i < 5; i++) {
+        ConfigValue *v= module_checksum == 0 ? THEKERNEL->config->value(settings[i]) : THEKERNEL->config->value(module_checksum, name_checksum, settings[i]);
+        values[i]= v->by_default(defaults[i])->as_number();
+    }
+
+    // all 1 turns this off
+    dynamic= false;
+    for (int i = 0; i < 4; i++) {
+        phase_factor[i]= values[i];
+        if(phase_factor[i] != 1.0F) dynamic= true;
+    }
+    hold_time= values[4] * 1000; // ms to us
+    phase= StepTicker::PHASE_IDLE;
+    raised_time= us_ticker_read();
+}
+
+// called from on_idle, returns true when the factor has changed and the current has to be set again. It is raised
+// straight away but only lowered once a lower one has been asked for for hold_time, otherwise a stream of short
+// segments would have it rewriting the chip on every block
+bool MotionCurrent::follow()
+{
+    if(!dynamic) return false;
+
+    uint8_t p= StepTicker::getInstance()->get_motion_phase();
+    uint32_t now= us_ticker_read();
+
+    if(phase_factor[p] >= phase_factor[phase]) {
+        raised_time= now;
+    } else if(now - raised_time < hold_time) {
+        return false;
+    }
+
+    bool changed= phase_factor[p] != phase_factor[phase];
+    phase= p;
+    return changed;
+}
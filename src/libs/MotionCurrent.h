@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Scales a motor current by the motion phase of the block being stepped, eg lower when idle or cruising and full when
+// accelerating. Used by the modules that set the current, from on_idle as the chips are written over I2C or SPI.
+class MotionCurrent {
+    public:
+        MotionCurrent();
+
+        // settings are the checksums of the idle, accel, cruise and decel factor and then the hold time settings,
+        // under module and name when given
+        void config_load(const uint16_t settings[5], uint16_t module_checksum= 0, uint16_t name_checksum= 0);
+        bool follow();
+
+        bool is_dynamic() const { return dynamic; }
+        float factor() const { return dynamic ? phase_factor[phase] : 1.0F; }
+
+    private:
+        float phase_factor[4]; // indexed by StepTicker::MOTION_PHASE
+        uint32_t hold_time;    // us a lower factor has to be asked for before the current is lowered
+        uint32_t raised_time;
+        uint8_t phase;
+        bool dynamic;
+};
@@ -196,6 +196,8 @@ LPC17XX_Ethernet::LPC17XX_Ethernet()
     instance = this;
 
     up = false;
+    rx_discard = false;
+    memset(&stats, 0, sizeof(stats));
 }
 
 void LPC17XX_Ethernet::on_module_loaded()
@@ -377,36 +379,6 @@ void LPC17XX_Ethernet::set_mac(uint8_t* newmac)
     memcpy(mac_address, newmac, 6);
 }
 
-// size must be preloaded with max size of packet buffer
-bool LPC17XX_Ethernet::_receive_frame(void *packet, int *size)
-{
-    if (can_read_packet() && can_write_packet())
-    {
-        int i = LPC_EMAC->RxConsumeIndex;
-        RX_Stat* stat = &(rxbuf.rxstat[i]);
-        int len = (stat->Info & EMAC_RINFO_SIZE) + 1; //this is the index so add one to get the size
-        if(len <= *size) { // check against recieving buffer length
-            memcpy(packet, rxbuf.buf[i], len);
-            *size= len;
-        }else{
-            // discard frame that is too big for input buffer
-            DEBUG_PRINTF("WARNING: Discarded ethernet frame that is too big: %08lX, %d - %d\n", stat->Info, len, *size);
-            *size= 0;
-        }
-
-        //DEBUG_PRINTF("Received %d byte Ethernet frame %lu/%lu\n", *size, LPC_EMAC->RxProduceIndex, LPC_EMAC->RxConsumeIndex);
-
-        uint32_t r = LPC_EMAC->RxConsumeIndex + 1;
-        if (r > LPC_EMAC->RxDescriptorNumber)
-            r = 0;
-        LPC_EMAC->RxConsumeIndex = r;
-
-        return *size > 0;
-    }
-
-    return false;
-}
-
 void LPC17XX_Ethernet::irq()
 {
     // if (EMAC_IntGetStatus(EMAC_INT_RX_DONE))
@@ -424,12 +396,41 @@ bool LPC17XX_Ethernet::can_read_packet()
     return (LPC_EMAC->RxProduceIndex != LPC_EMAC->RxConsumeIndex);
 }
 
+// returns the length of the next good frame and leaves it in its receive buffer, or 0 if there is none. Frames with errors,
+// and frames too big for one buffer which the EMAC splits over several, are dropped here
 int LPC17XX_Ethernet::read_packet(uint8_t** buf)
 {
-    *buf = rxbuf.buf[LPC_EMAC->RxConsumeIndex];
-    return rxbuf.rxstat[LPC_EMAC->RxConsumeIndex].Info & EMAC_RINFO_SIZE;
+    check_rx();
+
+    while (can_read_packet()) {
+        int i = LPC_EMAC->RxConsumeIndex;
+        uint32_t info = rxbuf.rxstat[i].Info;
+
+        if ((info & EMAC_RINFO_LAST_FLAG) == 0) {
+            // the frame carries on into the next buffer
+            if (!rx_discard) stats.rx_too_big++;
+            rx_discard = true;
+
+        } else if (rx_discard) {
+            // the last part of a frame that was too big
+            rx_discard = false;
+
+        } else if (info & EMAC_RINFO_ERR_MASK) {
+            stats.rx_errors++;
+
+        } else {
+            stats.rx_frames++;
+            *buf = rxbuf.buf[i];
+            return (info & EMAC_RINFO_SIZE) + 1; // the size is stored less one
+        }
+
+        release_read_packet(rxbuf.buf[i]);
+    }
+
+    return 0;
 }
 
+// hands the receive buffer of the frame back to the EMAC
 void LPC17XX_Ethernet::release_read_packet(uint8_t*)
 {
     uint32_t r = LPC_EMAC->RxConsumeIndex + 1;
@@ -438,6 +439,40 @@ void LPC17XX_Ethernet::release_read_packet(uint8_t*)
     LPC_EMAC->RxConsumeIndex = r;
 }
 
+// keeps the receive statistics up to date, and restarts the receive path if it has overrun
+void LPC17XX_Ethernet::check_rx()
+{
+    if (LPC_EMAC->IntStatus & EMAC_INT_RX_OVERRUN) {
+        stats.rx_overruns++;
+        reset_rx();
+    }
+
+    uint32_t used = (LPC_EMAC->RxProduceIndex + LPC17XX_RXBUFS - LPC_EMAC->RxConsumeIndex) % LPC17XX_RXBUFS;
+    stats.rx_used = used;
+    if (used > stats.rx_used_max) stats.rx_used_max = used;
+    // one buffer is always left empty, so the ring is full with one less than there are, and stays full until a
+    // frame is released, so each time it is seen full here is a separate time it filled
+    if (used == LPC17XX_RXBUFS - 1) stats.rx_full++;
+}
+
+// the EMAC stops receiving after an overrun until the receive path is reset, which drops the frames waiting in the ring
+void LPC17XX_Ethernet::reset_rx()
+{
+    LPC_EMAC->MAC1 &= ~EMAC_MAC1_REC_EN;
+    LPC_EMAC->Command &= ~EMAC_CR_RX_EN;
+    LPC_EMAC->Command |= EMAC_CR_RX_RES;
+
+    LPC_EMAC->RxDescriptor       = (uint32_t) rxbuf.rxdesc;
+    LPC_EMAC->RxStatus           = (uint32_t) rxbuf.rxstat;
+    LPC_EMAC->RxDescriptorNumber = LPC17XX_RXBUFS-1;
+    LPC_EMAC->RxConsumeIndex     = LPC_EMAC->RxProduceIndex;
+    rx_discard = false;
+
+    LPC_EMAC->IntClear = EMAC_INT_RX_OVERRUN;
+    LPC_EMAC->Command |= EMAC_CR_RX_EN;
+    LPC_EMAC->MAC1 |= EMAC_MAC1_REC_EN;
+}
+
 bool LPC17XX_Ethernet::can_write_packet()
 {
     uint32_t r = LPC_EMAC->TxProduceIndex + 1;
@@ -454,8 +489,10 @@ int LPC17XX_Ethernet::write_packet(uint8_t* buf, int size)
     if (r > LPC_EMAC->TxDescriptorNumber)
         r = 0;
 
-    if (r == LPC_EMAC->TxConsumeIndex)
+    if (r == LPC_EMAC->TxConsumeIndex) {
+        stats.tx_full++;
         return 0;
+    }
 
     LPC_EMAC->TxProduceIndex = r;
 
@@ -13,7 +13,9 @@
 
 #define LPC17XX_MAX_PACKET 600
 #define LPC17XX_TXBUFS     4
-#define LPC17XX_RXBUFS     4
+// frames are processed in place in the receive buffers, so there are enough of them to take a burst while the stack
+// works through the ones already received
+#define LPC17XX_RXBUFS     8
 
 typedef struct {
     void* packet;
@@ -32,6 +34,18 @@ typedef struct {
     packet_desc txdesc[LPC17XX_TXBUFS];
 } _txbuf_t;
 
+// what happened to the frames, for the net command
+typedef struct {
+    uint32_t rx_frames;     // good frames handed to the stack
+    uint32_t rx_errors;     // frames dropped with CRC, symbol, length or alignment errors
+    uint32_t rx_too_big;    // frames dropped for not fitting in a receive buffer
+    uint32_t rx_full;       // times every receive buffer held a frame, any arriving then were lost
+    uint32_t rx_overruns;   // times the receive path overran and was reset
+    uint32_t tx_full;       // frames not sent as every transmit buffer was in use
+    uint8_t rx_used;        // receive buffers holding frames when last looked at
+    uint8_t rx_used_max;    // the most there have been
+} eth_stats_t;
+
 class LPC17XX_Ethernet;
 
 class LPC17XX_Ethernet : public Module, public NetworkInterface
@@ -49,11 +63,10 @@ public:
 
     void irq(void);
 
-    bool _receive_frame(void *packet, int* size);
-
     // NetworkInterface methods
 //     void provide_net(netcore* n);
     bool can_read_packet(void);
+    // the next good frame is left in its receive buffer, the buffer is not reused until the frame is released
     int read_packet(uint8_t**);
     void release_read_packet(uint8_t*);
     void periodical(int);
@@ -70,6 +83,8 @@ public:
     NET_PAYLOAD get_payload_buffer(NET_PACKET);
     void        set_payload_length(NET_PACKET, int);
 
+    const eth_stats_t& get_stats(void) { return stats; }
+
     static LPC17XX_Ethernet* instance;
 
 private:
@@ -77,6 +92,11 @@ private:
     static _txbuf_t txbuf;
 
     void check_interface();
+    void check_rx();
+    void reset_rx();
+
+    eth_stats_t stats;
+    bool rx_discard; // dropping the rest of a frame that did not fit in one receive buffer
 };
 
 #endif /* _LPC17XX_ETHERNET_H */
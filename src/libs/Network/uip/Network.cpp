@@ -10,6 +10,7 @@
 
 #include "Network.h"
 #include "PublicDataRequest.h"
+#include "PublicData.h"
 #include "PlayerPublicAccess.h"
 #include "net_util.h"
 #include "uip_arp.h"
@@ -23,6 +24,7 @@
 #include "webserver.h"
 #include "dhcpc.h"
 #include "sftpd.h"
+#include "streamd.h"
 
 #ifndef NOPLAN9
 #include "plan9.h"
@@ -36,6 +38,8 @@
 #define network_webserver_checksum CHECKSUM("webserver")
 #define network_telnet_checksum CHECKSUM("telnet")
 #define network_plan9_checksum CHECKSUM("plan9")
+#define network_gcode_stream_checksum CHECKSUM("gcode_stream")
+#define network_port_checksum CHECKSUM("port")
 #define network_mac_override_checksum CHECKSUM("mac_override")
 #define network_ip_address_checksum CHECKSUM("ip_address")
 #define network_hostname_checksum CHECKSUM("hostname")
@@ -57,6 +61,7 @@ Network::Network()
     sftpd= NULL;
     hostname = NULL;
     plan9_enabled= false;
+    gcode_stream_enabled= false;
     command_q= CommandQueue::getInstance();
 }
 
@@ -132,6 +137,8 @@ void Network::on_module_loaded()
     webserver_enabled = THEKERNEL->config->value( network_checksum, network_webserver_checksum, network_enable_checksum )->by_default(false)->as_bool();
     telnet_enabled = THEKERNEL->config->value( network_checksum, network_telnet_checksum, network_enable_checksum )->by_default(false)->as_bool();
     plan9_enabled = THEKERNEL->config->value( network_checksum, network_plan9_checksum, network_enable_checksum )->by_default(false)->as_bool();
+    gcode_stream_enabled = THEKERNEL->config->value( network_checksum, network_gcode_stream_checksum, network_enable_checksum )->by_default(false)->as_bool();
+    gcode_stream_port = THEKERNEL->config->value( network_checksum, network_gcode_stream_checksum, network_port_checksum )->by_default(7000)->as_int();
     string mac = THEKERNEL->config->value( network_checksum, network_mac_override_checksum )->by_default("")->as_string();
     if (mac.size() == 17 ) { // parse mac address
         if (!parse_ip_str(mac, mac_address, 6, 16, ':')) {
@@ -195,6 +202,7 @@ void Network::on_module_loaded()
     this->register_for_event(ON_IDLE);
     this->register_for_event(ON_MAIN_LOOP);
     this->register_for_event(ON_GET_PUBLIC_DATA);
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, network_checksum);
 
     this->init();
 }
@@ -221,6 +229,22 @@ void Network::on_get_public_data(void* argument) {
         str[n1+n2+n3+n4]= '\0';
         pdr->set_data_ptr(str);
         pdr->set_taken();
+
+    }else if(pdr->second_element_is(get_netstats_checksum)) {
+        // NOTE caller must free the returned string when done
+        const eth_stats_t& st= ethernet->get_stats();
+        char buf[256];
+        int n= snprintf(buf, sizeof(buf), "Rx: %lu frames, dropped %lu with errors, %lu too big\n"
+            "Rx buffers: %u of %d in use, most %u, all in use %lu times, %lu overruns\n"
+            "Tx: %lu frames dropped with no free buffer\n",
+            st.rx_frames, st.rx_errors, st.rx_too_big,
+            st.rx_used, LPC17XX_RXBUFS - 1, st.rx_used_max, st.rx_full, st.rx_overruns,
+            st.tx_full);
+        char *str = (char *)malloc(n+1);
+        memcpy(str, buf, n);
+        str[n]= '\0';
+        pdr->set_data_ptr(str);
+        pdr->set_taken();
     }
 }
 
@@ -235,12 +259,27 @@ void Network::on_idle(void *argument)
 {
     if (!ethernet->isUp()) return;
 
-    int len= sizeof(uip_buf); // set maximum size
-    if (ethernet->_receive_frame(uip_buf, &len)) {
+    // work through the frames waiting in the receive buffers, each is processed where it is and only released once
+    // whatever it needed sending back has gone to a transmit buffer, so there has to be a free one first
+    bool received= false;
+    uint8_t *frame;
+    int len;
+    for (int n = 0; n < LPC17XX_RXBUFS && ethernet->can_write_packet() && (len= ethernet->read_packet(&frame)) > 0; ++n) {
+#if UIP_BUFFER_POINTER
+        uip_buf= frame;
+#else
+        memcpy(uip_buf, frame, len);
+#endif
         uip_len = len;
         this->handlePacket();
+#if UIP_BUFFER_POINTER
+        uip_buf= uip_static_buf;
+#endif
+        ethernet->release_read_packet(frame);
+        received= true;
+    }
 
-    } else {
+    if (!received) {
 
         if (timer_expired(&periodic_timer)) { /* no packet but periodic_timer time out (0.1s)*/
             timer_reset(&periodic_timer);
@@ -290,7 +329,42 @@ void Network::on_idle(void *argument)
             uip_arp_timer();
         }
     }
+
+#if UIP_TCP_SNDQ
+    fill_send_queue();
+#endif
+
+    // the gcode stream opens its window again as soon as the main loop has made room, and sends its replies, rather
+    // than waiting for the periodic poll
+    if (gcode_stream_enabled && ethernet->can_write_packet()) {
+        struct uip_conn *connr= Streamd::connection_to_poll();
+        if (connr != NULL) {
+            uip_poll_conn(connr);
+            if (uip_len > 0) {
+                uip_arp_out();
+                tapdev_send(uip_buf, uip_len);
+            }
+        }
+    }
+}
+
+#if UIP_TCP_SNDQ
+// poll the connections whose last data went into the send queue so they can send more straight away, rather than
+// waiting for the ack or the next periodic poll, for as long as there is room for the frames
+void Network::fill_send_queue()
+{
+    for (struct uip_conn *connr = &uip_conns[0]; connr <= &uip_conns[UIP_CONNS - 1]; ++connr) {
+        if ((connr->tcpstateflags & UIP_TS_MASK) != UIP_ESTABLISHED) continue;
+
+        while (uip_sndq_pending(connr) && ethernet->can_write_packet()) {
+            uip_poll_conn(connr);
+            if (uip_len == 0) break;
+            uip_arp_out();
+            tapdev_send(uip_buf, uip_len);
+        }
+    }
 }
+#endif
 
 void Network::setup_servers()
 {
@@ -314,6 +388,12 @@ void Network::setup_servers()
     }
 #endif
 
+    if (gcode_stream_enabled) {
+        // Initialize the raw gcode streaming server
+        Streamd::init(gcode_stream_port);
+        printf("Gcode stream initialized on port %u\n", gcode_stream_port);
+    }
+
     // sftpd service, which is lazily created on reciept of first packet
     uip_listen(HTONS(115));
 }
@@ -391,6 +471,8 @@ void Network::on_main_loop(void *argument)
     while(command_q->pop()) {
         // keep feeding them until empty
     }
+
+    if (gcode_stream_enabled) Streamd::dispatch_lines();
 }
 
 // select between webserver and telnetd server
@@ -421,6 +503,10 @@ extern "C" void app_select_appcall(void)
             break;
 
         default:
+            if (theNetwork->gcode_stream_enabled && uip_conn->lport == HTONS(theNetwork->gcode_stream_port)) {
+                Streamd::appcall();
+                break;
+            }
             printf("unknown app for port: %d\n", uip_conn->lport);
 
     }
@@ -433,14 +519,18 @@ void Network::tapdev_send(void *pPacket, unsigned int size)
 }
 
 // define this to split full frames into two to illicit an ack from the endpoint
+// not needed with the send queue, which has several frames in flight
+#if !UIP_TCP_SNDQ
 #define SPLIT_OUTPUT
+#endif
 
-#ifdef SPLIT_OUTPUT
 extern "C" void uip_split_output(void);
 extern "C" void tcpip_output()
 {
     theNetwork->tapdev_send(uip_buf, uip_len);
 }
+
+#ifdef SPLIT_OUTPUT
 void network_device_send()
 {
     uip_split_output();
@@ -449,7 +539,7 @@ void network_device_send()
 #else
 void network_device_send()
 {
-    tapdev_send(uip_buf, uip_len);
+    tcpip_output();
 }
 #endif
 
@@ -4,5 +4,6 @@
 #define network_checksum        CHECKSUM("network")
 #define get_ip_checksum         CHECKSUM("getip")
 #define get_ipconfig_checksum   CHECKSUM("getipconfig")
+#define get_netstats_checksum   CHECKSUM("getnetstats")
 
 #endif
@@ -0,0 +1,118 @@
+#include "UploadSink.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+UploadSink::UploadSink()
+{
+    fp= NULL;
+    buf= NULL;
+    used= 0;
+    limit= 0;
+    pos= 0;
+    failed= false;
+}
+
+UploadSink::~UploadSink()
+{
+    close();
+}
+
+// open the file with the given mode and start writing at offset
+bool UploadSink::open(const char *filename, const char *mode, long offset)
+{
+    close();
+
+    buf= (char *)malloc(buffer_size);
+    if(buf == NULL) return false;
+
+    fp= fopen(filename, mode);
+    if(fp == NULL) {
+        close();
+        return false;
+    }
+
+    // we do the buffering, stdio buffering would just copy it again and split the writes up
+    setvbuf(fp, NULL, _IONBF, 0);
+
+    // when appending the position is not at the end until the first write, so put it there to know where the sectors start
+    int res= (mode[0] == 'a') ? fseek(fp, 0, SEEK_END) : fseek(fp, offset, SEEK_SET);
+    if(res != 0) {
+        close();
+        return false;
+    }
+
+    pos= ftell(fp);
+    used= 0;
+    // the first flush takes the file to the next sector boundary, after that every flush is whole sectors
+    limit= buffer_size - (pos % 512);
+    failed= false;
+    return true;
+}
+
+bool UploadSink::write(const void *data, size_t len)
+{
+    if(fp == NULL || failed) return false;
+
+    const char *p= (const char *)data;
+    while(len > 0) {
+        size_t n= limit - used;
+        if(n > len) n= len;
+        memcpy(&buf[used], p, n);
+        used += n;
+        pos += n;
+        p += n;
+        len -= n;
+        if(used == limit && !flush()) return false;
+    }
+    return true;
+}
+
+bool UploadSink::flush()
+{
+    if(used > 0 && fwrite(buf, 1, used, fp) != used) failed= true;
+    used= 0;
+    limit= buffer_size;
+    return !failed;
+}
+
+// writes whatever is left and closes the file, returns false if anything could not be written
+bool UploadSink::close()
+{
+    bool ok= true;
+    if(fp != NULL) {
+        ok= flush();
+        if(fclose(fp) != 0) ok= false;
+        fp= NULL;
+    }
+    if(buf != NULL) {
+        free(buf);
+        buf= NULL;
+    }
+    return ok;
+}
+
+// C interface for the webserver
+extern "C" void *new_upload_sink(const char *filename)
+{
+    UploadSink *sink= new UploadSink();
+    if(!sink->open(filename)) {
+        delete sink;
+        return NULL;
+    }
+    return sink;
+}
+
+extern "C" int upload_sink_write(void *sink, const void *data, unsigned int len)
+{
+    return ((UploadSink*)sink)->write(data, len) ? 1 : 0;
+}
+
+// closes and deletes the sink, returns 0 if the file was not completely written
+extern "C" int upload_sink_close(void *sink)
+{
+    UploadSink *s= (UploadSink*)sink;
+    bool ok= s->close();
+    delete s;
+    return ok ? 1 : 0;
+}
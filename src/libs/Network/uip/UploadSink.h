@@ -0,0 +1,45 @@
+#ifndef UPLOADSINK_H
+#define UPLOADSINK_H
+
+// Saves data arriving from the network to a file on the sdcard.
+// The data is collected until there are whole sectors to write, so the filesystem gets sector aligned writes it can pass
+// straight to the card as one multi block write, instead of a read modify write of a sector for every packet.
+
+#ifdef __cplusplus
+#include <stdio.h>
+#include <stddef.h>
+
+class UploadSink {
+    public:
+        UploadSink();
+        ~UploadSink();
+
+        bool open(const char *filename, const char *mode= "w", long offset= 0);
+        bool write(const void *data, size_t len);
+        bool close();
+
+        bool is_open() const { return fp != NULL; }
+        long tell() const { return pos; }
+
+        static const size_t buffer_size= 4 * 512; // must be a multiple of the sector size
+
+    private:
+        bool flush();
+
+        FILE *fp;
+        char *buf;
+        size_t used;  // bytes in buf
+        size_t limit; // flush when this many bytes are in buf, less than buffer_size until the file position is sector aligned
+        long pos;     // file position after everything in buf is written
+        bool failed;
+};
+
+#else
+
+extern void *new_upload_sink(const char *filename);
+extern int upload_sink_write(void *sink, const void *data, unsigned int len);
+extern int upload_sink_close(void *sink);
+
+#endif // __cplusplus
+
+#endif
@@ -525,6 +525,13 @@ bool Plan9::process(Message* request, Message* response)
 {
     Entry entry;
 
+    // anything other than a write might look at the file being uploaded so finish it first, an error writing the end of
+    // it is reported to this request as there is nothing else left to report it to
+    if (upload.is_open() && request->type != Twrite) {
+        bool ok = upload.close();
+        CHECK(ok, EIO);
+    }
+
     switch (request->type) {
     case Tversion:
         DEBUG_PRINTF("Tversion\n");
@@ -701,13 +708,17 @@ bool Plan9::process(Message* request, Message* response)
                   request->Twrite.count <= IOUNIT, EBADMSG);
             CHECK(entry = get_entry(request->fid));
 
-            File fp(entry->first, "r+");
-            CHECK(fp, EIO);
-            CHECK(!fseek(fp, request->Twrite.offset, SEEK_SET), EIO);
+            // writes carry on from the last one when uploading a file, so keep it open and collect them into whole sectors
+            if (!upload.is_open() || upload_path != entry->first || upload.tell() != (long)request->Twrite.offset) {
+                bool ok = upload.close();
+                CHECK(ok, EIO);
+                CHECK(upload.open(entry->first.c_str(), "r+", request->Twrite.offset), EIO);
+                upload_path = entry->first;
+            }
 
             RESPONSE(Rwrite);
-            response->Rwrite.count = fwrite(request->buf + sizeof (request->Twrite), 1, request->Twrite.count, fp);
-            CHECK(response->Rwrite.count == request->Twrite.count || !ferror(fp), EIO);
+            CHECK(upload.write(request->buf + sizeof (request->Twrite), request->Twrite.count), EIO);
+            response->Rwrite.count = request->Twrite.count;
         }
         break;
 
@@ -24,6 +24,8 @@
 #include <string>
 #include <stdint.h>
 
+#include "UploadSink.h"
+
 extern "C" {
 #include "psock.h"
 }
@@ -68,6 +70,8 @@ private:
     char                 bufin[INITIAL_MSIZE], bufout[INITIAL_MSIZE];
     std::queue<Message*> queue;
     uint32_t             msize, queue_bytes;
+    UploadSink           upload;
+    std::string          upload_path;
 };
 
 #endif
@@ -6,7 +6,8 @@
  */
 
 
-#include <stdio.h>
+#include "UploadSink.h"
+
 extern "C" {
 #include "psock.h"
 }
@@ -21,7 +22,7 @@ public:
     void init(void);
 
 private:
-    FILE *fd;
+    UploadSink upload;
     enum STATES { STATE_NORMAL, STATE_CONNECTED, STATE_GET_LENGTH, STATE_DOWNLOAD, STATE_CLOSE };
     STATES state;
     int acked();
@@ -33,7 +34,6 @@ private:
     char buf[80];
     const char *outbuf;
     unsigned int filesize;
-    char *filename;
 };
 
 #endif /* __sftpd_H__ */
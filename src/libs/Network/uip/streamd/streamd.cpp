@@ -0,0 +1,245 @@
+#include "streamd.h"
+
+#include "Kernel.h"
+#include "Conveyor.h"
+
+#include "uip.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+
+#define ISO_nl 0x0a
+#define ISO_cr 0x0d
+
+//#define DEBUG_PRINTF(...)
+#define DEBUG_PRINTF ::printf
+
+Streamd *Streamd::instance= NULL;
+
+Streamd::Streamd(struct uip_conn *conn)
+{
+    this->conn= conn;
+    message.stream= this;
+    message.message.reserve(MAX_LINE_LENGTH);
+    nlines= 0;
+    line_length= 0;
+    nsent= 0;
+    discarding= false;
+    dispatching= false;
+    closed= false;
+}
+
+Streamd::~Streamd()
+{
+}
+
+// replies go out as the connection is polled, ones that do not fit are dropped whole rather than holding up the gcode,
+// so a host that never reads them still gets the window, and never gets half a reply
+int Streamd::puts(const char *str)
+{
+    int len= strlen(str);
+    if(conn == NULL) return len;
+    if(output.capacity() - output.size() < len) return len;
+
+    for (int i = 0; i < len; ++i) {
+        output.push_back(str[i]);
+    }
+    return len;
+}
+
+void Streamd::put_char(char c)
+{
+    switch(c) {
+        case '?':
+            puts(THEKERNEL->get_query_string().c_str());
+            return;
+
+        case 'X' - 'A' + 1: // ^X
+            THEKERNEL->call_event(ON_HALT, nullptr);
+            return;
+
+        case ISO_cr:
+            // convert CR to NL (for host OSs that don't send NL)
+            c= ISO_nl;
+            break;
+    }
+
+    // there is always room for a full segment when one is accepted, this is just in case
+    if(input.size() >= input.capacity()) return;
+
+    if(c == ISO_nl) {
+        if(discarding) {
+            discarding= false;
+            puts("error: line too long\n");
+        } else {
+            input.push_back(c);
+            ++nlines;
+        }
+        line_length= 0;
+
+    } else if(discarding) {
+        return;
+
+    } else if(line_length < MAX_LINE_LENGTH) {
+        input.push_back(c);
+        ++line_length;
+
+    } else {
+        // a line that is too long is dropped whole, as what fits of it could still be a valid but wrong command,
+        // so take back what has been buffered of it, the dispatcher only reads up to the last newline
+        input.head= (input.head - line_length) & (INPUT_SIZE - 1);
+        discarding= true;
+    }
+}
+
+void Streamd::newdata(void)
+{
+    const char *p= (const char *)uip_appdata;
+    for (int len = uip_datalen(); len > 0; --len) {
+        put_char(*p++);
+    }
+
+    // the next segment would not fit, so stop reading until the main loop has made room
+    if(input.capacity() - input.size() < UIP_TCP_MSS) {
+        uip_stop();
+    }
+}
+
+// restart once there is room for a couple of segments, so the window does not open for just one at a time
+bool Streamd::can_restart(void)
+{
+    return input.capacity() - input.size() >= 2 * UIP_TCP_MSS;
+}
+
+void Streamd::acked(void)
+{
+    for (; nsent > 0; --nsent) {
+        output.delete_tail();
+    }
+}
+
+void Streamd::senddata(void)
+{
+    // sent bytes stay in the buffer until they are acked, so a retransmit sends the same ones again
+    if(!uip_rexmit()) {
+        if(nsent > 0) return;
+        nsent= std::min(output.size(), (int)uip_mss());
+    }
+    if(nsent == 0) return;
+
+    char *p= (char *)uip_appdata;
+    for (int i = 0, k = output.tail; i < nsent; ++i, k = output.next_block_index(k)) {
+        p[i]= output.buffer[k];
+    }
+    uip_send(uip_appdata, nsent);
+}
+
+// passes the buffered lines to the gcode dispatcher, stopping when the planner queue is full as the next move would
+// block until there was room, and the lines can wait here instead
+void Streamd::dispatch(void)
+{
+    while(nlines > 0 && !THEKERNEL->conveyor->is_queue_full()) {
+        message.message.clear();
+        char c;
+        for (input.pop_front(c); c != ISO_nl; input.pop_front(c)) {
+            message.message += c;
+        }
+        --nlines;
+
+        // the connection may close while the line is being dispatched
+        dispatching= true;
+        THEKERNEL->call_event(ON_CONSOLE_LINE_RECEIVED, &message);
+        dispatching= false;
+
+        if(closed) {
+            delete this;
+            return;
+        }
+    }
+}
+
+// the connection has gone, this is deleted once it is no longer dispatching a line
+void Streamd::release(void)
+{
+    DEBUG_PRINTF("Streamd: closed %p\n", this);
+    conn= NULL;
+    if(instance == this) instance= NULL;
+    if(dispatching) closed= true;
+    else delete this;
+}
+
+// static
+void Streamd::dispatch_lines(void)
+{
+    if(instance != NULL) instance->dispatch();
+}
+
+// the connection wants polling now rather than at the next periodic poll, either to open the window again as soon as
+// there is room or to send replies
+// static
+struct uip_conn *Streamd::connection_to_poll(void)
+{
+    if(instance == NULL || instance->conn == NULL) return NULL;
+
+    if(uip_stopped(instance->conn) && instance->can_restart()) return instance->conn;
+    if(instance->nsent == 0 && instance->output.size() > 0) return instance->conn;
+    return NULL;
+}
+
+// static
+void Streamd::appcall(void)
+{
+    Streamd *s= static_cast<Streamd *>(uip_conn->appstate);
+
+    if(uip_connected()) {
+        if(instance != NULL) {
+            // lines from two hosts would be mixed up, so only one may stream at a time
+            DEBUG_PRINTF("Streamd: already streaming, refused %u\n", HTONS(uip_conn->rport));
+            uip_conn->appstate= NULL;
+            uip_abort();
+            return;
+        }
+        s= new Streamd(uip_conn);
+        uip_conn->appstate= s;
+        instance= s;
+        DEBUG_PRINTF("Streamd: new instance %p\n", s);
+    }
+
+    if(uip_closed() || uip_aborted() || uip_timedout()) {
+        if(s != NULL) {
+            uip_conn->appstate= NULL;
+            s->release();
+        }
+        return;
+    }
+
+    // sanity check
+    if(s == NULL || s->conn != uip_conn) {
+        uip_abort();
+        return;
+    }
+
+    if(uip_acked()) {
+        s->acked();
+    }
+
+    if(uip_newdata()) {
+        s->newdata();
+    }
+
+    // whatever the event, with the send queue a poll may come as an ack
+    if(uip_stopped(uip_conn) && s->can_restart()) {
+        uip_restart();
+    }
+
+    if(uip_rexmit() || uip_newdata() || uip_acked() || uip_connected() || uip_poll()) {
+        s->senddata();
+    }
+}
+
+// static
+void Streamd::init(uint16_t port)
+{
+    uip_listen(HTONS(port));
+}
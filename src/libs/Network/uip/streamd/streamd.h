@@ -0,0 +1,61 @@
+#ifndef __STREAMD_H__
+#define __STREAMD_H__
+
+/*
+ * Raw gcode streaming over TCP.
+ *
+ * Lines are put into a ring buffer as they arrive and handed to the gcode dispatcher from the main loop, for as long as
+ * the planner queue has room. When it has not the buffer fills, and once it cannot take another full segment the
+ * connection is stopped, so the host is sent a zero window until there is room again. The host can just keep writing,
+ * there is no need to wait for an ok per line.
+ */
+
+#include "StreamOutput.h"
+#include "RingBuffer.h"
+#include "SerialMessage.h"
+
+#include <stdint.h>
+
+struct uip_conn;
+
+class Streamd : public StreamOutput
+{
+public:
+    Streamd(struct uip_conn *conn);
+    virtual ~Streamd();
+
+    static void init(uint16_t port);
+    static void appcall(void);
+    static void dispatch_lines(void);
+    static struct uip_conn *connection_to_poll(void);
+
+    int puts(const char *str);
+
+private:
+    static const int INPUT_SIZE= 2048; // must be a power of two for the RingBuffer
+    static const int OUTPUT_SIZE= 512;
+    static const int MAX_LINE_LENGTH= 132;
+
+    void newdata(void);
+    void senddata(void);
+    void acked(void);
+    void put_char(char c);
+    void dispatch(void);
+    void release(void);
+    bool can_restart(void);
+
+    static Streamd *instance;
+
+    struct uip_conn *conn;
+    RingBuffer<char, INPUT_SIZE> input;
+    RingBuffer<char, OUTPUT_SIZE> output;
+    SerialMessage message; // used for every line, so its string keeps its storage
+    uint16_t nlines;       // complete lines in the input buffer
+    uint16_t line_length;  // of the line being received
+    uint16_t nsent;        // bytes of the output sent but not acked
+    bool discarding;       // the line being received is too long and is dropped up to its newline
+    bool dispatching;
+    bool closed;
+};
+
+#endif /* __STREAMD_H__ */
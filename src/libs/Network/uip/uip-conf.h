@@ -102,9 +102,28 @@ typedef unsigned short uip_stats_t;
 /**
  * uIP buffer size.
  *
+ * This is the largest frame the ethernet driver takes (LPC17XX_MAX_PACKET)
+ * less the 4 byte CRC it stores with each received frame, which gives an
+ * MSS of 542 bytes, so each TCP segment fills an ethernet frame.
+ *
+ * \hideinitializer
+ */
+#define UIP_CONF_BUFFER_SIZE     596
+
+/**
+ * Received frames are processed in place in the ethernet driver's
+ * receive buffers, uip_buf points at the one being processed.
+ *
+ * \hideinitializer
+ */
+#define UIP_CONF_BUFFER_POINTER  1
+
+/**
+ * Number of segments in the TCP send queue, shared by all connections.
+ *
  * \hideinitializer
  */
-#define UIP_CONF_BUFFER_SIZE     400
+#define UIP_CONF_TCP_SNDQ        6
 
 #define UIP_CONF_BROADCAST 1
 
@@ -152,8 +152,14 @@ struct uip_eth_addr uip_ethaddr = {{0, 0, 0, 0, 0, 0}};
 #endif
 
 #ifndef UIP_CONF_EXTERNAL_BUFFER
+#if UIP_BUFFER_POINTER
+u8_t uip_static_buf[UIP_BUFSIZE + 4] __attribute__ ((section ("AHBSRAM1")));
+u8_t *uip_buf = uip_static_buf;  /* The packet buffer, or a frame the
+                    driver received in place. */
+#else /* UIP_BUFFER_POINTER */
 u8_t uip_buf[UIP_BUFSIZE + 4] __attribute__ ((section ("AHBSRAM1")));   /* The packet buffer that contains
                     incoming packets. */
+#endif /* UIP_BUFFER_POINTER */
 #endif /* UIP_CONF_EXTERNAL_BUFFER */
 
 void *uip_appdata;               /* The uip_appdata pointer points to
@@ -190,6 +196,26 @@ struct uip_udp_conn *uip_udp_conn;
 struct uip_udp_conn uip_udp_conns[UIP_UDP_CONNS]  __attribute__ ((section ("AHBSRAM1")));
 #endif /* UIP_UDP */
 
+#if UIP_TCP_SNDQ
+/* A segment in the send queue. It is kept until it has been
+   acknowledged so that it can be retransmitted without calling the
+   application. */
+struct uip_sndq_seg {
+    struct uip_conn *conn;     /* The connection the segment was queued
+                  on, NULL if it is free. */
+    u16_t len;                 /* The length of the data in the segment. */
+    u8_t next;                 /* Index + 1 of the next segment of the
+                  connection, 0 if this is the last one. */
+    u8_t data[UIP_TCP_MSS];
+};
+static struct uip_sndq_seg uip_sndq[UIP_TCP_SNDQ] __attribute__ ((section ("AHBSRAM1")));
+
+/* Set in the sndq_flags of a connection when a segment was sent
+   straight from uip_buf because the send queue was full. That segment
+   is retransmitted by the application, as it always was in uIP. */
+#define UIP_SNDQ_DIRECT 0x80
+#endif /* UIP_TCP_SNDQ */
+
 static u16_t ipid;           /* Ths ipid variable is an increasing
                 number that is used for the IP ID
                 field. */
@@ -247,6 +273,139 @@ static u16_t tmp16;
 #define ICMPBUF ((struct uip_icmpip_hdr *)&uip_buf[UIP_LLH_LEN])
 #define UDPBUF ((struct uip_udpip_hdr *)&uip_buf[UIP_LLH_LEN])
 
+#if UIP_TCP_SNDQ
+/*---------------------------------------------------------------------------*/
+/* Frees the segments of a connection that is being set up, any that
+   are left are from a connection that was closed. */
+static void
+sndq_reset(struct uip_conn *conn)
+{
+    u8_t i;
+
+    for (i = 0; i < UIP_TCP_SNDQ; ++i) {
+        if (uip_sndq[i].conn == conn) {
+            uip_sndq[i].conn = NULL;
+        }
+    }
+    conn->sndq = 0;
+    conn->sndq_flags = 0;
+    conn->snd_wnd = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the index + 1 of a free segment, or 0 if there is none. The
+   segments of a connection that has been closed are free. */
+static u8_t
+sndq_alloc(void)
+{
+    u8_t i;
+
+    for (i = 0; i < UIP_TCP_SNDQ; ++i) {
+        if (uip_sndq[i].conn == NULL ||
+            uip_sndq[i].conn->tcpstateflags == UIP_CLOSED) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks if a connection can take a full segment from the
+   application. */
+static u8_t
+sndq_ready(struct uip_conn *conn)
+{
+    if (conn->sndq_flags & UIP_SNDQ_DIRECT) {
+        return 0;
+    }
+    if (conn->len == 0) {
+        return 1;
+    }
+    return sndq_alloc() != 0 &&
+           (uint32_t)conn->len + conn->initialmss <= conn->snd_wnd;
+}
+/*---------------------------------------------------------------------------*/
+/* Copies the uip_slen bytes of data the application sent to the end of
+   the send queue of the connection. Returns 0 if there is no room for
+   it. */
+static u8_t
+sndq_append(struct uip_conn *conn)
+{
+    u8_t i, *last;
+
+    if (conn->len != 0 &&
+        (uint32_t)conn->len + uip_slen > conn->snd_wnd) {
+        return 0;
+    }
+    i = sndq_alloc();
+    if (i == 0) {
+        return 0;
+    }
+    uip_sndq[i - 1].conn = conn;
+    uip_sndq[i - 1].len = uip_slen;
+    uip_sndq[i - 1].next = 0;
+    memcpy(uip_sndq[i - 1].data, uip_sappdata, uip_slen);
+
+    for (last = &conn->sndq; *last != 0; last = &uip_sndq[*last - 1].next);
+    *last = i;
+    return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns how much of the data in flight on the connection the
+   incoming segment acknowledges, 0 if it is not a valid ack. */
+static u16_t
+sndq_acked(struct uip_conn *conn)
+{
+    uint32_t ackno, snd_nxt;
+
+    ackno = ((uint32_t)BUF->ackno[0] << 24) | ((uint32_t)BUF->ackno[1] << 16) |
+            ((uint32_t)BUF->ackno[2] << 8) | BUF->ackno[3];
+    snd_nxt = ((uint32_t)conn->snd_nxt[0] << 24) | ((uint32_t)conn->snd_nxt[1] << 16) |
+              ((uint32_t)conn->snd_nxt[2] << 8) | conn->snd_nxt[3];
+    ackno -= snd_nxt;
+    return ackno <= conn->len ? ackno : 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Moves snd_nxt on past n acknowledged bytes and drops the segments
+   they were in from the send queue. */
+static void
+sndq_ack(struct uip_conn *conn, u16_t n)
+{
+    struct uip_sndq_seg *seg;
+
+    uip_add32(conn->snd_nxt, n);
+    conn->snd_nxt[0] = uip_acc32[0];
+    conn->snd_nxt[1] = uip_acc32[1];
+    conn->snd_nxt[2] = uip_acc32[2];
+    conn->snd_nxt[3] = uip_acc32[3];
+    conn->len -= n;
+
+    while (conn->sndq != 0 && n > 0) {
+        seg = &uip_sndq[conn->sndq - 1];
+        if (seg->len > n) {
+            /* Only the start of the segment was acknowledged. */
+            memmove(seg->data, &seg->data[n], seg->len - n);
+            seg->len -= n;
+            return;
+        }
+        n -= seg->len;
+        conn->sndq = seg->next;
+        seg->conn = NULL;
+    }
+}
+/*---------------------------------------------------------------------------*/
+/* Puts the sequence number that follows the data in flight on the
+   connection into the outgoing segment. */
+static void
+sndq_seqno(struct uip_conn *conn)
+{
+    uip_add32(conn->snd_nxt, conn->len);
+    BUF->seqno[0] = uip_acc32[0];
+    BUF->seqno[1] = uip_acc32[1];
+    BUF->seqno[2] = uip_acc32[2];
+    BUF->seqno[3] = uip_acc32[3];
+    BUF->tcpoffset = (UIP_TCPH_LEN / 4) << 4;
+}
+#endif /* UIP_TCP_SNDQ */
+
 
 #if UIP_STATISTICS == 1
 struct uip_stats uip_stat;
@@ -404,6 +563,11 @@ uip_init(void)
     for (c = 0; c < UIP_CONNS; ++c) {
         uip_conns[c].tcpstateflags = UIP_CLOSED;
     }
+#if UIP_TCP_SNDQ
+    for (c = 0; c < UIP_TCP_SNDQ; ++c) {
+        uip_sndq[c].conn = NULL;
+    }
+#endif /* UIP_TCP_SNDQ */
 #if UIP_ACTIVE_OPEN
     lastport = 1024;
 #endif /* UIP_ACTIVE_OPEN */
@@ -475,6 +639,9 @@ again:
     conn->initialmss = conn->mss = UIP_TCP_MSS;
 
     conn->len = 1;   /* TCP length of the SYN is one. */
+#if UIP_TCP_SNDQ
+    sndq_reset(conn);
+#endif /* UIP_TCP_SNDQ */
     conn->nrtx = 0;
     conn->timer = 1; /* Send the SYN next time around. */
     conn->rto = UIP_RTO;
@@ -715,12 +882,30 @@ uip_process(u8_t flag)
     /* Check if we were invoked because of a poll request for a
        particular connection. */
     if (flag == UIP_POLL_REQUEST) {
+#if UIP_TCP_SNDQ
+        /* With a send queue the application is polled whenever it can
+           send a full segment, and it gets the event the send queue
+           owes it instead of the poll if there is one. */
+        if ((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+            sndq_ready(uip_connr)) {
+sndq_poll:
+            uip_flags = uip_sndq_pending(uip_connr);
+            if (uip_flags == 0) {
+                uip_flags = UIP_POLL;
+            }
+            uip_connr->sndq_flags = 0;
+            uip_len = uip_slen = 0;
+            UIP_APPCALL();
+            goto appsend;
+        }
+#else /* UIP_TCP_SNDQ */
         if ((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
             !uip_outstanding(uip_connr)) {
             uip_flags = UIP_POLL;
             UIP_APPCALL();
             goto appsend;
         }
+#endif /* UIP_TCP_SNDQ */
         goto drop;
 
         /* Check if we were invoked because of the perodic timer fireing. */
@@ -803,6 +988,12 @@ uip_process(u8_t flag)
 #endif /* UIP_ACTIVE_OPEN */
 
                         case UIP_ESTABLISHED:
+#if UIP_TCP_SNDQ
+                            /* Queued data is retransmitted from the send queue. */
+                            if (uip_connr->sndq != 0) {
+                                goto sndq_retransmit;
+                            }
+#endif /* UIP_TCP_SNDQ */
                             /* In the ESTABLISHED state, we call upon the application
                                    to do the actual retransmit after which we jump into
                                    the code for sending out the packet (the apprexmit
@@ -814,11 +1005,28 @@ uip_process(u8_t flag)
                         case UIP_FIN_WAIT_1:
                         case UIP_CLOSING:
                         case UIP_LAST_ACK:
+#if UIP_TCP_SNDQ
+                            /* The FIN goes after the data still in the send
+                               queue, which is retransmitted first. */
+                            if (uip_connr->sndq != 0) {
+                                goto sndq_retransmit;
+                            }
+#endif /* UIP_TCP_SNDQ */
                             /* In all these states we should retransmit a FINACK. */
                             goto tcp_send_finack;
 
                     }
                 }
+#if UIP_TCP_SNDQ
+            }
+            if ((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+                sndq_ready(uip_connr)) {
+                /* If there was no need for a retransmission, we poll the
+                   application for new data while it has room to send
+                   it. */
+                goto sndq_poll;
+            }
+#else /* UIP_TCP_SNDQ */
             } else if ((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
                 /* If there was no need for a retransmission, we poll the
                        application for new data. */
@@ -826,6 +1034,7 @@ uip_process(u8_t flag)
                 UIP_APPCALL();
                 goto appsend;
             }
+#endif /* UIP_TCP_SNDQ */
         }
         goto drop;
     }
@@ -1341,6 +1550,9 @@ found_listen:
     uip_connr->snd_nxt[2] = iss[2];
     uip_connr->snd_nxt[3] = iss[3];
     uip_connr->len = 1;
+#if UIP_TCP_SNDQ
+    sndq_reset(uip_connr);
+#endif /* UIP_TCP_SNDQ */
 
     /* rcv_nxt should be the seqno from the incoming packet + 1. */
     uip_connr->rcv_nxt[3] = BUF->seqno[3];
@@ -1349,7 +1561,8 @@ found_listen:
     uip_connr->rcv_nxt[0] = BUF->seqno[0];
     uip_add_rcv_nxt(1);
 
-    /* Parse the TCP MSS option, if present. */
+    /* Parse the TCP MSS option, if present, otherwise we use our own. */
+    uip_connr->initialmss = uip_connr->mss = UIP_TCP_MSS;
     if ((BUF->tcpoffset & 0xf0) > 0x50) {
         for (c = 0; c < ((BUF->tcpoffset >> 4) - 5) << 2 ;) {
             opt = uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN + c];
@@ -1446,6 +1659,15 @@ found:
        the outstanding data, calculate RTT estimations, and reset the
        retransmission timer. */
     if ((BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
+#if UIP_TCP_SNDQ
+        /* With a send queue several segments are in flight and any
+           number of them may be acknowledged, which drops them from
+           the queue. Only when all the outstanding data has been
+           acknowledged is the UIP_ACKDATA flag set. */
+        tmp16 = sndq_acked(uip_connr);
+        if (tmp16 > 0) {
+            sndq_ack(uip_connr, tmp16);
+#else /* UIP_TCP_SNDQ */
         uip_add32(uip_connr->snd_nxt, uip_connr->len);
 
         if (BUF->ackno[0] == uip_acc32[0] &&
@@ -1457,6 +1679,7 @@ found:
             uip_connr->snd_nxt[1] = uip_acc32[1];
             uip_connr->snd_nxt[2] = uip_acc32[2];
             uip_connr->snd_nxt[3] = uip_acc32[3];
+#endif /* UIP_TCP_SNDQ */
 
 
             /* Do RTT estimation, unless we have done retransmissions. */
@@ -1474,17 +1697,37 @@ found:
                 uip_connr->rto = (uip_connr->sa >> 3) + uip_connr->sv;
 
             }
-            /* Set the acknowledged flag. */
-            uip_flags = UIP_ACKDATA;
             /* Reset the retransmission timer. */
             uip_connr->timer = uip_connr->rto;
 
+#if UIP_TCP_SNDQ
+            if (uip_connr->len == 0) {
+                /* Set the acknowledged flag. */
+                uip_flags = UIP_ACKDATA;
+            } else if (uip_connr->nrtx != 0 && uip_connr->sndq != 0) {
+                /* The peer has only the segment that was retransmitted,
+                   so the next one is retransmitted at the next timer
+                   tick rather than waiting for it to time out. */
+                uip_connr->timer = 0;
+            }
+            uip_connr->nrtx = 0;
+#else /* UIP_TCP_SNDQ */
+            /* Set the acknowledged flag. */
+            uip_flags = UIP_ACKDATA;
+
             /* Reset length of outstanding data. */
             uip_connr->len = 0;
+#endif /* UIP_TCP_SNDQ */
         }
 
     }
 
+#if UIP_TCP_SNDQ
+    if (BUF->flags & TCP_ACK) {
+        uip_connr->snd_wnd = ((u16_t)BUF->wnd[0] << 8) + (u16_t)BUF->wnd[1];
+    }
+#endif /* UIP_TCP_SNDQ */
+
     /* Do different things depending on in what state the connection is. */
     switch (uip_connr->tcpstateflags & UIP_TS_MASK) {
             /* CLOSED and LISTEN are not handled here. CLOSE_WAIT is not
@@ -1643,13 +1886,20 @@ tcp_send_finack:
                of data. This data will not be acknowledged by the receiver,
                and the application will retransmit it. This is called the
                "persistent timer" and uses the retransmission mechanim.
+
+               With a send queue the MSS stays at the initial MSS, as the
+               application is told how much of its data was acknowledged
+               by it, and the window is instead checked when a segment is
+               queued.
             */
+#if !UIP_TCP_SNDQ
             tmp16 = ((u16_t)BUF->wnd[0] << 8) + (u16_t)BUF->wnd[1];
             if (tmp16 > uip_connr->initialmss ||
                 tmp16 == 0) {
                 tmp16 = uip_connr->initialmss;
             }
             uip_connr->mss = tmp16;
+#endif /* !UIP_TCP_SNDQ */
 
             /* If this packet constitutes an ACK for outstanding data (flagged
                by the UIP_ACKDATA flag, we should call the application since it
@@ -1667,7 +1917,27 @@ tcp_send_finack:
                put into the uip_appdata and the length of the data should be
                put into uip_len. If the application don't have any data to
                send, uip_len must be set to 0. */
+#if UIP_TCP_SNDQ
+            /* Queued data was acknowledged to the application when it
+               was queued, only a segment that was sent without being
+               queued is acknowledged to it now. Otherwise it gets the
+               event the send queue owes it, once it has room to send a
+               full segment. */
+            if (uip_connr->sndq_flags & UIP_SNDQ_DIRECT) {
+                if (uip_flags & UIP_ACKDATA) {
+                    uip_connr->sndq_flags = 0;
+                }
+            } else {
+                uip_flags &= ~UIP_ACKDATA;
+                if (uip_sndq_pending(uip_connr) && sndq_ready(uip_connr)) {
+                    uip_flags |= uip_sndq_pending(uip_connr);
+                    uip_connr->sndq_flags = 0;
+                }
+            }
+            if (uip_flags & (UIP_NEWDATA | UIP_ACKDATA | UIP_REXMIT)) {
+#else /* UIP_TCP_SNDQ */
             if (uip_flags & (UIP_NEWDATA | UIP_ACKDATA)) {
+#endif /* UIP_TCP_SNDQ */
                 uip_slen = 0;
                 UIP_APPCALL();
 
@@ -1682,13 +1952,63 @@ appsend:
 
                 if (uip_flags & UIP_CLOSE) {
                     uip_slen = 0;
+#if UIP_TCP_SNDQ
+                    /* The FIN follows the data still in the send queue. */
+                    uip_connr->tcpstateflags = UIP_FIN_WAIT_1;
+                    uip_connr->nrtx = 0;
+                    BUF->flags = TCP_FIN | TCP_ACK;
+                    uip_len = UIP_IPTCPH_LEN;
+                    sndq_seqno(uip_connr);
+                    ++uip_connr->len;
+                    goto tcp_send_seqno;
+#else /* UIP_TCP_SNDQ */
                     uip_connr->len = 1;
                     uip_connr->tcpstateflags = UIP_FIN_WAIT_1;
                     uip_connr->nrtx = 0;
                     BUF->flags = TCP_FIN | TCP_ACK;
                     goto tcp_send_nodata;
+#endif /* UIP_TCP_SNDQ */
                 }
 
+#if UIP_TCP_SNDQ
+                if (uip_slen > uip_connr->mss) {
+                    uip_slen = uip_connr->mss;
+                }
+                if (uip_slen > 0) {
+                    if (uip_connr->sndq_flags & UIP_SNDQ_DIRECT) {
+                        /* The application is retransmitting the segment
+                           that was not queued. */
+                        uip_slen = uip_connr->len;
+                    } else if (uip_connr->sndq_flags & UIP_ACKDATA) {
+                        /* The application has not been told its last data
+                           was queued yet, so this is that data again. */
+                        uip_slen = 0;
+                    } else if (sndq_append(uip_connr)) {
+                        /* Send the segment that was queued after the data
+                           already in flight, and tell the application it
+                           was acknowledged the next time it is called. */
+                        uip_connr->sndq_flags = UIP_ACKDATA;
+                        uip_appdata = uip_sappdata;
+                        uip_len = uip_slen + UIP_TCPIP_HLEN;
+                        BUF->flags = TCP_ACK | TCP_PSH;
+                        sndq_seqno(uip_connr);
+                        uip_connr->len += uip_slen;
+                        goto tcp_send_seqno;
+                    } else if (uip_connr->len == 0) {
+                        /* The send queue is full, so the segment is sent
+                           the way uIP always has, and retransmitted by the
+                           application. */
+                        uip_connr->len = uip_slen;
+                        uip_connr->sndq_flags = UIP_SNDQ_DIRECT;
+                        uip_connr->nrtx = 0;
+                    } else {
+                        /* There is no room for it, the application is
+                           asked to send it again when there is. */
+                        uip_connr->sndq_flags = UIP_REXMIT;
+                        uip_slen = 0;
+                    }
+                }
+#else /* UIP_TCP_SNDQ */
                 /* If uip_slen > 0, the application has data to be sent. */
                 if (uip_slen > 0) {
 
@@ -1722,6 +2042,7 @@ appsend:
                     }
                 }
                 uip_connr->nrtx = 0;
+#endif /* UIP_TCP_SNDQ */
 apprexmit:
                 uip_appdata = uip_sappdata;
 
@@ -1812,6 +2133,17 @@ apprexmit:
     goto drop;
 
 
+#if UIP_TCP_SNDQ
+sndq_retransmit:
+    /* Retransmit the oldest segment in the send queue, which starts at
+       snd_nxt. */
+    uip_slen = uip_sndq[uip_connr->sndq - 1].len;
+    memcpy(uip_appdata, uip_sndq[uip_connr->sndq - 1].data, uip_slen);
+    uip_len = uip_slen + UIP_TCPIP_HLEN;
+    BUF->flags = TCP_ACK | TCP_PSH;
+    goto tcp_send_noopts;
+#endif /* UIP_TCP_SNDQ */
+
     /* We jump here when we are ready to send the packet, and just want
        to set the appropriate TCP sequence numbers in the TCP header. */
 tcp_send_ack:
@@ -1825,16 +2157,21 @@ tcp_send:
        reply. Our job is to fill in all the fields of the TCP and IP
        headers before calculating the checksum and finally send the
        packet. */
-    BUF->ackno[0] = uip_connr->rcv_nxt[0];
-    BUF->ackno[1] = uip_connr->rcv_nxt[1];
-    BUF->ackno[2] = uip_connr->rcv_nxt[2];
-    BUF->ackno[3] = uip_connr->rcv_nxt[3];
-
     BUF->seqno[0] = uip_connr->snd_nxt[0];
     BUF->seqno[1] = uip_connr->snd_nxt[1];
     BUF->seqno[2] = uip_connr->snd_nxt[2];
     BUF->seqno[3] = uip_connr->snd_nxt[3];
 
+#if UIP_TCP_SNDQ
+tcp_send_seqno:
+    /* Segments sent from the send queue come in here with their own
+       sequence number. */
+#endif /* UIP_TCP_SNDQ */
+    BUF->ackno[0] = uip_connr->rcv_nxt[0];
+    BUF->ackno[1] = uip_connr->rcv_nxt[1];
+    BUF->ackno[2] = uip_connr->rcv_nxt[2];
+    BUF->ackno[3] = uip_connr->rcv_nxt[3];
+
     BUF->proto = UIP_PROTO_TCP;
 
     BUF->srcport  = uip_connr->lport;
@@ -344,6 +344,35 @@ void uip_setipid(u16_t id);
 #define uip_poll_conn(conn) do { uip_conn = conn; \
                                  uip_process(UIP_POLL_REQUEST); } while (0)
 
+#if UIP_TCP_SNDQ
+/**
+ * Check if the application on a connection is owed an event by the
+ * send queue.
+ *
+ * Once the data from an application has been queued, the application
+ * is told it was acknowledged the next time it is called, so that it
+ * can go on to send more. The device driver should keep polling a
+ * connection with uip_poll_conn() while this is true and a call gives
+ * it a packet to send, so the queue is filled as fast as the
+ * application can generate the data:
+ \code
+  while(uip_sndq_pending(conn)) {
+    uip_poll_conn(conn);
+    if(uip_len == 0) {
+      break;
+    }
+    uip_arp_out();
+    ethernet_devicedriver_send();
+  }
+ \endcode
+ *
+ * \param conn A pointer to the uip_conn struct for the connection.
+ *
+ * \hideinitializer
+ */
+#define uip_sndq_pending(conn) ((conn)->sndq_flags & (UIP_ACKDATA | UIP_REXMIT))
+#endif /* UIP_TCP_SNDQ */
+
 
 #if UIP_UDP
 /**
@@ -427,11 +456,21 @@ void uip_setipid(u16_t id);
  \endcode
  */
 
+#if UIP_BUFFER_POINTER
+#ifdef __cplusplus
+extern "C" u8_t *uip_buf;
+extern "C" u8_t uip_static_buf[UIP_BUFSIZE+4];
+#else
+extern u8_t *uip_buf;
+extern u8_t uip_static_buf[UIP_BUFSIZE+4];
+#endif
+#else /* UIP_BUFFER_POINTER */
 #ifdef __cplusplus
 extern "C" u8_t uip_buf[UIP_BUFSIZE+4];
 #else
 extern u8_t uip_buf[UIP_BUFSIZE+4];
 #endif
+#endif /* UIP_BUFFER_POINTER */
 
 #ifdef __cplusplus
 extern "C" {
@@ -1206,6 +1245,16 @@ struct uip_conn {
   u8_t timer;         /**< The retransmission timer. */
   u8_t nrtx;          /**< The number of retransmissions for the last
 			 segment sent. */
+#if UIP_TCP_SNDQ
+  u16_t snd_wnd;      /**< The window last advertised by the remote
+			 host. */
+  u8_t sndq;          /**< Index + 1 of the oldest segment of this
+			 connection in the send queue, 0 if it has
+			 none. */
+  u8_t sndq_flags;    /**< The event owed to the application by the
+			 send queue, and whether a segment was sent
+			 without being queued. */
+#endif /* UIP_TCP_SNDQ */
 
   /** The application state. */
   uip_tcp_appstate_t appstate;
@@ -1580,6 +1629,10 @@ struct uip_eth_addr {
   u8_t addr[6];
 };
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Calculate the Internet checksum over a buffer.
  *
@@ -1631,6 +1684,9 @@ u16_t uip_tcpchksum(void);
  */
 u16_t uip_udpchksum(void);
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* __UIP_H__ */
 
@@ -319,6 +319,26 @@
 #define UIP_RECEIVE_WINDOW UIP_CONF_RECEIVE_WINDOW
 #endif
 
+/**
+ * The number of segments in the TCP send queue.
+ *
+ * When this is non-zero, the data sent by an application is copied
+ * into a pool of segment buffers shared by all connections and the
+ * application is told it has been acknowledged as soon as it is
+ * queued, so that several segments can be in flight on a connection
+ * at once. Lost segments are retransmitted from the queue without
+ * calling the application. When the pool is full a connection with
+ * nothing in flight sends one segment at a time, as uIP does when
+ * this is zero.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SNDQ
+#define UIP_TCP_SNDQ UIP_CONF_TCP_SNDQ
+#else /* UIP_CONF_TCP_SNDQ */
+#define UIP_TCP_SNDQ 0
+#endif /* UIP_CONF_TCP_SNDQ */
+
 /**
  * How long a connection should stay in the TIME_WAIT state.
  *
@@ -381,6 +401,23 @@
 #define UIP_BUFSIZE UIP_CONF_BUFFER_SIZE
 #endif /* UIP_CONF_BUFFER_SIZE */
 
+/**
+ * Make uip_buf a pointer rather than an array.
+ *
+ * It points at uip_static_buf unless the device driver points it at
+ * a frame in its own receive buffer, which uIP then processes and
+ * replies to in place, so the frame does not have to be copied. The
+ * driver's buffer must hold at least UIP_BUFSIZE bytes and the
+ * pointer must be set back to uip_static_buf afterwards.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_BUFFER_POINTER
+#define UIP_BUFFER_POINTER UIP_CONF_BUFFER_POINTER
+#else /* UIP_CONF_BUFFER_POINTER */
+#define UIP_BUFFER_POINTER 0
+#endif /* UIP_CONF_BUFFER_POINTER */
+
 
 /**
  * Determines if statistics support should be compiled in.
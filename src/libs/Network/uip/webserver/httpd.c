@@ -74,6 +74,7 @@
 
 #include "CommandQueue.h"
 #include "CallbackStream.h"
+#include "UploadSink.h"
 
 #include "c-fifo.h"
 
@@ -141,46 +142,34 @@ static void create_callback_stream(struct httpd_state *s)
 }
 
 // Used to save files to SDCARD during upload
-static FILE *fd;
-static char *output_filename = NULL;
-static int file_cnt = 0;
-static int open_file(const char *fn)
+static int open_file(struct httpd_state *s, const char *fn)
 {
-    if (output_filename != NULL) free(output_filename);
-    output_filename = malloc(strlen(fn) + 5);
+    char *output_filename = malloc(strlen(fn) + 5);
+    if (output_filename == NULL) return 0;
     strcpy(output_filename, "/sd/");
     strcat(output_filename, fn);
-    fd = fopen(output_filename, "w");
-    if (fd == NULL) {
-        free(output_filename);
-        output_filename = NULL;
-        return 0;
-    }
-    return 1;
+    s->upload = new_upload_sink(output_filename);
+    free(output_filename);
+    return s->upload != NULL;
 }
 
-static int close_file()
+static int close_file(struct httpd_state *s)
 {
-    free(output_filename);
-    output_filename = NULL;
-    fclose(fd);
-    return 1;
+    int ok = 1;
+    if (s->upload != NULL) {
+        ok = upload_sink_close(s->upload);
+        s->upload = NULL;
+    }
+    return ok;
 }
 
-static int save_file(uint8_t *buf, unsigned int len)
+static int save_file(struct httpd_state *s, uint8_t *buf, unsigned int len)
 {
-    if (fwrite(buf, 1, len, fd) == len) {
-        file_cnt += len;
-        // HACK alert work around bug causing file corruption when writing large amounts of data
-        if (file_cnt >= 400) {
-            file_cnt = 0;
-            fclose(fd);
-            fd = fopen(output_filename, "a");
-        }
+    if (upload_sink_write(s->upload, buf, len)) {
         return 1;
 
     } else {
-        close_file();
+        close_file(s);
         return 0;
     }
 }
@@ -245,6 +234,10 @@ static unsigned short generate_part_of_sd_file(void *state)
 {
     struct httpd_state *s = (struct httpd_state *)state;
 
+    if (uip_rexmit()) {
+        // the last part is being sent again, so read it again
+        fseek(s->fd, -s->len, SEEK_CUR);
+    }
     int len = fread(uip_appdata, 1, uip_mss(), s->fd);
     if (len <= 0) {
         // we need to send something
@@ -424,7 +417,7 @@ static PT_THREAD(handle_uploaded_data(struct httpd_state *s, uint8_t *buf, int l
     DEBUG_PRINTF("Uploading file: %s, %d\n", s->upload_name, s->content_length);
 
     // The body is the raw data to be stored to the file
-    if (!open_file(s->upload_name)) {
+    if (!open_file(s, s->upload_name)) {
         DEBUG_PRINTF("failed to open file\n");
         s->uploadok = 0;
         PT_EXIT(&s->inputpt);
@@ -434,7 +427,7 @@ static PT_THREAD(handle_uploaded_data(struct httpd_state *s, uint8_t *buf, int l
 
     if (len > 0) {
         // write the first part of the buffer
-        if (!save_file(buf, len)) {
+        if (!save_file(s, buf, len)) {
             DEBUG_PRINTF("initial write failed\n");
             s->uploadok = 0;
             PT_EXIT(&s->inputpt);
@@ -454,7 +447,7 @@ static PT_THREAD(handle_uploaded_data(struct httpd_state *s, uint8_t *buf, int l
         //DEBUG_PRINTF("read %d bytes of data\n", readlen);
 
         if (readlen > 0) {
-            if (!save_file(readptr, readlen)) {
+            if (!save_file(s, readptr, readlen)) {
                 DEBUG_PRINTF("write failed\n");
                 s->uploadok = 0;
                 PT_EXIT(&s->inputpt);
@@ -463,7 +456,11 @@ static PT_THREAD(handle_uploaded_data(struct httpd_state *s, uint8_t *buf, int l
         }
     }
 
-    close_file();
+    if (!close_file(s)) {
+        DEBUG_PRINTF("failed to write end of file\n");
+        s->uploadok = 0;
+        PT_EXIT(&s->inputpt);
+    }
     s->uploadok = 1;
     DEBUG_PRINTF("finished upload\n");
 
@@ -637,6 +634,7 @@ httpd_appcall(void)
         /*    timer_set(&s->timer, CLOCK_SECOND * 100);*/
         s->timer = 0;
         s->fd = NULL;
+        s->upload = NULL;
         s->strbuf = NULL;
         s->fifo = NULL;
         s->pstream = NULL;
@@ -661,7 +659,8 @@ httpd_appcall(void)
 
     if (uip_closed() || uip_aborted() || uip_timedout()) {
         DEBUG_PRINTF("Closing connection: %d\n", HTONS(uip_conn->rport));
-        if (s->fd != NULL) fclose(fd); // clean up
+        if (s->fd != NULL) fclose(s->fd); // clean up
+        close_file(s);
         if (s->strbuf != NULL) free(s->strbuf);
         if (s->pstream != NULL) {
             // free these if they were allocated
@@ -50,6 +50,7 @@ struct httpd_state {
   char state;
   struct httpd_fs_file file;
   FILE *fd;
+  void *upload;
   uint16_t len;
   char *strbuf;
   int content_length;
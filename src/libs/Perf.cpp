@@ -0,0 +1,89 @@
+/*
+      This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+      Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+      Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Perf.h"
+
+#ifdef PERF_PROFILING
+
+#include "libs/Kernel.h"
+#include "StreamOutput.h"
+
+#include "system_LPC17xx.h" // for SystemCoreClock
+
+Perf::stat_t Perf::step_tick;
+Perf::stat_t Perf::slow_tick;
+uint32_t Perf::loop_start;
+uint32_t Perf::loop_histogram[PERF_HISTOGRAM_BINS];
+
+// start the cycle counter
+void Perf::init()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT= 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    reset();
+}
+
+void Perf::reset()
+{
+    __disable_irq();
+    step_tick.reset();
+    slow_tick.reset();
+    for (auto& b : loop_histogram) b= 0;
+    loop_start= DWT->CYCCNT;
+    __enable_irq();
+
+    THEKERNEL->reset_event_stats();
+}
+
+// called once per main loop iteration, bins the time since the last call
+void Perf::main_loop()
+{
+    uint32_t now= DWT->CYCCNT;
+    uint32_t us= (now - loop_start) / (SystemCoreClock / 1000000);
+    loop_start= now;
+
+    // bin n holds 2^(n-1) <= us < 2^n
+    int bin= us == 0 ? 0 : 32 - __builtin_clz(us);
+    if(bin >= PERF_HISTOGRAM_BINS) bin= PERF_HISTOGRAM_BINS - 1;
+    ++loop_histogram[bin];
+}
+
+void Perf::print_stat(StreamOutput *stream, const stat_t &s)
+{
+    float cycles_per_us= SystemCoreClock / 1000000.0F;
+    stream->printf("%10lu %10.2f %10.2f %12.1f\n", s.calls, s.calls > 0 ? s.total / (cycles_per_us * s.calls) : 0,
+                   s.max / cycles_per_us, s.total / (cycles_per_us * 1000.0F));
+}
+
+void Perf::print(StreamOutput *stream)
+{
+    THEKERNEL->print_event_stats(stream);
+
+    stat_t st, sl;
+    __disable_irq();
+    st= step_tick;
+    sl= slow_tick;
+    __enable_irq();
+
+    stream->printf("%-12s %10s %10s %10s %12s\n", "interrupt", "calls", "avg us", "max us", "total ms");
+    stream->printf("%-12s ", "step_tick"); print_stat(stream, st);
+    stream->printf("%-12s ", "slow_tick"); print_stat(stream, sl);
+
+    stream->printf("main loop iterations:\n");
+    uint32_t lo= 0;
+    for (int i = 0; i < PERF_HISTOGRAM_BINS; ++i) {
+        uint32_t hi= 1UL << i;
+        if(loop_histogram[i] > 0) {
+            if(i == PERF_HISTOGRAM_BINS - 1) stream->printf("  >= %7lu us: %lu\n", lo, loop_histogram[i]);
+            else stream->printf("  < %8lu us: %lu\n", hi, loop_histogram[i]);
+        }
+        lo= hi;
+    }
+}
+
+#endif
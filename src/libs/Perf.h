@@ -0,0 +1,62 @@
+/*
+      This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+      Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+      Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERF_H
+#define PERF_H
+
+// Optional profiling using the DWT cycle counter, build with PERF=1 to enable it.
+// Times each event handler of each module, the main loop iterations and the step and slow ticker interrupts, see the perf command.
+// When not enabled the macros are empty and nothing is compiled in.
+
+#ifdef PERF_PROFILING
+
+#include "LPC17xx.h"
+#include <stdint.h>
+
+class StreamOutput;
+
+#define PERF_START(t) uint32_t t= DWT->CYCCNT
+#define PERF_END(stat, t) (stat).add(DWT->CYCCNT - (t))
+
+// main loop iteration times are binned by powers of two in microseconds, the last bin holds anything longer
+#define PERF_HISTOGRAM_BINS 20
+
+class Perf {
+    public:
+        // execution time in cycles
+        struct stat_t {
+            uint32_t calls;
+            uint32_t max;
+            uint64_t total;
+
+            void add(uint32_t cycles) { ++calls; total += cycles; if(cycles > max) max= cycles; }
+            void reset() { calls= 0; max= 0; total= 0; }
+        };
+
+        static void init();
+        static void reset();
+        static void print(StreamOutput *stream);
+        static void print_stat(StreamOutput *stream, const stat_t &s);
+
+        static void main_loop();
+
+        static stat_t step_tick;
+        static stat_t slow_tick;
+
+    private:
+        static uint32_t loop_start;
+        static uint32_t loop_histogram[PERF_HISTOGRAM_BINS];
+};
+
+#else
+
+#define PERF_START(t)
+#define PERF_END(stat, t)
+
+#endif
+
+#endif
@@ -1,5 +1,7 @@
 #include "Pin.h"
 #include "utils.h"
+#include "Kernel.h"
+#include "StreamOutputPool.h"
 
 // mbed libraries for hardware pwm
 #include "PwmOut.h"
@@ -163,33 +165,50 @@ Pin* Pin::pull_down(){
     return this;
 }
 
-// If available on this pin, return mbed hardware pwm class for this pin
-mbed::PwmOut* Pin::hardware_pwm()
+uint32_t Pin::pwm_period_us= 0;
+
+// If available on this pin, return mbed hardware pwm class for this pin, running at period_us
+// All the PWM1 channels share one period, so once one is in use a pin that asks for another period is refused rather
+// than changing it under the outputs already using it
+mbed::PwmOut* Pin::hardware_pwm(uint32_t period_us)
 {
+    PinName pn = NC;
     if (port_number == 1)
     {
-        if (pin == 18) { return new mbed::PwmOut(P1_18); }
-        if (pin == 20) { return new mbed::PwmOut(P1_20); }
-        if (pin == 21) { return new mbed::PwmOut(P1_21); }
-        if (pin == 23) { return new mbed::PwmOut(P1_23); }
-        if (pin == 24) { return new mbed::PwmOut(P1_24); }
-        if (pin == 26) { return new mbed::PwmOut(P1_26); }
+        if (pin == 18) { pn = P1_18; }
+        if (pin == 20) { pn = P1_20; }
+        if (pin == 21) { pn = P1_21; }
+        if (pin == 23) { pn = P1_23; }
+        if (pin == 24) { pn = P1_24; }
+        if (pin == 26) { pn = P1_26; }
     }
     else if (port_number == 2)
     {
-        if (pin == 0) { return new mbed::PwmOut(P2_0); }
-        if (pin == 1) { return new mbed::PwmOut(P2_1); }
-        if (pin == 2) { return new mbed::PwmOut(P2_2); }
-        if (pin == 3) { return new mbed::PwmOut(P2_3); }
-        if (pin == 4) { return new mbed::PwmOut(P2_4); }
-        if (pin == 5) { return new mbed::PwmOut(P2_5); }
+        if (pin == 0) { pn = P2_0; }
+        if (pin == 1) { pn = P2_1; }
+        if (pin == 2) { pn = P2_2; }
+        if (pin == 3) { pn = P2_3; }
+        if (pin == 4) { pn = P2_4; }
+        if (pin == 5) { pn = P2_5; }
     }
     else if (port_number == 3)
     {
-        if (pin == 25) { return new mbed::PwmOut(P3_25); }
-        if (pin == 26) { return new mbed::PwmOut(P3_26); }
+        if (pin == 25) { pn = P3_25; }
+        if (pin == 26) { pn = P3_26; }
+    }
+
+    if (pn == NC) return nullptr;
+
+    if (pwm_period_us != 0 && pwm_period_us != period_us) {
+        THEKERNEL->streams->printf("WARNING: PWM hardware is already in use with a period of %luus, P%d.%d needs %luus\n", pwm_period_us, port_number, pin, period_us);
+        return nullptr;
     }
-    return nullptr;
+
+    // a new PwmOut puts the period back to the mbed default, so it is set again even when it is the same
+    mbed::PwmOut *p = new mbed::PwmOut(pn);
+    p->period_us(period_us);
+    pwm_period_us = period_us;
+    return p;
 }
 
 mbed::InterruptIn* Pin::interrupt_pin()
@@ -200,8 +219,16 @@ mbed::InterruptIn* Pin::interrupt_pin()
     as_input();
 
     if (port_number == 0 || port_number == 2) {
+        // InterruptIn sets the pin to pull down, so keep the pull mode it was configured with
+        volatile uint32_t *pinmode= (port_number == 2) ? &LPC_PINCON->PINMODE4 : (pin < 16) ? &LPC_PINCON->PINMODE0 : &LPC_PINCON->PINMODE1;
+        int shift= (pin % 16) * 2;
+        uint32_t mode= *pinmode & (3 << shift);
+
         PinName pinname = port_pin((PortName)port_number, pin);
-        return new mbed::InterruptIn(pinname);
+        mbed::InterruptIn *ip= new mbed::InterruptIn(pinname);
+
+        *pinmode= (*pinmode & ~(3 << shift)) | mode;
+        return ip;
 
     }else{
         this->valid= false;
@@ -2,6 +2,7 @@
 #define PIN_H
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
 
@@ -63,7 +64,7 @@ class Pin {
                 this->port->FIOCLR = 1 << this->pin;
         }
 
-        mbed::PwmOut *hardware_pwm();
+        mbed::PwmOut *hardware_pwm(uint32_t period_us);
 
         mbed::InterruptIn *interrupt_pin();
 
@@ -77,6 +78,8 @@ class Pin {
         char port_number;
 
     private:
+        static uint32_t pwm_period_us; // of the PWM1 hardware, shared by all its channels, 0 until one is used
+
         struct {
             bool inverting:1;
             bool valid:1;
@@ -2,12 +2,43 @@
 #include "PublicData.h"
 #include "PublicDataRequest.h"
 
+std::vector<PublicData::handler_t> PublicData::handlers;
+
+void PublicData::register_handler(_EVENT_ENUM id_event, Module *module, uint16_t csa, uint16_t csb, uint16_t csc)
+{
+    handlers.push_back({module, {csa, csb, csc}, id_event});
+}
+
+void PublicData::unregister_handlers(Module *module)
+{
+    for (auto i = handlers.begin(); i != handlers.end(); ) {
+        if(i->module == module) i= handlers.erase(i);
+        else ++i;
+    }
+}
+
+// hand the request to every module registered for it, like the broadcast more than one may answer (eg poll_controls)
+void PublicData::dispatch(_EVENT_ENUM id_event, PublicDataRequest &pdr)
+{
+    for(auto& h : handlers) {
+        if(h.id_event != id_event) continue;
+        if(!pdr.starts_with(h.cs[0])) continue;
+        if(h.cs[1] != 0 && !pdr.second_element_is(h.cs[1])) continue;
+        if(h.cs[2] != 0 && !pdr.third_element_is(h.cs[2])) continue;
+        (h.module->*kernel_callback_functions[id_event])(&pdr);
+    }
+}
+
 bool PublicData::get_value(uint16_t csa, uint16_t csb, uint16_t csc, void *data) {
     PublicDataRequest pdr(csa, csb, csc);
     // the caller may have created the storage for the returned data so we clear the flag,
     // if it gets set by the callee setting the data ptr that means the data is a pointer to a pointer and is set to a pointer to the returned data
     pdr.set_data_ptr(data, false);
-    THEKERNEL->call_event(ON_GET_PUBLIC_DATA, &pdr );
+    dispatch(ON_GET_PUBLIC_DATA, pdr);
+    if(!pdr.is_taken()) {
+        // nothing registered for it took it so ask everyone
+        THEKERNEL->call_event(ON_GET_PUBLIC_DATA, &pdr );
+    }
     if(pdr.is_taken() && pdr.has_returned_data()) {
         // the callee set the returned data pointer
         *(void**)data= pdr.get_data_ptr();
@@ -18,6 +49,9 @@ bool PublicData::get_value(uint16_t csa, uint16_t csb, uint16_t csc, void *data)
 bool PublicData::set_value(uint16_t csa, uint16_t csb, uint16_t csc, void *data) {
     PublicDataRequest pdr(csa, csb, csc);
     pdr.set_data_ptr(data);
-    THEKERNEL->call_event(ON_SET_PUBLIC_DATA, &pdr );
+    dispatch(ON_SET_PUBLIC_DATA, pdr);
+    if(!pdr.is_taken()) {
+        THEKERNEL->call_event(ON_SET_PUBLIC_DATA, &pdr );
+    }
     return pdr.is_taken();
 }
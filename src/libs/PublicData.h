@@ -8,6 +8,13 @@
 #ifndef PUBLICDATA_H
 #define PUBLICDATA_H
 
+#include "Module.h"
+
+#include <stdint.h>
+#include <vector>
+
+class PublicDataRequest;
+
 class PublicData {
     public:
         // there are two ways to get data from a module
@@ -23,6 +30,23 @@ class PublicData {
         static bool set_value(uint16_t csa, uint16_t csb, void *data) { return set_value(csa, csb, 0, data); }
         static bool set_value(uint16_t cs[3], void *data) { return set_value(cs[0], cs[1], cs[2], data); }
         static bool set_value(uint16_t csa, uint16_t csb, uint16_t csc, void *data);
+
+        // A module that answers requests can register the checksums it answers to, requests that match are then handed
+        // straight to it instead of being broadcast to every module. A checksum of 0 matches anything in that position.
+        // If none of the registered modules take the request it is broadcast as before, so modules that do not register
+        // still work, they must still register for ON_GET_PUBLIC_DATA/ON_SET_PUBLIC_DATA.
+        static void register_handler(_EVENT_ENUM id_event, Module *module, uint16_t csa, uint16_t csb= 0, uint16_t csc= 0);
+        static void unregister_handlers(Module *module);
+
+    private:
+        struct handler_t {
+            Module *module;
+            uint16_t cs[3];
+            _EVENT_ENUM id_event;
+        };
+
+        static void dispatch(_EVENT_ENUM id_event, PublicDataRequest &pdr);
+        static std::vector<handler_t> handlers;
 };
 
 #endif
@@ -1,6 +1,9 @@
 #include "Pwm.h"
 
 #include "utils.h"
+#include "PwmOut.h" // mbed.h lib
+
+#include <math.h>
 
 #define PID_PWM_MAX 256
 
@@ -12,17 +15,43 @@ Pwm::Pwm()
     _pwm = -1;
     _sd_direction= false;
     _sd_accumulator= 0;
+    _hw_pwm= nullptr;
+}
+
+// Drive the output from one of the PWM1 match channels instead of the sigma-delta on_tick, if the pin is PWM capable
+// and the PWM hardware is free to run at this frequency. This takes the output off the SlowTicker
+bool Pwm::use_hardware(float frequency)
+{
+    mbed::PwmOut *p= hardware_pwm(roundf(1000000.0F / frequency));
+    if(p == nullptr) return false;
+
+    _hw_pwm= p;
+    write_hardware(_pwm > 0 ? duty(_pwm) : 0);
+    return true;
+}
+
+// the same duty cycle the sigma-delta on_tick gives, which is on for pwm out of 256 and fully on at the top value
+float Pwm::duty(int pwm)
+{
+    return pwm >= PID_PWM_MAX - 1 ? 1.0F : (float)pwm / PID_PWM_MAX;
+}
+
+void Pwm::write_hardware(float duty)
+{
+    // the PWM hardware knows nothing about inverted pins
+    _hw_pwm->write(is_inverting() ? 1.0F - duty : duty);
 }
 
 void Pwm::pwm(int new_pwm)
 {
     _pwm = confine(new_pwm, 0, _max);
+    if(_hw_pwm != nullptr) write_hardware(duty(_pwm));
 }
 
 Pwm* Pwm::max_pwm(int new_max)
 {
     _max = confine(new_max, 0, PID_PWM_MAX - 1);
-    _pwm = confine(   _pwm, 0, _max);
+    pwm(_pwm);
     return this;
 }
 
@@ -34,12 +63,16 @@ int Pwm::max_pwm()
 void Pwm::set(bool value)
 {
     _pwm = -1;
-    Pin::set(value);
+    if(_hw_pwm != nullptr) {
+        write_hardware(value ? 1.0F : 0.0F);
+    }else{
+        Pin::set(value);
+    }
 }
 
 uint32_t Pwm::on_tick(uint32_t dummy)
 {
-    if ((_pwm < 0) || _pwm >= PID_PWM_MAX) {
+    if ((_pwm < 0) || _pwm >= PID_PWM_MAX || _hw_pwm != nullptr) {
         return dummy;
     }
     else if (_pwm == 0) {
@@ -6,6 +6,10 @@
 #include "Pin.h"
 #include "Module.h"
 
+namespace mbed {
+    class PwmOut;
+}
+
 class Pwm : public Module, public Pin {
 public:
     Pwm();
@@ -20,7 +24,14 @@ public:
     int      get_pwm() const { return _pwm; }
     void     set(bool);
 
+    bool     use_hardware(float frequency);
+    bool     is_hardware() const { return _hw_pwm != nullptr; }
+
 private:
+    static float duty(int pwm);
+    void write_hardware(float duty);
+
+    mbed::PwmOut *_hw_pwm;
     int  _max;
     int  _pwm;
     int  _sd_accumulator;
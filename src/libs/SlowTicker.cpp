@@ -12,17 +12,28 @@ using namespace std;
 #include "libs/Kernel.h"
 #include "SlowTicker.h"
 #include "StepTicker.h"
+#include "Perf.h"
 #include "libs/Hook.h"
 #include "modules/robot/Conveyor.h"
 #include "Gcode.h"
 
+#include "StreamOutput.h"
+
 #include <mri.h>
+#include <algorithm>
 
-// This module uses a Timer to periodically call hooks
+// This module uses a Timer to call hooks at their requested frequency
 // Modules register with a function ( callback ) and a frequency, and we then call that function at the given frequency.
+// The timer free runs and the match register is set to the earliest hook deadline, so we only interrupt when a hook is due.
 
 SlowTicker* global_slow_ticker;
 
+// heap ordering, the hook with the earliest deadline ends up at the front, handles the timer wrapping
+static bool deadline_after(const Hook *a, const Hook *b)
+{
+    return (int32_t)(a->deadline - b->deadline) > 0;
+}
+
 SlowTicker::SlowTicker(){
     global_slow_ticker = this;
 
@@ -30,13 +41,17 @@ SlowTicker::SlowTicker(){
     ispbtn.from_string("2.10")->as_input()->pull_up();
 
     LPC_SC->PCONP |= (1 << 22);     // Power Ticker ON
-    LPC_TIM2->MCR = 3;              // Match on MR0, reset on MR0
+    LPC_TIM2->MCR = 1;              // Match on MR0, free running
     // do not enable interrupt until setup is complete
-    LPC_TIM2->TCR = 0;              // Disable interrupt
+    LPC_TIM2->TCR = 2;              // Reset and hold
 
-    max_frequency = 5;  // initial max frequency is set to 5Hz
-    set_frequency(max_frequency);
+    last_entry= 0;
+    elapsed_ticks= 0;
+    isr_ticks= 0;
     flag_1s_flag = 0;
+
+    // counts seconds for the on_second_tick event
+    attach(1, this, &SlowTicker::second_tick);
 }
 
 void SlowTicker::start()
@@ -49,44 +64,71 @@ void SlowTicker::on_module_loaded(){
     register_for_event(ON_IDLE);
 }
 
-// Set the base frequency we use for all sub-frequencies
-void SlowTicker::set_frequency( int frequency ){
-    this->interval = (SystemCoreClock >> 2) / frequency;   // SystemCoreClock/4 = Timer increments in a second
-    LPC_TIM2->MR0 = this->interval;
-    LPC_TIM2->TCR = 3;  // Reset
-    LPC_TIM2->TCR = 1;  // Reset
-    flag_1s_count= SystemCoreClock>>2;
+void SlowTicker::add_hook(Hook *hook)
+{
+    // to avoid race conditions we must stop the interupts before updating this non thread safe heap
+    __disable_irq();
+    hook->deadline = LPC_TIM2->TC + hook->interval;
+    this->hooks.push_back(hook);
+    std::push_heap(this->hooks.begin(), this->hooks.end(), deadline_after);
+    schedule_next();
+    __enable_irq();
 }
 
-// The actual interrupt being called by the timer, this is where work is done
-void SlowTicker::tick(){
+// set the match register to the earliest deadline, must be called with the timer interrupt blocked
+void SlowTicker::schedule_next()
+{
+    LPC_TIM2->MR0 = this->hooks.front()->deadline;
 
-    // Call all hooks that need to be called
-    for (Hook* hook : this->hooks){
-        hook->countdown -= this->interval;
-        if (hook->countdown < 0)
-        {
-            hook->countdown += hook->interval;
-            hook->call();
-        }
+    // if it became due while we were setting it, the match will not happen until the timer wraps, so force it
+    if((int32_t)(LPC_TIM2->TC - LPC_TIM2->MR0) >= 0) {
+        NVIC_SetPendingIRQ(TIMER2_IRQn);
     }
+}
 
-    // deduct tick time from second counter
-    flag_1s_count -= this->interval;
-    // if a whole second has elapsed,
-    if (flag_1s_count < 0)
-    {
-        // add a second to our counter
-        flag_1s_count += SystemCoreClock >> 2;
-        // and set a flag for idle event to pick up
-        flag_1s_flag++;
+// The actual interrupt being called by the timer, this is where work is done
+void SlowTicker::tick(){
+    uint32_t entry= LPC_TIM2->TC;
+    elapsed_ticks += entry - last_entry;
+    last_entry= entry;
+
+    // Call the hooks that are due, they are ordered by deadline so we can stop at the first one that is not
+    for(;;) {
+        Hook *hook= this->hooks.front();
+        uint32_t now= LPC_TIM2->TC;
+        int32_t late= now - hook->deadline;
+        if(late < 0) break;
+
+        std::pop_heap(this->hooks.begin(), this->hooks.end(), deadline_after);
+        hook->call();
+        uint32_t exec= LPC_TIM2->TC - now;
+
+        hook->calls++;
+        hook->total_exec += exec;
+        if(exec > hook->max_exec) hook->max_exec= exec;
+        if((uint32_t)late > hook->max_jitter) hook->max_jitter= late;
+
+        // if we fell a whole interval behind skip the missed calls rather than calling it back to back
+        hook->deadline += hook->interval;
+        if((int32_t)(now - hook->deadline) >= 0) hook->deadline= now + hook->interval;
+        std::push_heap(this->hooks.begin(), this->hooks.end(), deadline_after);
     }
 
+    schedule_next();
+
     // Enter MRI mode if the ISP button is pressed
     // TODO: This should have it's own module
     if (ispbtn.get() == 0)
         __debugbreak();
 
+    isr_ticks += LPC_TIM2->TC - entry;
+}
+
+// set a flag for idle event to pick up every second
+uint32_t SlowTicker::second_tick(uint32_t)
+{
+    flag_1s_flag++;
+    return 0;
 }
 
 bool SlowTicker::flag_1s(){
@@ -124,10 +166,61 @@ void SlowTicker::on_idle(void*)
         THEKERNEL->call_event(ON_SECOND_TICK);
 }
 
+// print the per hook execution time and jitter, and the total time spent in the ISR
+void SlowTicker::print_stats(StreamOutput *stream)
+{
+    struct hook_stats_t {
+        uint32_t interval;
+        uint32_t calls;
+        uint32_t max_exec;
+        uint32_t max_jitter;
+        uint64_t total_exec;
+    };
+
+    // take a snapshot so the ISR does not change things while we print
+    vector<hook_stats_t> stats;
+    stats.reserve(hooks.size());
+    uint64_t isr, elapsed;
+    __disable_irq();
+    for(Hook *h : hooks) {
+        stats.push_back({h->interval, h->calls, h->max_exec, h->max_jitter, h->total_exec});
+    }
+    isr= isr_ticks;
+    elapsed= elapsed_ticks;
+    __enable_irq();
+
+    // show the fastest hooks first
+    std::sort(stats.begin(), stats.end(), [](const hook_stats_t& a, const hook_stats_t& b) { return a.interval < b.interval; });
+
+    float ticks_per_us= (SystemCoreClock >> 2) / 1000000.0F;
+    stream->printf("SlowTicker hooks: %u, ISR load: %1.2f%% over %1.1f secs\n", stats.size(), elapsed > 0 ? 100.0F * isr / elapsed : 0, elapsed / (ticks_per_us * 1000000.0F));
+    stream->printf("    Hz      calls   avg us   max us  max late us\n");
+    for(auto& h : stats) {
+        stream->printf("%6lu %10lu %8.2f %8.2f %12.2f\n", (SystemCoreClock >> 2) / h.interval, h.calls,
+                       h.calls > 0 ? h.total_exec / (ticks_per_us * h.calls) : 0, h.max_exec / ticks_per_us, h.max_jitter / ticks_per_us);
+    }
+}
+
+void SlowTicker::reset_stats()
+{
+    __disable_irq();
+    for(Hook *h : hooks) {
+        h->calls= 0;
+        h->max_exec= 0;
+        h->max_jitter= 0;
+        h->total_exec= 0;
+    }
+    isr_ticks= 0;
+    elapsed_ticks= 0;
+    __enable_irq();
+}
+
 extern "C" void TIMER2_IRQHandler (void){
     if((LPC_TIM2->IR >> 0) & 1){  // If interrupt register set for MR0
         LPC_TIM2->IR |= 1 << 0;   // Reset it
     }
+    PERF_START(t);
     global_slow_ticker->tick();
+    PERF_END(Perf::slow_tick, t);
 }
 
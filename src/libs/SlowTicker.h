@@ -21,6 +21,8 @@ using namespace std;
 #include "system_LPC17xx.h" // for SystemCoreClock
 #include <math.h>
 
+class StreamOutput;
+
 class SlowTicker : public Module{
     public:
         SlowTicker();
@@ -28,7 +30,6 @@ class SlowTicker : public Module{
         void on_module_loaded(void);
         void on_idle(void*);
         void start();
-        void set_frequency( int frequency );
         void tick();
         // For some reason this can't go in the .cpp, see :  http://mbed.org/forum/mbed/topic/2774/?page=1#comment-14221
         // TODO replace this with std::function()
@@ -36,29 +37,29 @@ class SlowTicker : public Module{
             Hook* hook = new Hook();
             hook->interval = floorf((SystemCoreClock/4)/frequency);
             hook->attach(optr, fptr);
-            hook->countdown = hook->interval;
-
-            // to avoid race conditions we must stop the interupts before updating this non thread safe vector
-            __disable_irq();
-            if( frequency > this->max_frequency ){
-                this->max_frequency = frequency;
-                this->set_frequency(frequency);
-            }
-            this->hooks.push_back(hook);
-            __enable_irq();
+            add_hook(hook);
             return hook;
         }
 
+        void print_stats(StreamOutput *stream);
+        void reset_stats();
+
     private:
+        void add_hook(Hook *hook);
+        void schedule_next();
+        uint32_t second_tick(uint32_t);
         bool flag_1s();
 
+        // min-heap of the hooks ordered by deadline, so the ISR only has to look at the ones that are due
         vector<Hook*> hooks;
-        uint32_t max_frequency;
-        uint32_t interval;
+
+        // statistics in timer ticks
+        uint32_t last_entry;
+        uint64_t elapsed_ticks;
+        uint64_t isr_ticks;
 
         Pin ispbtn;
 protected:
-    int flag_1s_count;
     volatile int flag_1s_flag;
 };
 
@@ -7,6 +7,7 @@
 
 
 #include "StepTicker.h"
+#include "Perf.h"
 
 #include "libs/nuts_bolts.h"
 #include "libs/Module.h"
@@ -33,19 +34,10 @@ StepTicker *StepTicker::instance;
 
 StepTicker::StepTicker()
 {
-    instance = this; // setup the Singleton instance of the stepticker
+    // setup the Singleton instance of the stepticker, a second one (eg in a unit test) leaves the real one alone
+    if(instance == nullptr) instance = this;
 
-    // Configure the timer
-    LPC_TIM0->MR0 = 10000000;       // Initial dummy value for Match Register
-    LPC_TIM0->MCR = 3;              // Match on MR0, reset on MR0
-    LPC_TIM0->TCR = 0;              // Disable interrupt
-
-    LPC_SC->PCONP |= (1 << 2);      // Power Ticker ON
-    LPC_TIM1->MR0 = 1000000;
-    LPC_TIM1->MCR = 5;              // match on Mr0, stop on match
-    LPC_TIM1->TCR = 0;              // Disable interrupt
-
-    // Default start values
+    // Default start values, the timers are not touched until start()
     this->set_frequency(100000);
     this->set_unstep_time(100);
 
@@ -64,11 +56,23 @@ StepTicker::StepTicker()
 
 StepTicker::~StepTicker()
 {
+    if(instance == this) instance = nullptr;
 }
 
 //called when everything is setup and interrupts can start
 void StepTicker::start()
 {
+    // Configure the timers
+    LPC_TIM0->MR0 = this->period;
+    LPC_TIM0->MCR = 3;              // Match on MR0, reset on MR0
+    LPC_TIM0->TCR = 3;              // Reset
+    LPC_TIM0->TCR = 1;              // start
+
+    LPC_SC->PCONP |= (1 << 2);      // Power Ticker ON
+    LPC_TIM1->MR0 = this->unstep_delay;
+    LPC_TIM1->MCR = 5;              // match on Mr0, stop on match
+    LPC_TIM1->TCR = 0;              // Disable interrupt
+
     NVIC_EnableIRQ(TIMER0_IRQn);     // Enable interrupt handler
     NVIC_EnableIRQ(TIMER1_IRQn);     // Enable interrupt handler
     current_tick= 0;
@@ -79,16 +83,12 @@ void StepTicker::set_frequency( float frequency )
 {
     this->frequency = frequency;
     this->period = floorf((SystemCoreClock / 4.0F) / frequency); // SystemCoreClock/4 = Timer increments in a second
-    LPC_TIM0->MR0 = this->period;
-    LPC_TIM0->TCR = 3;  // Reset
-    LPC_TIM0->TCR = 1;  // start
 }
 
 // Set the reset delay, must be called after set_frequency
 void StepTicker::set_unstep_time( float microseconds )
 {
-    uint32_t delay = floorf((SystemCoreClock / 4.0F) * (microseconds / 1000000.0F)); // SystemCoreClock/4 = Timer increments in a second
-    LPC_TIM1->MR0 = delay;
+    this->unstep_delay = floorf((SystemCoreClock / 4.0F) * (microseconds / 1000000.0F)); // SystemCoreClock/4 = Timer increments in a second
 
     // TODO check that the unstep time is less than the step period, if not slow down step ticker
 }
@@ -115,7 +115,9 @@ extern "C" void TIMER0_IRQHandler (void)
 {
     // Reset interrupt register
     LPC_TIM0->IR |= 1 << 0;
+    PERF_START(t);
     StepTicker::getInstance()->step_tick();
+    PERF_END(Perf::step_tick, t);
 }
 
 extern "C" void PendSV_Handler(void)
@@ -153,6 +155,51 @@ void StepTicker::step_tick (void)
         return;
     }
 
+    bool still_moving= step_motors();
+
+    // We may have set a pin on in this tick, now we reset the timer to set it off
+    // Note there could be a race here if we run another tick before the unsteps have happened,
+    // right now it takes about 3-4us but if the unstep were near 10uS or greater it would be an issue
+    // also it takes at least 2us to get here so even when set to 1us pulse width it will still be about 3us
+    if( unstep.any()) {
+        LPC_TIM1->TCR = 3;
+        LPC_TIM1->TCR = 1;
+    }
+
+    // eg endstops confirming a pin interrupt, a motor it stops is seen on the next tick
+    if(tick_fnc) tick_fnc();
+
+    // see if any motors are still moving
+    if(!still_moving) {
+        //SET_STEPTICKER_DEBUG_PIN(0);
+
+        // all moves finished
+        current_tick = 0;
+
+        if(current_block->advance_motor >= 0) finish_advance();
+
+        // get next block
+        // do it here so there is no delay in ticks
+        THECONVEYOR->block_finished();
+
+        if(THECONVEYOR->get_next_block(&current_block)) { // returns false if no new block is available
+            running= start_next_block(); // returns true if there is at least one motor with steps to issue
+
+        }else{
+            current_block= nullptr;
+            running= false;
+        }
+
+        // all moves finished
+        // we delegate the slow stuff to the pendsv handler which will run as soon as this interrupt exits
+        //NVIC_SetPendingIRQ(PendSV_IRQn); this doesn't work
+        //SCB->ICSR = 0x10000000; // SCB_ICSR_PENDSVSET_Msk;
+    }
+}
+
+// one tick of the current block, returns true if any motor holding the block open is still moving
+bool StepTicker::step_motors()
+{
     bool still_moving= false;
     // foreach motor, if it is active see if time to issue a step to that motor
     for (uint8_t m = 0; m < num_motors; m++) {
@@ -185,6 +232,13 @@ void StepTicker::step_tick (void)
 
         current_block->tick_info[m].counter += current_block->tick_info[m].steps_per_tick;
 
+        if(m == current_block->advance_motor) {
+            // pressure advance, the extra rate follows the phase of the trapezoid, optionally smoothed
+            current_block->tick_info[m].counter += motor[m]->advance_tick(current_block->get_advance_target(current_tick));
+            // while it is held back it does not step, but do not let the counter run away
+            if(current_block->tick_info[m].counter < -STEPTICKER_FPSCALE) current_block->tick_info[m].counter = -STEPTICKER_FPSCALE;
+        }
+
         if(current_block->tick_info[m].counter >= STEPTICKER_FPSCALE) { // >= 1.0 step time
             current_block->tick_info[m].counter -= STEPTICKER_FPSCALE; // -= 1.0F;
             ++current_block->tick_info[m].step_count;
@@ -201,47 +255,43 @@ void StepTicker::step_tick (void)
             }
         }
 
-        // see if any motors are still moving after this tick
-        if(motor[m]->is_moving()) still_moving= true;
+        // see if any motors are still moving after this tick, an advanced extruder does not hold up the block
+        if(motor[m]->is_moving() && m != current_block->advance_motor) still_moving= true;
     }
 
     // do this after so we start at tick 0
     current_tick++; // count number of ticks
 
-    // We may have set a pin on in this tick, now we reset the timer to set it off
-    // Note there could be a race here if we run another tick before the unsteps have happened,
-    // right now it takes about 3-4us but if the unstep were near 10uS or greater it would be an issue
-    // also it takes at least 2us to get here so even when set to 1us pulse width it will still be about 3us
-    if( unstep.any()) {
-        LPC_TIM1->TCR = 3;
-        LPC_TIM1->TCR = 1;
-    }
-
-
-    // see if any motors are still moving
-    if(!still_moving) {
-        //SET_STEPTICKER_DEBUG_PIN(0);
-
-        // all moves finished
-        current_tick = 0;
-
-        // get next block
-        // do it here so there is no delay in ticks
-        THECONVEYOR->block_finished();
-
-        if(THECONVEYOR->get_next_block(&current_block)) { // returns false if no new block is available
-            running= start_next_block(); // returns true if there is at least one motor with steps to issue
+    return still_moving;
+}
 
-        }else{
-            current_block= nullptr;
-            running= false;
-        }
+// steps a whole block through the same path as the step tick ISR, but without the timers or the conveyor
+// only for use when the ticker has not been started, eg by the unit tests
+void StepTicker::run_block(Block *block)
+{
+    current_block= block;
+    if(start_next_block()) {
+        while(step_motors()) ;
+        if(current_block->advance_motor >= 0) finish_advance();
+    }
+    current_block= nullptr;
+    current_tick= 0;
+    unstep.reset();
+}
 
-        // all moves finished
-        // we delegate the slow stuff to the pendsv handler which will run as soon as this interrupt exits
-        //NVIC_SetPendingIRQ(PendSV_IRQn); this doesn't work
-        //SCB->ICSR = 0x10000000; // SCB_ICSR_PENDSVSET_Msk;
+// called from the main loop, the block and tick can change under us but the answer is only a hint so that does not matter
+StepTicker::MOTION_PHASE StepTicker::get_motion_phase() const
+{
+    const Block *block= current_block;
+    if(!running || block == nullptr) {
+        // anything queued and not yet finished is about to start by accelerating
+        return THECONVEYOR->is_position_reached(THECONVEYOR->get_queue_position()) ? PHASE_IDLE : PHASE_ACCELERATE;
     }
+
+    uint32_t tick= current_tick;
+    if(tick < block->accelerate_until) return PHASE_ACCELERATE;
+    if(tick < block->decelerate_after) return PHASE_CRUISE;
+    return PHASE_DECELERATE;
 }
 
 // only called from the step tick ISR (single consumer)
@@ -249,6 +299,14 @@ bool StepTicker::start_next_block()
 {
     if(current_block == nullptr) return false;
 
+    if(current_block->advance_motor >= 0) {
+        // the extruder has to end this block with the advance planned for its exit, so take up the difference
+        // between that and the advance it actually has now
+        uint8_t m= current_block->advance_motor;
+        int32_t steps= current_block->tick_info[m].steps_to_move + current_block->advance_steps - motor[m]->get_advance_offset();
+        current_block->tick_info[m].steps_to_move= steps > 0 ? steps : 0;
+    }
+
     bool ok= false;
     // need to prepare each active motor
     for (uint8_t m = 0; m < num_motors; m++) {
@@ -278,6 +336,18 @@ bool StepTicker::start_next_block()
 }
 
 
+// only called from the step tick ISR when a block with pressure advance finishes
+// the extruder may be short of or ahead of its planned steps, whatever is left is carried into the next advanced block
+void StepTicker::finish_advance()
+{
+    uint8_t m= current_block->advance_motor;
+    if(motor[m]->is_moving()) {
+        current_block->tick_info[m].steps_to_move = 0;
+        motor[m]->stop_moving();
+    }
+    motor[m]->add_advance_offset((int32_t)current_block->tick_info[m].step_count - (int32_t)current_block->steps[m]);
+}
+
 // returns index of the stepper motor in the array and bitset
 int StepTicker::register_motor(StepperMotor* m)
 {
@@ -33,26 +33,38 @@ class StepTicker{
         void set_frequency( float frequency );
         void set_unstep_time( float microseconds );
         int register_motor(StepperMotor* motor);
+        StepperMotor *get_motor(uint8_t m) const { return m < num_motors ? motor[m] : nullptr; }
         float get_frequency() const { return frequency; }
         void unstep_tick();
         const Block *get_current_block() const { return current_block; }
 
+        // which part of its trapezoid the block being stepped is in, for things that follow the motion from the main loop
+        enum MOTION_PHASE { PHASE_IDLE, PHASE_ACCELERATE, PHASE_CRUISE, PHASE_DECELERATE };
+        MOTION_PHASE get_motion_phase() const;
+
         void step_tick (void);
         void handle_finish (void);
         void start();
+        void run_block(Block *block);
 
         // whatever setup the block should register this to know when it is done
         std::function<void()> finished_fnc{nullptr};
 
+        // called on every tick of a block when set, set it before the ticker is started
+        std::function<void()> tick_fnc{nullptr};
+
         static StepTicker *getInstance() { return instance; }
 
     private:
         static StepTicker *instance;
 
         bool start_next_block();
+        bool step_motors();
+        void finish_advance();
 
         float frequency;
         uint32_t period;
+        uint32_t unstep_delay;
         std::array<StepperMotor*, k_max_actuators> motor;
         std::bitset<k_max_actuators> unstep;
 
@@ -27,6 +27,11 @@ StepperMotor::StepperMotor(Pin &step, Pin &dir, Pin &en) : step_pin(step), dir_p
     acceleration= NAN;
     selected= true;
     extruder= false;
+    pressure_advance= 0;
+    advance_smoothing_time= 0;
+    advance_offset= 0;
+    advance_rate= 0;
+    advance_smoothing= 0;
 
     enable(false);
     unstep(); // initialize step pin
@@ -47,6 +52,8 @@ void StepperMotor::on_halt(void *argument)
     if(argument == nullptr) {
         enable(false);
         moving= false;
+        advance_offset= 0;
+        advance_rate= 0;
     }
 }
 
@@ -68,6 +75,7 @@ void StepperMotor::change_steps_per_mm(float new_steps)
     steps_per_mm = new_steps;
     last_milestone_steps = lroundf(last_milestone_mm * steps_per_mm);
     current_position_steps = last_milestone_steps;
+    advance_offset= 0;
 }
 
 void StepperMotor::change_last_milestone(float new_milestone)
@@ -75,6 +83,7 @@ void StepperMotor::change_last_milestone(float new_milestone)
     last_milestone_mm = new_milestone;
     last_milestone_steps = lroundf(last_milestone_mm * steps_per_mm);
     current_position_steps = last_milestone_steps;
+    advance_offset= 0;
 }
 
 void StepperMotor::set_last_milestones(float mm, int32_t steps)
@@ -82,6 +91,21 @@ void StepperMotor::set_last_milestones(float mm, int32_t steps)
     last_milestone_mm= mm;
     last_milestone_steps= steps;
     current_position_steps= last_milestone_steps;
+    advance_offset= 0;
+}
+
+// k is the pressure advance in seconds (extra steps = k * steps/sec), 0 disables it
+// smoothing is the time constant in seconds of the filter applied to the extra rate, 0 is no smoothing
+void StepperMotor::set_pressure_advance(float k, float smoothing)
+{
+    pressure_advance= k;
+    advance_smoothing_time= smoothing;
+
+    // the filter is done with a shift in the step ticker so round the time constant to a power of two ticks
+    uint8_t shift= 0;
+    float ticks= smoothing * THEKERNEL->step_ticker->get_frequency();
+    while(shift < 20 && (1 << (shift + 1)) <= ticks) ++shift;
+    advance_smoothing= shift;
 }
 
 void StepperMotor::update_last_milestones(float mm, int32_t steps)
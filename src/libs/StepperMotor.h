@@ -12,6 +12,7 @@
 
 class StepperMotor  : public Module {
     public:
+
         StepperMotor(Pin& step, Pin& dir, Pin& en);
         ~StepperMotor();
 
@@ -24,6 +25,11 @@ class StepperMotor  : public Module {
         inline void unstep() { step_pin.set(0); }
         // called from step ticker ISR
         inline void set_direction(bool f) { dir_pin.set(f); direction= f; }
+        // called from step ticker ISR, moves the extra pressure advance rate towards target and returns it
+        inline int32_t advance_tick(int32_t target) { advance_rate += (target - advance_rate) >> advance_smoothing; return advance_rate; }
+        // called from step ticker ISR
+        int32_t get_advance_offset() const { return advance_offset; }
+        void add_advance_offset(int32_t steps) { advance_offset += steps; }
 
         void enable(bool state) { en_pin.set(!state); };
         bool is_enabled() const { return !en_pin.get(); };
@@ -53,6 +59,9 @@ class StepperMotor  : public Module {
         void set_selected(bool b) { selected= b; }
         bool is_extruder() const { return extruder; }
         void set_extruder(bool b) { extruder= b; }
+        void set_pressure_advance(float k, float smoothing);
+        float get_pressure_advance() const { return pressure_advance; }
+        float get_advance_smoothing() const { return advance_smoothing_time; }
 
         int32_t steps_to_target(float);
 
@@ -74,6 +83,14 @@ class StepperMotor  : public Module {
         int32_t last_milestone_steps;
         float   last_milestone_mm;
 
+        // pressure advance in seconds, and the time constant of its smoothing
+        float pressure_advance;
+        float advance_smoothing_time;
+        // steps issued over what was planned and the current extra rate in 2.30 fixed point
+        volatile int32_t advance_offset;
+        volatile int32_t advance_rate;
+        uint8_t advance_smoothing; // shift for the advance rate filter
+
         volatile struct {
             uint8_t motor_id:8;
             volatile bool direction:1;
@@ -289,21 +289,80 @@ int SDCard::disk_write(const char *buffer, uint32_t block_number)
     if (busyflag)
         return 0;
 
-    busyflag = true;
-
     if (cardtype == SDCARD_FAIL)
         return -1;
+
+    busyflag = true;
+
     // set write address for single block (CMD24)
     if(_cmd(SDCMD_WRITE_BLOCK, BLOCK2ADDR(block_number)) != 0) {
+        busyflag = false;
         return 1;
     }
 
     // send the data block
-    _write(buffer, 512);
+    int res = _write(buffer, 512);
 
     busyflag = false;
 
-    return 0;
+    return res;
+}
+
+int SDCard::disk_write_blocks(const char *buffer, uint32_t block_number, uint32_t count)
+{
+    if (count == 1)
+        return disk_write(buffer, block_number);
+
+    if (busyflag)
+        return 0;
+
+    if (cardtype == SDCARD_FAIL)
+        return -1;
+
+    busyflag = true;
+
+    // set write address for multiple blocks (CMD25)
+    if(_cmd(SDCMD_WRITE_MULTIPLE_BLOCK, BLOCK2ADDR(block_number)) != 0) {
+        busyflag = false;
+        return 1;
+    }
+
+    int res = 0;
+    _cs = 0;
+    for (uint32_t b = 0; b < count; b++) {
+        // indicate start of block in a multiple block write
+        _spi.write(0xFC);
+
+        for(int i=0; i<512; i++) {
+            _spi.write(buffer[i]);
+        }
+
+        // write the checksum
+        _spi.write(0xFF);
+        _spi.write(0xFF);
+
+        // check the repsonse token
+        if((_spi.write(0xFF) & 0x1F) != 0x05) {
+            res = 1;
+            break;
+        }
+
+        // wait for the block to be programmed
+        while(_spi.write(0xFF) == 0);
+        buffer += 512;
+    }
+
+    // stop transmission token, then wait for the card to finish
+    _spi.write(0xFD);
+    _spi.write(0xFF);
+    while(_spi.write(0xFF) == 0);
+
+    _cs = 1;
+    _spi.write(0xFF);
+
+    busyflag = false;
+
+    return res;
 }
 
 int SDCard::disk_read(char *buffer, uint32_t block_number)
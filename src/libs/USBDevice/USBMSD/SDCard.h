@@ -70,6 +70,7 @@ public:
 
     virtual int disk_initialize();
     virtual int disk_write(const char *buffer, uint32_t block_number);
+    virtual int disk_write_blocks(const char *buffer, uint32_t block_number, uint32_t count);
     virtual int disk_read(char *buffer, uint32_t block_number);
     virtual int disk_status();
     virtual int disk_sync();
@@ -23,6 +23,23 @@ public:
      */
     virtual int disk_write(const char * data, uint32_t block) { return 0; };
 
+    /*
+     * write count consecutive blocks, a disk that can do a multiple block write should override this
+     *
+     * @param data data to write
+     * @param block first block number
+     * @param count number of blocks
+     * @returns 0 if successful
+     */
+    virtual int disk_write_blocks(const char * data, uint32_t block, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            int res = disk_write(data, block + i);
+            if (res) return res;
+            data += 512;
+        }
+        return 0;
+    };
+
     /*
      * Disk initilization
      */
@@ -257,6 +257,13 @@ void init() {
     THEKERNEL->conveyor->start(THEROBOT->get_number_registered_motors());
     THEKERNEL->step_ticker->start();
     THEKERNEL->slow_ticker->start();
+
+    // all the motors are registered by now, done once everything is running as it may halt
+    THEROBOT->check_fixed_kinematics();
+
+#ifdef PERF_PROFILING
+    Perf::init();
+#endif
 }
 
 int main()
@@ -272,5 +279,8 @@ int main()
         }
         THEKERNEL->call_event(ON_MAIN_LOOP);
         THEKERNEL->call_event(ON_IDLE);
+#ifdef PERF_PROFILING
+        Perf::main_loop();
+#endif
     }
 }
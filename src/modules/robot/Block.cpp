@@ -16,6 +16,7 @@
 #include "Gcode.h"
 #include "libs/StreamOutputPool.h"
 #include "StepTicker.h"
+#include "StepperMotor.h"
 
 #include "mri.h"
 
@@ -65,6 +66,11 @@ void Block::clear()
     acceleration_per_tick= 0;
     deceleration_per_tick= 0;
     total_move_ticks= 0;
+    advance_accel= 0;
+    advance_decel= 0;
+    advance_steps= 0;
+    advance_motor= -1;
+    next_advance_motor= -1;
     if(tick_info.size() != n_actuators) {
         tick_info.resize(n_actuators);
     }
@@ -330,6 +336,52 @@ void Block::prepare()
         this->tick_info[m].deceleration_change= -STEPTICKER_TOFP(this->deceleration_per_tick * aratio);
         this->tick_info[m].plateau_rate= STEPTICKER_TOFP((this->maximum_rate * aratio) / STEP_TICKER_FREQUENCY);
     }
+
+    prepare_advance();
+}
+
+// Pressure advance adds K * the extruders acceleration to its rate, so while accelerating it runs ahead of the
+// nominal flow to build up nozzle pressure and while decelerating it falls behind to relieve it.
+// Only applies to an extruder pushing filament during a primary axis move, retracts and E only moves are left alone
+void Block::prepare_advance()
+{
+    this->advance_motor= -1;
+    this->advance_accel= 0;
+    this->advance_decel= 0;
+    this->advance_steps= 0;
+
+    int8_t m= find_advance_motor();
+    if(m < 0) return;
+
+    float k= THEKERNEL->step_ticker->get_motor(m)->get_pressure_advance(); // seconds
+    float aratio = (float)this->steps[m] / this->steps_event_count;
+    float kticks= k * STEP_TICKER_FREQUENCY;
+    // limit the extra rate so the step counter cannot overflow, a quarter of a step per tick is far more than any extruder can do
+    const float limit= 0.25F;
+    this->advance_accel= STEPTICKER_TOFP(std::min(this->acceleration_per_tick * aratio * kticks, limit));
+    this->advance_decel= -STEPTICKER_TOFP(std::min(this->deceleration_per_tick * aratio * kticks, limit));
+
+    // the advance is K * the extruder rate, so this is what it will be when the block finishes if the next block
+    // carries on extruding, otherwise the pressure is all let off by the end of this one
+    if(this->next_advance_motor == m) {
+        float final_rate = this->nominal_rate * (this->exit_speed / this->nominal_speed);
+        this->advance_steps= lroundf(k * final_rate * aratio);
+    }
+    this->advance_motor= m;
+}
+
+// the extruder pressure advance applies to in this block, -1 if none
+int8_t Block::find_advance_motor() const
+{
+    if(!this->primary_axis || this->nominal_speed <= 0.0F) return -1;
+
+    for (uint8_t m = 0; m < n_actuators; m++) {
+        if(this->steps[m] == 0 || this->direction_bits[m]) continue;
+
+        StepperMotor *motor= THEKERNEL->step_ticker->get_motor(m);
+        if(motor != nullptr && motor->is_extruder() && motor->get_pressure_advance() > 0.0F) return m;
+    }
+    return -1;
 }
 
 // returns current rate (steps/sec) for the given actuator
@@ -24,8 +24,12 @@ class Block {
         void ready() { is_ready= true; }
         void clear();
         void prepare();
+        void prepare_advance();
+        int8_t find_advance_motor() const;
 
         float get_trapezoid_rate(int i) const;
+        // extra steps per tick the advanced extruder should have at the given tick
+        int32_t get_advance_target(uint32_t tick) const { return tick < accelerate_until ? advance_accel : tick >= decelerate_after ? advance_decel : 0; }
 
         std::array<uint32_t, k_max_actuators> steps; // Number of steps for each axis for this block
         uint32_t steps_event_count;  // Steps for the longest axis
@@ -66,6 +70,13 @@ class Block {
         std::vector<tickinfo_t> tick_info;
         static uint8_t n_actuators;
 
+        // pressure advance for the one extruder that is pushing filament in this block
+        int32_t advance_accel; // 2.30 fixed point extra steps per tick while accelerating
+        int32_t advance_decel; // 2.30 fixed point extra steps per tick while decelerating (negative)
+        int32_t advance_steps; // advance the extruder should have at the end of this block, in steps
+        int8_t advance_motor;  // actuator that is advanced in this block, -1 if none
+        int8_t next_advance_motor; // actuator advanced in the block after this one, set by the planner, -1 if none
+
         struct {
             bool recalculate_flag:1;             // Planner flag to recalculate trapezoids on entry junction
             bool nominal_length_flag:1;          // Planner flag for nominal speed always reached
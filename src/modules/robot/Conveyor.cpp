@@ -25,6 +25,7 @@
 #include "StepperMotor.h"
 
 #include <functional>
+#include <algorithm>
 #include <vector>
 
 #include "mbed.h"
@@ -173,6 +174,7 @@ void Conveyor::queue_head_block()
     }
 
     queue.produce_head();
+    queued_count++;
 
     // not sure if this is the correct place but we need to turn on the motors if they were not already on
     THEKERNEL->call_event(ON_ENABLE, (void*)1); // turn all enable pins on
@@ -204,6 +206,7 @@ bool Conveyor::get_next_block(Block **block)
     if (flush){
         while (queue.isr_tail_i != queue.head_i) {
             queue.isr_tail_i = queue.next(queue.isr_tail_i);
+            finished_count++;
         }
     }
 
@@ -235,6 +238,7 @@ void Conveyor::block_finished()
 {
     // we increment the isr_tail_i so we can get the next block
     queue.isr_tail_i= queue.next(queue.isr_tail_i);
+    finished_count++;
 }
 
 /*
@@ -257,6 +261,31 @@ void Conveyor::flush_queue()
     flush= false;
 }
 
+// returns the average rate in mm/sec the given extruder motor will push filament over the next lookahead seconds of queued moves
+// NOTE the block being executed is counted in full and the queue may change while we look at it, so this is an estimate
+float Conveyor::get_extrusion_rate(float lookahead, uint8_t motor)
+{
+    if(lookahead <= 0.0F || motor >= Block::n_actuators) return 0.0F;
+
+    float secs= 0, mm= 0;
+    const float frequency= THEKERNEL->step_ticker->get_frequency();
+    const float steps_per_mm= THEROBOT->actuators[motor]->get_steps_per_mm();
+    for (unsigned int i = queue.isr_tail_i; i != queue.head_i && secs < lookahead; i = queue.next(i)) {
+        Block *b= queue.item_ref(i);
+        float t= b->total_move_ticks / frequency;
+        if(t <= 0.0F) continue;
+
+        // only the part of the block inside the lookahead window, retracts do not need heat
+        float frac= std::min(1.0F, (lookahead - secs) / t);
+        if(b->steps[motor] != 0 && !b->direction_bits[motor]) {
+            mm += frac * b->steps[motor] / steps_per_mm;
+        }
+        secs += t;
+    }
+
+    return mm / lookahead;
+}
+
 // Debug function
 void Conveyor::dump_queue()
 {
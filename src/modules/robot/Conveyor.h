@@ -35,6 +35,11 @@ public:
     void dump_queue(void);
     void flush_queue(void);
     float get_current_feedrate() const { return current_feedrate; }
+    float get_extrusion_rate(float lookahead, uint8_t motor);
+
+    // position in the motion queue is the count of blocks queued so far, a position is reached once every block queued before it has finished
+    uint32_t get_queue_position() const { return queued_count; }
+    bool is_position_reached(uint32_t pos) const { return (int32_t)(finished_count - pos) >= 0; }
 
     friend class Planner; // for queue
 
@@ -50,6 +55,8 @@ private:
     uint32_t queue_delay_time_ms;
     size_t queue_size;
     float current_feedrate{0}; // actual nominal feedrate that current block is running at in mm/sec
+    uint32_t queued_count{0};
+    volatile uint32_t finished_count{0};
 
     struct {
         volatile bool running:1;
@@ -22,6 +22,8 @@ using namespace std;
 #include "checksumm.h"
 #include "Robot.h"
 #include "ConfigValue.h"
+#include "StreamOutputPool.h"
+#include "utils.h"
 
 #include <math.h>
 #include <algorithm>
@@ -29,6 +31,9 @@ using namespace std;
 #define junction_deviation_checksum    CHECKSUM("junction_deviation")
 #define z_junction_deviation_checksum  CHECKSUM("z_junction_deviation")
 #define minimum_planner_speed_checksum CHECKSUM("minimum_planner_speed")
+#define per_axis_acceleration_checksum CHECKSUM("per_axis_acceleration")
+#define arm_solution_checksum          CHECKSUM("arm_solution")
+#define cartesian_checksum             CHECKSUM("cartesian")
 
 // The Planner does the acceleration math for the queue of Blocks ( movements ).
 // It makes sure the speed stays within the configured constraints ( acceleration, junction_deviation, etc )
@@ -46,11 +51,22 @@ void Planner::config_load()
     this->junction_deviation = THEKERNEL->config->value(junction_deviation_checksum)->by_default(0.05F)->as_number();
     this->z_junction_deviation = THEKERNEL->config->value(z_junction_deviation_checksum)->by_default(NAN)->as_number(); // disabled by default
     this->minimum_planner_speed = THEKERNEL->config->value(minimum_planner_speed_checksum)->by_default(0.0f)->as_number();
+    this->per_axis_acceleration = THEKERNEL->config->value(per_axis_acceleration_checksum)->by_default(false)->as_bool();
+
+    // the per axis limits are the actuator limits, which are only the axis limits when each actuator drives one axis
+    if(this->per_axis_acceleration) {
+        int solution_checksum = get_checksum(THEKERNEL->config->value(arm_solution_checksum)->by_default("cartesian")->as_string());
+        if(solution_checksum != cartesian_checksum) {
+            THEKERNEL->streams->printf("WARNING: per_axis_acceleration only works with the cartesian arm solution, it has been disabled\n");
+            this->per_axis_acceleration = false;
+        }
+    }
 }
 
 
 // Append a block to the queue, compute it's speed factors
-bool Planner::append_block( ActuatorCoordinates &actuator_pos, uint8_t n_motors, float rate_mm_s, float distance, float *unit_vec, float acceleration, float s_value, bool g123)
+// junction_speed if not NAN is the speed to join the previous block at instead of using the junction deviation, used for the chords of an arc
+bool Planner::append_block( ActuatorCoordinates &actuator_pos, uint8_t n_motors, float rate_mm_s, float distance, float *unit_vec, float acceleration, float s_value, bool g123, float junction_speed)
 {
     // Create ( recycle ) a new block
     Block* block = THECONVEYOR->queue.head_ref();
@@ -147,7 +163,11 @@ bool Planner::append_block( ActuatorCoordinates &actuator_pos, uint8_t n_motors,
         Block *prev_block = THECONVEYOR->queue.item_ref(THECONVEYOR->queue.prev(THECONVEYOR->queue.head_i));
         float previous_nominal_speed = prev_block->primary_axis ? prev_block->nominal_speed : 0;
 
-        if (junction_deviation > 0.0F && previous_nominal_speed > 0.0F) {
+        if (!isnan(junction_speed) && previous_nominal_speed > 0.0F) {
+            // the previous block is the chord before this one on the same arc, the speed has already been limited for its radius
+            vmax_junction = std::min(std::min(previous_nominal_speed, block->nominal_speed), junction_speed);
+
+        } else if (junction_deviation > 0.0F && previous_nominal_speed > 0.0F) {
             // Compute cosine of angle between previous and current path. (prev_unit_vec is negative)
             // NOTE: Max junction velocity is computed without sin() or acos() by trig half angle identity.
             float cos_theta = - this->previous_unit_vec[X_AXIS] * unit_vec[X_AXIS]
@@ -166,7 +186,8 @@ bool Planner::append_block( ActuatorCoordinates &actuator_pos, uint8_t n_motors,
                 if (cos_theta > -0.95F) {
                     // Compute maximum junction velocity based on maximum acceleration and junction deviation
                     float sin_theta_d2 = sqrtf(0.5F * (1.0F - cos_theta)); // Trig half angle identity. Always positive.
-                    vmax_junction = std::min(vmax_junction, sqrtf(acceleration * junction_deviation * sin_theta_d2 / (1.0F - sin_theta_d2)));
+                    float jacc = this->per_axis_acceleration ? junction_acceleration(unit_vec) : acceleration;
+                    vmax_junction = std::min(vmax_junction, sqrtf(jacc * junction_deviation * sin_theta_d2 / (1.0F - sin_theta_d2)));
                 }
             }
         }
@@ -209,6 +230,34 @@ bool Planner::append_block( ActuatorCoordinates &actuator_pos, uint8_t n_motors,
     return true;
 }
 
+// The acceleration the axis can give the change in velocity at a junction with the previous block.
+// The velocity changes in the direction of unit_vec - previous_unit_vec, so the corner can be taken as fast as the most
+// limited axis allows in that direction, rather than at the acceleration of the block which is along its own path.
+// Axis that do not have their own acceleration use the default one
+float Planner::junction_acceleration(const float unit_vec[]) const
+{
+    float dv[N_PRIMARY_AXIS];
+    float sos= 0;
+    for (int i = 0; i < N_PRIMARY_AXIS; ++i) {
+        dv[i]= unit_vec[i] - this->previous_unit_vec[i];
+        sos += dv[i] * dv[i];
+    }
+    float dvlen= sqrtf(sos);
+
+    float acc= THEROBOT->default_acceleration;
+    bool first= true;
+    for (int i = 0; i < N_PRIMARY_AXIS; ++i) {
+        if(dv[i] == 0) continue;
+        float ma= THEROBOT->actuators[i]->get_acceleration();
+        if(isnan(ma)) ma= THEROBOT->default_acceleration;
+        float a= ma * dvlen / fabsf(dv[i]);
+        if(first || a < acc) acc= a;
+        first= false;
+    }
+
+    return acc;
+}
+
 void Planner::recalculate()
 {
     Conveyor::Queue_t &queue = THECONVEYOR->queue;
@@ -282,6 +331,8 @@ void Planner::recalculate()
             // so this block can decide if it's accel or decel limited and update its fields as appropriate
             exit_speed = current->forward_pass(exit_speed);
 
+            // pressure advance is only kept up through the junction if the next block extrudes too
+            previous->next_advance_motor = current->find_advance_motor();
             previous->calculate_trapezoid(previous->entry_speed, current->entry_speed);
         }
     }
@@ -24,6 +24,7 @@
 #include "arm_solutions/HBotSolution.h"
 #include "arm_solutions/CoreXZSolution.h"
 #include "arm_solutions/MorganSCARASolution.h"
+#include "arm_solutions/FixedKinematics.h"
 #include "StepTicker.h"
 #include "checksumm.h"
 #include "utils.h"
@@ -45,9 +46,11 @@
 #define  default_feed_rate_checksum          CHECKSUM("default_feed_rate")
 #define  mm_per_line_segment_checksum        CHECKSUM("mm_per_line_segment")
 #define  delta_segments_per_second_checksum  CHECKSUM("delta_segments_per_second")
+#define  max_segment_error_checksum          CHECKSUM("max_segment_error")
 #define  mm_per_arc_segment_checksum         CHECKSUM("mm_per_arc_segment")
 #define  mm_max_arc_error_checksum           CHECKSUM("mm_max_arc_error")
 #define  arc_correction_checksum             CHECKSUM("arc_correction")
+#define  arc_acceleration_checksum           CHECKSUM("arc_acceleration")
 #define  x_axis_max_speed_checksum           CHECKSUM("x_axis_max_speed")
 #define  y_axis_max_speed_checksum           CHECKSUM("y_axis_max_speed")
 #define  z_axis_max_speed_checksum           CHECKSUM("z_axis_max_speed")
@@ -89,6 +92,15 @@
 
 #define ARC_ANGULAR_TRAVEL_EPSILON 5E-7F // Float (radians)
 #define PI 3.14159265358979323846F // force to be float, do not use M_PI
+#define SEGMENT_BATCH 8 // segment end points handed to the arm solution in one call
+#define MAX_SEGMENT_DEPTH 12 // times a line can be halved by the adaptive segmentation, so at most 4096 segments
+
+#ifdef FIXED_KINEMATICS
+// the number of motors is fixed at build time so the loops and buffers in the move path have constant sizes
+#define MOVE_MOTORS k_max_actuators
+#else
+#define MOVE_MOTORS n_motors
+#endif
 
 // The Robot converts GCodes into actual movements, and then adds them to the Planner, which passes them to the Conveyor so they can be added to the queue
 // It takes care of cutting arcs into segments, same thing for line that are too long
@@ -112,6 +124,8 @@ Robot::Robot()
     this->disable_segmentation= false;
     this->disable_arm_solution= false;
     this->n_motors= 0;
+    this->arc_speed= NAN;
+    this->next_junction_speed= NAN;
 }
 
 //Called when the module has just been loaded
@@ -123,6 +137,37 @@ void Robot::on_module_loaded()
     this->load_config();
 }
 
+// called once all the modules are loaded so every motor has been registered
+void Robot::check_fixed_kinematics()
+{
+#ifdef FIXED_KINEMATICS
+    // the move path of this build can only drive the machine it was built for, so on any other it must not move at all
+    bool wrong= false;
+    if(this->wrong_arm_solution) {
+        THEKERNEL->streams->printf("ERROR: this build only supports the %s arm solution, HALT asserted - fix the config and reset\n", FixedKinematics::name);
+        wrong= true;
+    }
+    if(n_motors != MOVE_MOTORS) {
+        THEKERNEL->streams->printf("ERROR: this build needs exactly %d motors but %d are configured, HALT asserted - fix the config and reset\n", (int)MOVE_MOTORS, n_motors);
+        wrong= true;
+    }
+    if(wrong) {
+        // registered last so it is the last to see a halt being cleared, and can assert it again
+        this->register_for_event(ON_HALT);
+        THEKERNEL->call_event(ON_HALT, nullptr);
+    }
+#endif
+}
+
+void Robot::on_halt(void *argument)
+{
+    // only registered when the config does not match a fixed kinematics build, M999 can not clear that
+    if(argument != nullptr) {
+        THEKERNEL->streams->printf("ERROR: the config does not match this build, HALT asserted - fix the config and reset\n");
+        THEKERNEL->call_event(ON_HALT, nullptr);
+    }
+}
+
 #define ACTUATOR_CHECKSUMS(X) {     \
     CHECKSUM(X "_step_pin"),        \
     CHECKSUM(X "_dir_pin"),         \
@@ -140,6 +185,12 @@ void Robot::load_config()
     // Here we read the config to find out which arm solution to use
     if (this->arm_solution) delete this->arm_solution;
     int solution_checksum = get_checksum(THEKERNEL->config->value(arm_solution_checksum)->by_default("cartesian")->as_string());
+    this->wrong_arm_solution= false;
+#ifdef FIXED_KINEMATICS
+    // this build only drives one kind of machine, the move path does the math for it inline, any other halts once started
+    this->wrong_arm_solution= solution_checksum != get_checksum(FixedKinematics::name) && solution_checksum != get_checksum(FixedKinematics::alias);
+    this->arm_solution = new FixedKinematics::solution_t(THEKERNEL->config);
+#else
     // Note checksums are not const expressions when in debug mode, so don't use switch
     if(solution_checksum == hbot_checksum || solution_checksum == corexy_checksum) {
         this->arm_solution = new HBotSolution(THEKERNEL->config);
@@ -165,14 +216,17 @@ void Robot::load_config()
     } else {
         this->arm_solution = new CartesianSolution(THEKERNEL->config);
     }
+#endif
 
     this->feed_rate           = THEKERNEL->config->value(default_feed_rate_checksum   )->by_default(  100.0F)->as_number();
     this->seek_rate           = THEKERNEL->config->value(default_seek_rate_checksum   )->by_default(  100.0F)->as_number();
     this->mm_per_line_segment = THEKERNEL->config->value(mm_per_line_segment_checksum )->by_default(    0.0F)->as_number();
     this->delta_segments_per_second = THEKERNEL->config->value(delta_segments_per_second_checksum )->by_default(0.0f   )->as_number();
+    this->max_segment_error   = THEKERNEL->config->value(max_segment_error_checksum   )->by_default(    0.0F)->as_number();
     this->mm_per_arc_segment  = THEKERNEL->config->value(mm_per_arc_segment_checksum  )->by_default(    0.0f)->as_number();
     this->mm_max_arc_error    = THEKERNEL->config->value(mm_max_arc_error_checksum    )->by_default(   0.01f)->as_number();
     this->arc_correction      = THEKERNEL->config->value(arc_correction_checksum      )->by_default(    5   )->as_number();
+    this->arc_acceleration    = THEKERNEL->config->value(arc_acceleration_checksum    )->by_default(    0.0F)->as_number(); // mm/sec², 0 disables
 
     // in mm/sec but specified in config as mm/min
     this->max_speeds[X_AXIS]  = THEKERNEL->config->value(x_axis_max_speed_checksum    )->by_default(60000.0F)->as_number() / 60.0F;
@@ -421,6 +475,7 @@ void Robot::on_gcode_received(void *argument)
             case 1:  motion_mode = LINEAR;  break;
             case 2:  motion_mode = CW_ARC;  break;
             case 3:  motion_mode = CCW_ARC; break;
+            case 5:  if(gcode->subcode == 0) motion_mode = BEZIER; break;
             case 4: { // G4 Dwell
                 uint32_t delay_ms = 0;
                 if (gcode->has_letter('P')) {
@@ -866,10 +921,10 @@ int Robot::get_active_extruder() const
     return 0;
 }
 
-// process a G0/G1/G2/G3
+// process a G0/G1/G2/G3/G5
 void Robot::process_move(Gcode *gcode, enum MOTION_MODE_T motion_mode)
 {
-    // we have a G0/G1/G2/G3 so extract parameters and apply offsets to get machine coordinate target
+    // we have a G0/G1/G2/G3/G5 so extract parameters and apply offsets to get machine coordinate target
     // get XYZ and one E (which goes to the selected extruder)
     float param[4]{NAN, NAN, NAN, NAN};
 
@@ -985,6 +1040,15 @@ void Robot::process_move(Gcode *gcode, enum MOTION_MODE_T motion_mode)
             // Note arcs are not currently supported by extruder based machines, as 3D slicers do not use arcs (G2/G3)
             moved= this->compute_arc(gcode, offset, target, motion_mode);
             break;
+
+        case BEZIER: {
+            // I J is the first control point relative to the start, P Q the second relative to the end
+            float cp2[2]{0, 0};
+            if(gcode->has_letter('P')) cp2[0] = this->to_millimeters(gcode->get_value('P'));
+            if(gcode->has_letter('Q')) cp2[1] = this->to_millimeters(gcode->get_value('Q'));
+            moved= this->append_bezier(gcode, target, offset, cp2, delta_e);
+            break;
+        }
     }
 
     if(moved) {
@@ -1088,24 +1152,65 @@ void Robot::reset_position_from_current_actuator_position()
 // all transforms and is what we actually convert to actuator positions
 bool Robot::append_milestone(const float target[], float rate_mm_s)
 {
-    float deltas[n_motors];
-    float transformed_target[n_motors]; // adjust target for bed compensation
-    float unit_vec[N_PRIMARY_AXIS];
+    float transformed_target[MOVE_MOTORS]; // adjust target for bed compensation
 
     // unity transform by default
-    memcpy(transformed_target, target, n_motors*sizeof(float));
+    memcpy(transformed_target, target, MOVE_MOTORS*sizeof(float));
+
+    return append_milestones(transformed_target, 1, rate_mm_s);
+}
 
+// Same for up to SEGMENT_BATCH targets n_motors floats apart, used by the segmentation so the arm solution converts them all in one call
+// NOTE the compensation transform is applied to targets in place
+bool Robot::append_milestones(float targets[], size_t n, float rate_mm_s)
+{
     // check function pointer and call if set to transform the target to compensate for bed
     if(compensationTransform) {
         // some compensation strategies can transform XYZ, some just change Z
-        compensationTransform(transformed_target, false);
+        for (size_t i = 0; i < n; i++) {
+            compensationTransform(&targets[i*MOVE_MOTORS], false);
+        }
+    }
+
+    // find actuator position given the machine position, use actual adjusted target
+    ActuatorCoordinates actuator_pos[SEGMENT_BATCH];
+    if(!disable_arm_solution) {
+#ifdef FIXED_KINEMATICS
+        FixedKinematics::batch_cartesian_to_actuator(targets, MOVE_MOTORS, actuator_pos, n);
+#else
+        arm_solution->batch_cartesian_to_actuator(targets, MOVE_MOTORS, actuator_pos, n);
+#endif
+
+    }else{
+        // basically the same as cartesian, would be used for special homing situations like for scara
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = X_AXIS; j <= Z_AXIS; j++) {
+                actuator_pos[i][j] = targets[i*MOVE_MOTORS + j];
+            }
+        }
     }
 
+    bool moved= false;
+    for (size_t i = 0; i < n; i++) {
+        if(THEKERNEL->is_halted()) return false; // don't queue any more segments
+        if(plan_milestone(&targets[i*MOVE_MOTORS], actuator_pos[i], rate_mm_s)) moved= true;
+    }
+
+    return moved;
+}
+
+// Plan the move to transformed_target, which already has the compensation applied, actuator_pos has the arm solution for it
+// and the rest of the actuators are filled in here
+bool Robot::plan_milestone(const float transformed_target[], ActuatorCoordinates &actuator_pos, float rate_mm_s)
+{
+    float deltas[MOVE_MOTORS];
+    float unit_vec[N_PRIMARY_AXIS];
+
     bool move= false;
     float sos= 0; // sum of squares for just primary axis (XYZ usually)
 
     // find distance moved by each axis, use transformed target from the current compensated machine position
-    for (size_t i = 0; i < n_motors; i++) {
+    for (size_t i = 0; i < MOVE_MOTORS; i++) {
         deltas[i] = transformed_target[i] - compensated_machine_position[i];
         if(deltas[i] == 0) continue;
         // at least one non zero delta
@@ -1150,22 +1255,10 @@ bool Robot::append_milestone(const float target[], float rate_mm_s)
         }
     }
 
-    // find actuator position given the machine position, use actual adjusted target
-    ActuatorCoordinates actuator_pos;
-    if(!disable_arm_solution) {
-        arm_solution->cartesian_to_actuator( transformed_target, actuator_pos );
-
-    }else{
-        // basically the same as cartesian, would be used for special homing situations like for scara
-        for (size_t i = X_AXIS; i <= Z_AXIS; i++) {
-            actuator_pos[i] = transformed_target[i];
-        }
-    }
-
 #if MAX_ROBOT_ACTUATORS > 3
     sos= 0;
     // for the extruders just copy the position, and possibly scale it from mm³ to mm
-    for (size_t i = E_AXIS; i < n_motors; i++) {
+    for (size_t i = E_AXIS; i < MOVE_MOTORS; i++) {
         actuator_pos[i]= transformed_target[i];
         if(actuators[i]->is_extruder() && get_e_scale_fnc) {
             // NOTE this relies on the fact only one extruder is active at a time
@@ -1188,10 +1281,15 @@ bool Robot::append_milestone(const float target[], float rate_mm_s)
     // use default acceleration to start with
     float acceleration = default_acceleration;
 
+    // with per axis acceleration the default only stands in for axis that do not have their own, and the move gets whatever
+    // its direction allows, so for instance a diagonal XY move accelerates faster than either axis on its own would
+    bool per_axis= THEKERNEL->planner->per_axis_acceleration && !auxilliary_move;
+    bool acceleration_set= false;
+
     float isecs = rate_mm_s / distance;
 
     // check per-actuator speed limits
-    for (size_t actuator = 0; actuator < n_motors; actuator++) {
+    for (size_t actuator = 0; actuator < MOVE_MOTORS; actuator++) {
         float d = fabsf(actuator_pos[actuator] - actuators[actuator]->get_last_milestone());
         if(d == 0 || !actuators[actuator]->is_selected()) continue; // no movement for this actuator
 
@@ -1205,7 +1303,14 @@ bool Robot::append_milestone(const float target[], float rate_mm_s)
         // TODO we may need to do all of them, check E won't limit XYZ.. it does on long E moves, but not checking it could exceed the E acceleration.
         if(auxilliary_move || actuator < N_PRIMARY_AXIS) {
             float ma =  actuators[actuator]->get_acceleration(); // in mm/sec²
-            if(!isnan(ma)) {  // if axis does not have acceleration set then it uses the default_acceleration
+            if(per_axis) {
+                // the acceleration along the path that gets this actuator to its own limit
+                if(isnan(ma)) ma= default_acceleration;
+                float pa= ma * distance / d;
+                if(!acceleration_set || pa < acceleration) acceleration= pa;
+                acceleration_set= true;
+
+            } else if(!isnan(ma)) {  // if axis does not have acceleration set then it uses the default_acceleration
                 float ca = fabsf((d/distance) * acceleration);
                 if (ca > ma) {
                     acceleration *= ( ma / ca );
@@ -1216,9 +1321,11 @@ bool Robot::append_milestone(const float target[], float rate_mm_s)
 
     // Append the block to the planner
     // NOTE that distance here should be either the distance travelled by the XYZ axis, or the E mm travel if a solo E move
-    if(THEKERNEL->planner->append_block( actuator_pos, n_motors, rate_mm_s, distance, auxilliary_move ? nullptr : unit_vec, acceleration, s_value, is_g123)) {
+    if(THEKERNEL->planner->append_block( actuator_pos, MOVE_MOTORS, rate_mm_s, distance, auxilliary_move ? nullptr : unit_vec, acceleration, s_value, is_g123, next_junction_speed)) {
         // this is the new compensated machine position
-        memcpy(this->compensated_machine_position, transformed_target, n_motors*sizeof(float));
+        memcpy(this->compensated_machine_position, transformed_target, MOVE_MOTORS*sizeof(float));
+        // the first chord of an arc joins the previous move as usual, the rest join at the arc speed
+        next_junction_speed= arc_speed;
         return true;
     }
 
@@ -1289,10 +1396,16 @@ bool Robot::append_line(Gcode *gcode, const float target[], float rate_mm_s, flo
     // In delta robots either mm_per_line_segment can be used OR delta_segments_per_second
     // The latter is more efficient and avoids splitting fast long lines into very small segments, like initial z move to 0, it is what Johanns Marlin delta port does
     uint16_t segments;
+    bool adaptive= false;
 
     if(this->disable_segmentation || (!segment_z_moves && !gcode->has_letter('X') && !gcode->has_letter('Y'))) {
         segments= 1;
 
+    } else if(this->max_segment_error > 0.0F && !this->disable_arm_solution) {
+        // enabled if set to something > 0, the line is split where the arm solution needs it rather than evenly
+        adaptive= true;
+        segments= 0;
+
     } else if(this->delta_segments_per_second > 1.0F) {
         // enabled if set to something > 1, it is set to 0.0 by default
         // segment based on current speed and requested segments per second
@@ -1311,7 +1424,10 @@ bool Robot::append_line(Gcode *gcode, const float target[], float rate_mm_s, flo
     }
 
     bool moved= false;
-    if (segments > 1) {
+    if (adaptive) {
+        moved= this->append_adaptive_line(target, millimeters_of_travel, rate_mm_s);
+
+    }else if (segments > 1) {
         // A vector to keep track of the endpoint of each segment
         float segment_delta[n_motors];
         float segment_end[n_motors];
@@ -1321,21 +1437,33 @@ bool Robot::append_line(Gcode *gcode, const float target[], float rate_mm_s, flo
         for (int i = 0; i < n_motors; i++)
             segment_delta[i] = (target[i] - machine_position[i]) / segments;
 
+        // the end points are collected and appended SEGMENT_BATCH at a time
+        float batch[SEGMENT_BATCH * n_motors];
+        size_t nb= 0;
+
         // segment 0 is already done - it's the end point of the previous move so we start at segment 1
-        // We always add another point after this loop so we stop at segments-1, ie i < segments
-        for (int i = 1; i < segments; i++) {
+        // the last one is the target itself so it ends exactly where it was asked to
+        for (int i = 1; i <= segments; i++) {
             if(THEKERNEL->is_halted()) return false; // don't queue any more segments
-            for (int i = 0; i < n_motors; i++)
-                segment_end[i] += segment_delta[i];
+            if(i < segments) {
+                for (int j = 0; j < n_motors; j++)
+                    segment_end[j] += segment_delta[j];
+                memcpy(&batch[nb * n_motors], segment_end, n_motors*sizeof(float));
+            }else{
+                memcpy(&batch[nb * n_motors], target, n_motors*sizeof(float));
+            }
 
-            // Append the end of this segment to the queue
-            bool b= this->append_milestone(segment_end, rate_mm_s);
-            moved= moved || b;
+            // Append the end of these segments to the queue
+            if(++nb == SEGMENT_BATCH || i == segments) {
+                if(this->append_milestones(batch, nb, rate_mm_s)) moved= true;
+                nb= 0;
+            }
         }
-    }
 
-    // Append the end of this full move to the queue
-    if(this->append_milestone(target, rate_mm_s)) moved= true;
+    }else{
+        // Append the end of this full move to the queue
+        if(this->append_milestone(target, rate_mm_s)) moved= true;
+    }
 
     this->next_command_is_MCS = false; // always reset this
 
@@ -1343,6 +1471,85 @@ bool Robot::append_line(Gcode *gcode, const float target[], float rate_mm_s, flo
 }
 
 
+// Cut the line from machine_position to target into as few segments as keep the actuators within max_segment_error of where the
+// arm solution puts them, in actuator units so mm for a linear delta and degrees for the rotary ones. Each piece is halved while its
+// midpoint in actuator space is too far from the arm solution for its midpoint, so long straight runs in the middle of a delta are one
+// block and the edges get as many as they need. mm_per_line_segment if set still limits the segment length.
+// NOTE this is measured before the compensation transform
+bool Robot::append_adaptive_line(const float target[], float millimeters_of_travel, float rate_mm_s)
+{
+    // the end of each pending piece as a fraction of the line and its actuator position, the next one to do is on top
+    struct {
+        float t;
+        ActuatorCoordinates actuator_pos;
+    } pending[MAX_SEGMENT_DEPTH + 1];
+
+    float start[n_motors];
+    memcpy(start, machine_position, n_motors*sizeof(float));
+
+    auto position= [&](float t, float *p) {
+        for (int i = 0; i < n_motors; i++) {
+            p[i] = start[i] + (target[i] - start[i]) * t;
+        }
+    };
+
+    float t0= 0;
+    ActuatorCoordinates a0;
+    arm_solution->cartesian_to_actuator(start, a0);
+
+    int top= 0;
+    pending[0].t= 1;
+    arm_solution->cartesian_to_actuator(target, pending[0].actuator_pos);
+
+    // the end points are collected and appended SEGMENT_BATCH at a time
+    float batch[SEGMENT_BATCH * n_motors];
+    float mid[n_motors];
+    size_t nb= 0;
+    bool moved= false;
+
+    while(top >= 0) {
+        if(THEKERNEL->is_halted()) return false; // don't queue any more segments
+
+        float t1= pending[top].t;
+        if(top < MAX_SEGMENT_DEPTH) {
+            float tm= (t0 + t1) / 2;
+            ActuatorCoordinates am;
+            position(tm, mid);
+            arm_solution->cartesian_to_actuator(mid, am);
+
+            bool split= mm_per_line_segment > 0 && (t1 - t0) * millimeters_of_travel > mm_per_line_segment;
+            for (size_t i = X_AXIS; i <= Z_AXIS && !split; i++) {
+                if(fabsf(am[i] - (a0[i] + pending[top].actuator_pos[i]) / 2) > max_segment_error) split= true;
+            }
+
+            if(split) {
+                // do the first half next
+                ++top;
+                pending[top].t= tm;
+                pending[top].actuator_pos= am;
+                continue;
+            }
+        }
+
+        // this piece is close enough to straight, the end of the last one is the target itself so it ends exactly where it was asked to
+        a0= pending[top].actuator_pos;
+        t0= t1;
+        --top;
+        if(top < 0) {
+            memcpy(&batch[nb * n_motors], target, n_motors*sizeof(float));
+        }else{
+            position(t1, &batch[nb * n_motors]);
+        }
+
+        if(++nb == SEGMENT_BATCH || top < 0) {
+            if(this->append_milestones(batch, nb, rate_mm_s)) moved= true;
+            nb= 0;
+        }
+    }
+
+    return moved;
+}
+
 // Append an arc to the queue ( cutting it into segments as needed )
 // TODO does not support any E parameters so cannot be used for 3D printing.
 bool Robot::append_arc(Gcode * gcode, const float target[], const float offset[], float radius, bool is_clockwise )
@@ -1393,6 +1600,15 @@ bool Robot::append_arc(Gcode * gcode, const float target[], const float offset[]
     // TODO for deltas we need to make sure we are at least as many segments as requested, also if mm_per_line_segment is set we need to use the
     uint16_t segments = ceilf(millimeters_of_travel / arc_segment);
 
+    // The planner sees each segment as a separate move, and would slow down for the angle between them at every junction as if
+    // they were corners, so small arcs crawl. Instead limit the speed for the arc so the centripetal acceleration is within
+    // arc_acceleration and tell the planner to join the segments at that speed, the change in direction at each junction then
+    // works out to that same acceleration.
+    if(this->arc_acceleration > 0.0F) {
+        rate_mm_s = std::min(rate_mm_s, sqrtf(this->arc_acceleration * radius));
+        this->arc_speed = rate_mm_s;
+    }
+
   //printf("Radius %f - Segment Length %f - Number of Segments %d\r\n",radius,arc_segment,segments);  // Testing Purposes ONLY
     float theta_per_segment = angular_travel / segments;
     float linear_per_segment = linear_travel / segments;
@@ -1424,20 +1640,33 @@ bool Robot::append_arc(Gcode * gcode, const float target[], const float offset[]
     float cos_T = 1 - 0.5F * theta_per_segment * theta_per_segment; // Small angle approximation
     float sin_T = theta_per_segment;
 
-    // TODO we need to handle the ABC axis here by segmenting them
-    float arc_target[3];
+    // TODO we need to handle the ABC axis here by segmenting them, for now they stay where they are until the last segment
+    float arc_target[SEGMENT_BATCH * n_motors];
+    float linear_position;
     float sin_Ti;
     float cos_Ti;
     float r_axisi;
     uint16_t i;
+    size_t nb= 0;
     int8_t count = 0;
 
     // Initialize the linear axis
-    arc_target[this->plane_axis_2] = this->machine_position[this->plane_axis_2];
+    linear_position = this->machine_position[this->plane_axis_2];
 
     bool moved= false;
-    for (i = 1; i < segments; i++) { // Increment (segments-1)
-        if(THEKERNEL->is_halted()) return false; // don't queue any more segments
+    for (i = 1; i <= segments; i++) { // Increment (segments-1), then the target
+        if(THEKERNEL->is_halted()) {
+            moved= false; // don't queue any more segments
+            break;
+        }
+
+        float *p= &arc_target[nb * n_motors];
+        if (i == segments) {
+            // Ensure last segment arrives at target location.
+            memcpy(p, target, n_motors*sizeof(float));
+            if(this->append_milestones(arc_target, nb + 1, rate_mm_s)) moved= true;
+            break;
+        }
 
         if (count < this->arc_correction ) {
             // Apply vector rotation matrix
@@ -1456,17 +1685,196 @@ bool Robot::append_arc(Gcode * gcode, const float target[], const float offset[]
         }
 
         // Update arc_target location
-        arc_target[this->plane_axis_0] = center_axis0 + r_axis0;
-        arc_target[this->plane_axis_1] = center_axis1 + r_axis1;
-        arc_target[this->plane_axis_2] += linear_per_segment;
+        linear_position += linear_per_segment;
+        memcpy(p, this->machine_position, n_motors*sizeof(float));
+        p[this->plane_axis_0] = center_axis0 + r_axis0;
+        p[this->plane_axis_1] = center_axis1 + r_axis1;
+        p[this->plane_axis_2] = linear_position;
+
+        // Append these segments to the queue
+        if(++nb == SEGMENT_BATCH) {
+            if(this->append_milestones(arc_target, nb, rate_mm_s)) moved= true;
+            nb= 0;
+        }
+    }
+
+    // whatever comes next is planned as usual
+    this->arc_speed = NAN;
+    this->next_junction_speed = NAN;
+
+    return moved;
+}
+
+// Append a cubic Bézier from machine_position to target in the XY plane, this is G5 as used by LinuxCNC and Marlin.
+// cp1 is the first control point relative to the start and cp2 the second relative to the end, the other axis move in proportion.
+// The curve is halved until each piece is within mm_max_arc_error of its chord, so gentle curves take few blocks and tight ones get
+// what they need, and each chord is queued as soon as it is found so the memory used does not depend on the length of the curve.
+// The chords are also held to what append_line would segment a line into, so on a delta a nearly straight curve is not one long
+// chord that the actuators take as a straight line in their own space.
+bool Robot::append_bezier(Gcode * gcode, const float target[], const float cp1[], const float cp2[], float delta_e)
+{
+    float rate_mm_s= this->feed_rate / seconds_per_minute;
+    // catch negative or zero feed rates and return the same error as GRBL does
+    if(rate_mm_s <= 0.0F) {
+        gcode->is_error= true;
+        gcode->txt_after_ok= (rate_mm_s == 0 ? "Undefined feed rate" : "feed rate < 0");
+        return false;
+    }
+
+    if(this->plane_axis_0 != X_AXIS || this->plane_axis_1 != Y_AXIS) {
+        gcode->is_error= true;
+        gcode->txt_after_ok= "G5 is only supported in the XY plane";
+        return false;
+    }
+
+    // limit the volumetric rate of the extruder the same way as append_line does for G1, over the length of the curve which
+    // is taken as the mean of its chord and its control polygon, the two lengths it lies between
+    if(!isnan(delta_e)) {
+        float x0 = machine_position[X_AXIS], y0 = machine_position[Y_AXIS];
+        float x3 = target[X_AXIS], y3 = target[Y_AXIS];
+        float chord = hypotf(x3 - x0, y3 - y0);
+        float polygon = hypotf(cp1[0], cp1[1]) + hypotf(x3 + cp2[0] - x0 - cp1[0], y3 + cp2[1] - y0 - cp1[1]) + hypotf(cp2[0], cp2[1]);
+        float millimeters_of_travel = hypotf((chord + polygon) / 2, target[Z_AXIS] - machine_position[Z_AXIS]);
+        if(millimeters_of_travel >= 0.00001F) {
+            float data[2]= {delta_e, rate_mm_s / millimeters_of_travel};
+            if(PublicData::set_value(extruder_checksum, target_checksum, data)) {
+                rate_mm_s *= data[1]; // adjust the feedrate
+            }
+        }
+    }
 
-        // Append this segment to the queue
-        bool b= this->append_milestone(arc_target, rate_mm_s);
-        moved= moved || b;
+    float tolerance = this->mm_max_arc_error > 0 ? this->mm_max_arc_error : 0.01F;
+
+    // the longest chord the segmentation allows, 0 if it does not limit it, the same choice as append_line makes
+    bool adaptive= false;
+    float max_chord= 0;
+    if(this->disable_segmentation) {
+        // not segmented
+    } else if(this->max_segment_error > 0.0F && !this->disable_arm_solution) {
+        adaptive= true;
+        max_chord= this->mm_per_line_segment;
+    } else if(this->delta_segments_per_second > 1.0F) {
+        max_chord= rate_mm_s / this->delta_segments_per_second;
+    } else {
+        max_chord= this->mm_per_line_segment;
     }
 
-    // Ensure last segment arrives at target location.
-    if(this->append_milestone(target, rate_mm_s)) moved= true;
+    // where the other axis are at t along the curve, XY are set by the caller
+    auto position= [&](float t, float *p) {
+        for (int i = 0; i < n_motors; i++) {
+            p[i] = machine_position[i] + (target[i] - machine_position[i]) * t;
+        }
+    };
+
+    // a piece of the curve from t0 to t1 as its own four control points, the next one to do is on top
+    struct {
+        float p[4][2];
+        float t0, t1;
+        uint8_t depth;
+    } pending[MAX_SEGMENT_DEPTH + 1];
+
+    int top= 0;
+    pending[0].p[0][0] = machine_position[X_AXIS];
+    pending[0].p[0][1] = machine_position[Y_AXIS];
+    pending[0].p[1][0] = machine_position[X_AXIS] + cp1[0];
+    pending[0].p[1][1] = machine_position[Y_AXIS] + cp1[1];
+    pending[0].p[2][0] = target[X_AXIS] + cp2[0];
+    pending[0].p[2][1] = target[Y_AXIS] + cp2[1];
+    pending[0].p[3][0] = target[X_AXIS];
+    pending[0].p[3][1] = target[Y_AXIS];
+    pending[0].t0 = 0;
+    pending[0].t1 = 1;
+    pending[0].depth = 0;
+
+    // the end points are collected and appended SEGMENT_BATCH at a time
+    float batch[SEGMENT_BATCH * n_motors];
+    size_t nb= 0;
+    bool moved= false;
+
+    while(top >= 0) {
+        if(THEKERNEL->is_halted()) return false; // don't queue any more segments
+
+        auto &c= pending[top];
+        if(c.depth < MAX_SEGMENT_DEPTH) {
+            // the curve stays within 3/4 of the furthest the inner control points are from the chord
+            float cx = c.p[3][0] - c.p[0][0];
+            float cy = c.p[3][1] - c.p[0][1];
+            float chord = hypotf(cx, cy);
+            float d = 0;
+            for (int i = 1; i <= 2; i++) {
+                float dx = c.p[i][0] - c.p[0][0];
+                float dy = c.p[i][1] - c.p[0][1];
+                float di = chord > 0.00001F ? fabsf(dx * cy - dy * cx) / chord : hypotf(dx, dy);
+                if(di > d) d = di;
+            }
+
+            bool split= 0.75F * d > tolerance;
+
+            if(!split && max_chord > 0) {
+                split= hypotf(chord, (target[Z_AXIS] - machine_position[Z_AXIS]) * (c.t1 - c.t0)) > max_chord;
+            }
+
+            if(!split && adaptive) {
+                // as append_adaptive_line, the middle of the chord in actuator space must be near where the arm solution puts it
+                float p0[n_motors], p1[n_motors], pm[n_motors];
+                position(c.t0, p0);
+                p0[X_AXIS] = c.p[0][0]; p0[Y_AXIS] = c.p[0][1];
+                position(c.t1, p1);
+                p1[X_AXIS] = c.p[3][0]; p1[Y_AXIS] = c.p[3][1];
+                position((c.t0 + c.t1) / 2, pm);
+                pm[X_AXIS] = (c.p[0][0] + c.p[3][0]) / 2; pm[Y_AXIS] = (c.p[0][1] + c.p[3][1]) / 2;
+                ActuatorCoordinates a0, a1, am;
+                arm_solution->cartesian_to_actuator(p0, a0);
+                arm_solution->cartesian_to_actuator(p1, a1);
+                arm_solution->cartesian_to_actuator(pm, am);
+                for (size_t i = X_AXIS; i <= Z_AXIS && !split; i++) {
+                    if(fabsf(am[i] - (a0[i] + a1[i]) / 2) > max_segment_error) split= true;
+                }
+            }
+
+            if(split) {
+                // split it in half with de Casteljau, the right half stays where it is and the left half is done first
+                float l[4][2], r[4][2];
+                for (int a = 0; a < 2; a++) {
+                    float p01 = (c.p[0][a] + c.p[1][a]) / 2, p12 = (c.p[1][a] + c.p[2][a]) / 2, p23 = (c.p[2][a] + c.p[3][a]) / 2;
+                    float p012 = (p01 + p12) / 2, p123 = (p12 + p23) / 2;
+                    float m = (p012 + p123) / 2;
+                    l[0][a] = c.p[0][a]; l[1][a] = p01; l[2][a] = p012; l[3][a] = m;
+                    r[0][a] = m; r[1][a] = p123; r[2][a] = p23; r[3][a] = c.p[3][a];
+                }
+                float t0 = c.t0;
+                float tm = (c.t0 + c.t1) / 2;
+                uint8_t depth = c.depth + 1;
+
+                memcpy(c.p, r, sizeof(r));
+                c.t0 = tm;
+                c.depth = depth;
+
+                ++top;
+                memcpy(pending[top].p, l, sizeof(l));
+                pending[top].t0 = t0;
+                pending[top].t1 = tm;
+                pending[top].depth = depth;
+                continue;
+            }
+        }
+
+        // this piece is close enough to its chord, the last one ends exactly at the target
+        float *p= &batch[nb * n_motors];
+        if(top == 0) {
+            memcpy(p, target, n_motors*sizeof(float));
+        }else{
+            position(c.t1, p);
+            p[X_AXIS] = c.p[3][0];
+            p[Y_AXIS] = c.p[3][1];
+        }
+        --top;
+
+        if(++nb == SEGMENT_BATCH || top < 0) {
+            if(this->append_milestones(batch, nb, rate_mm_s)) moved= true;
+            nb= 0;
+        }
+    }
 
     return moved;
 }
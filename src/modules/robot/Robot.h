@@ -32,6 +32,8 @@ class Robot : public Module {
         Robot();
         void on_module_loaded();
         void on_gcode_received(void* argument);
+        void on_halt(void *argument);
+        void check_fixed_kinematics();
 
         void reset_axis_position(float position, int axis);
         void reset_axis_position(float x, float y, float z);
@@ -97,14 +99,19 @@ class Robot : public Module {
             SEEK, // G0
             LINEAR, // G1
             CW_ARC, // G2
-            CCW_ARC // G3
+            CCW_ARC, // G3
+            BEZIER // G5
         };
 
         void load_config();
         bool append_milestone(const float target[], float rate_mm_s);
+        bool append_milestones(float targets[], size_t n, float rate_mm_s);
+        bool plan_milestone(const float transformed_target[], ActuatorCoordinates &actuator_pos, float rate_mm_s);
+        bool append_adaptive_line(const float target[], float millimeters_of_travel, float rate_mm_s);
         bool append_line( Gcode* gcode, const float target[], float rate_mm_s, float delta_e);
         bool append_arc( Gcode* gcode, const float target[], const float offset[], float radius, bool is_clockwise );
         bool compute_arc(Gcode* gcode, const float offset[], const float target[], enum MOTION_MODE_T motion_mode);
+        bool append_bezier(Gcode* gcode, const float target[], const float cp1[], const float cp2[], float delta_e);
         void process_move(Gcode *gcode, enum MOTION_MODE_T);
 
         float theta(float x, float y);
@@ -129,7 +136,11 @@ class Robot : public Module {
         float mm_per_line_segment;                           // Setting : Used to split lines into segments
         float mm_per_arc_segment;                            // Setting : Used to split arcs into segments
         float mm_max_arc_error;                              // Setting : Used to limit total arc segments to max error
+        float arc_acceleration;                              // Setting : centripetal acceleration limit for arcs, their chords are then joined at the arc speed
+        float arc_speed;                                     // speed the chords of the arc being planned are joined at, NAN when not planning an arc
+        float next_junction_speed;                           // passed to the planner for the next block, NAN uses the junction deviation
         float delta_segments_per_second;                     // Setting : Used to split lines into segments for delta based on speed
+        float max_segment_error;                             // Setting : Used to split lines into as few segments as keep the actuators within this of a straight line
         float seconds_per_minute;                            // for realtime speed change
         float default_acceleration;                          // the defualt accleration if not set for each axis
         float s_value;                                       // modal S value
@@ -143,6 +154,7 @@ class Robot : public Module {
         float max_speeds[3];                                 // Setting : max allowable speed in mm/s for each axis
 
         uint8_t n_motors;                                    //count of the motors/axis registered
+        bool wrong_arm_solution;                             // the configured arm solution is not the one a fixed kinematics build drives
 
         // Used by Planner
         friend class Planner;
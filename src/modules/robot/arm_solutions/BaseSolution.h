@@ -3,6 +3,7 @@
 #define BASESOLUTION_H
 
 #include <map>
+#include <stddef.h>
 #include "ActuatorCoordinates.h"
 
 class Config;
@@ -14,6 +15,12 @@ class BaseSolution {
         virtual ~BaseSolution() {};
         virtual void cartesian_to_actuator(const float[], ActuatorCoordinates &) const = 0;
         virtual void actuator_to_cartesian(const ActuatorCoordinates &, float[]) const = 0;
+        // converts n points in one call, point i starts at cartesian[i*stride] with XYZ first, only the arm actuators are set
+        // solutions with costly math override this with a tight loop, by default it is just one call per point
+        virtual void batch_cartesian_to_actuator(const float cartesian[], size_t stride, ActuatorCoordinates actuator[], size_t n) const
+        {
+            for (size_t i = 0; i < n; ++i) cartesian_to_actuator(&cartesian[i * stride], actuator[i]);
+        }
         typedef std::map<char, float> arm_options_t;
         virtual bool set_optional(const arm_options_t& options) { return false; };
         virtual bool get_optional(arm_options_t& options, bool force_all= false) const { return false; };
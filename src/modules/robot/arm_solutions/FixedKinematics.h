@@ -0,0 +1,65 @@
+#pragma once
+
+// Kinematics chosen at build time, make KINEMATICS=cartesian or KINEMATICS=corexy
+// These do the same as the matching arm solution but are inlined into the move path, so each point does not go through a
+// virtual call, and the number of motors is fixed at MAX_ROBOT_ACTUATORS so the loops and buffers there have constant sizes.
+// The arm solution object is still created, anything that is not on the move path uses it as usual.
+
+#include "ActuatorCoordinates.h"
+#include "libs/nuts_bolts.h"
+
+#include <stddef.h>
+
+class CartesianSolution;
+class HBotSolution;
+
+template<typename S>
+struct FixedKinematicsBase {
+    using solution_t= S;
+
+    template<typename K>
+    static inline void batch(const float cartesian_mm[], size_t stride, ActuatorCoordinates actuator_mm[], size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            K::cartesian_to_actuator(&cartesian_mm[i * stride], actuator_mm[i]);
+        }
+    }
+};
+
+struct CartesianKinematics : FixedKinematicsBase<CartesianSolution> {
+    static constexpr const char *name= "cartesian";
+    static constexpr const char *alias= "cartesian";
+    static inline void cartesian_to_actuator(const float cartesian_mm[], ActuatorCoordinates &actuator_mm)
+    {
+        actuator_mm[ALPHA_STEPPER] = cartesian_mm[X_AXIS];
+        actuator_mm[BETA_STEPPER ] = cartesian_mm[Y_AXIS];
+        actuator_mm[GAMMA_STEPPER] = cartesian_mm[Z_AXIS];
+    }
+    static inline void batch_cartesian_to_actuator(const float cartesian_mm[], size_t stride, ActuatorCoordinates actuator_mm[], size_t n)
+    {
+        batch<CartesianKinematics>(cartesian_mm, stride, actuator_mm, n);
+    }
+};
+
+struct CoreXYKinematics : FixedKinematicsBase<HBotSolution> {
+    static constexpr const char *name= "corexy";
+    static constexpr const char *alias= "hbot";
+    static inline void cartesian_to_actuator(const float cartesian_mm[], ActuatorCoordinates &actuator_mm)
+    {
+        actuator_mm[ALPHA_STEPPER] = cartesian_mm[X_AXIS] + cartesian_mm[Y_AXIS];
+        actuator_mm[BETA_STEPPER ] = cartesian_mm[X_AXIS] - cartesian_mm[Y_AXIS];
+        actuator_mm[GAMMA_STEPPER] = cartesian_mm[Z_AXIS];
+    }
+    static inline void batch_cartesian_to_actuator(const float cartesian_mm[], size_t stride, ActuatorCoordinates actuator_mm[], size_t n)
+    {
+        batch<CoreXYKinematics>(cartesian_mm, stride, actuator_mm, n);
+    }
+};
+
+#if defined(FIXED_KINEMATICS_CARTESIAN)
+    #define FIXED_KINEMATICS
+    using FixedKinematics= CartesianKinematics;
+#elif defined(FIXED_KINEMATICS_COREXY)
+    #define FIXED_KINEMATICS
+    using FixedKinematics= CoreXYKinematics;
+#endif
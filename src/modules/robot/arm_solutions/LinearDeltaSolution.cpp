@@ -73,6 +73,26 @@ void LinearDeltaSolution::cartesian_to_actuator(const float cartesian_mm[], Actu
                                       ) + cartesian_mm[Z_AXIS];
 }
 
+// same as above for a run of points, the geometry is loaded into locals once so the loop body is just the arithmetic
+void LinearDeltaSolution::batch_cartesian_to_actuator(const float cartesian_mm[], size_t stride, ActuatorCoordinates actuator_mm[], size_t n) const
+{
+    const float l2= arm_length_squared;
+    const float t1x= delta_tower1_x, t1y= delta_tower1_y;
+    const float t2x= delta_tower2_x, t2y= delta_tower2_y;
+    const float t3x= delta_tower3_x, t3y= delta_tower3_y;
+
+    for (size_t i = 0; i < n; ++i) {
+        const float *c= &cartesian_mm[i * stride];
+        const float x= c[X_AXIS], y= c[Y_AXIS], z= c[Z_AXIS];
+        const float d1x= t1x - x, d1y= t1y - y;
+        const float d2x= t2x - x, d2y= t2y - y;
+        const float d3x= t3x - x, d3y= t3y - y;
+        actuator_mm[i][ALPHA_STEPPER] = sqrtf(l2 - d1x * d1x - d1y * d1y) + z;
+        actuator_mm[i][BETA_STEPPER ] = sqrtf(l2 - d2x * d2x - d2y * d2y) + z;
+        actuator_mm[i][GAMMA_STEPPER] = sqrtf(l2 - d3x * d3x - d3y * d3y) + z;
+    }
+}
+
 void LinearDeltaSolution::actuator_to_cartesian(const ActuatorCoordinates &actuator_mm, float cartesian_mm[] ) const
 {
     // from http://en.wikipedia.org/wiki/Circumscribed_circle#Barycentric_coordinates_from_cross-_and_dot-products
@@ -101,6 +101,36 @@ void MorganSCARASolution::cartesian_to_actuator(const float cartesian_mm[], Actu
 
 }
 
+// same as above for a run of points, the constant parts are worked out once so the loop body is just the per point math
+void MorganSCARASolution::batch_cartesian_to_actuator(const float cartesian_mm[], size_t stride, ActuatorCoordinates actuator_mm[], size_t n) const
+{
+    const float offset_x= this->morgan_offset_x, offset_y= this->morgan_offset_y;
+    const float scaling_x= this->morgan_scaling_x, scaling_y= this->morgan_scaling_y;
+    const float c2_max= this->morgan_undefined_max, c2_min= -this->morgan_undefined_min;
+    const float l1= this->arm1_length, l2= this->arm2_length;
+    const float c2_sub= (l1 == l2) ? 2.0f * l1 * l1 : l1 * l1 + l2 * l2;
+    const float c2_div= 2.0f * l1 * l1;
+    const float degrees= 180.0F / 3.14159265359f;
+
+    for (size_t i = 0; i < n; ++i) {
+        const float *c= &cartesian_mm[i * stride];
+        const float x= (c[X_AXIS] - offset_x) * scaling_x;
+        const float y= c[Y_AXIS] * scaling_y - offset_y;
+
+        float c2= (x * x + y * y - c2_sub) / c2_div;
+        if (c2 > c2_max) c2= c2_max;
+        else if (c2 < c2_min) c2= c2_min;
+
+        const float s2= sqrtf(1.0f - c2 * c2);
+        const float theta= atan2f(l1 + l2 * c2, l2 * s2) - atan2f(x, y);
+        const float psi= atan2f(s2, c2);
+
+        actuator_mm[i][ALPHA_STEPPER] = theta * degrees;
+        actuator_mm[i][BETA_STEPPER ] = (theta + psi) * degrees;
+        actuator_mm[i][GAMMA_STEPPER] = c[Z_AXIS];
+    }
+}
+
 void MorganSCARASolution::actuator_to_cartesian(const ActuatorCoordinates &actuator_mm, float cartesian_mm[] ) const
 {
     // Perform forward kinematics, and place results in cartesian_mm[]
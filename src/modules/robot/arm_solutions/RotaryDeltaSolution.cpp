@@ -196,6 +196,62 @@ void RotaryDeltaSolution::cartesian_to_actuator(const float cartesian_mm[], Actu
 
 }
 
+// the YZ plane inverse of delta_calcAngleYZ with the geometry passed in, y1 and ye are the base and effector edge offsets
+// and k is rf² - re² - y1², returns false for a point that can't be reached
+static inline bool calc_angle_yz(float x0, float y0, float z0, float y1, float ye, float rf, float k, float &theta)
+{
+    y0 -= ye;
+    float a = (x0 * x0 + y0 * y0 + z0 * z0 + k) / (2.0F * z0);
+    float b = (y1 - y0) / z0;
+
+    float d = -(a + b * y1) * (a + b * y1) + rf * (b * b * rf + rf);
+    if (d < 0.0F) return false;
+
+    float yj = (y1 - a * b - sqrtf(d)) / (b * b + 1.0F);
+    float zj = a + b * yj;
+
+    theta = 180.0F * atanf(-zj / (y1 - yj)) / pi + ((yj > y1) ? 180.0F : 0.0F);
+    return true;
+}
+
+// same as cartesian_to_actuator for a run of points, the geometry is worked out once instead of three times per point
+void RotaryDeltaSolution::batch_cartesian_to_actuator(const float cartesian_mm[], size_t stride, ActuatorCoordinates actuator_mm[], size_t n) const
+{
+    if(debug_flag) {
+        // the single point version does the reporting
+        BaseSolution::batch_cartesian_to_actuator(cartesian_mm, stride, actuator_mm, n);
+        return;
+    }
+
+    const float y1 = -0.5F * tan30 * delta_f;
+    const float ye = 0.5F * tan30 * delta_e;
+    const float rf = delta_rf;
+    const float k = delta_rf * delta_rf - delta_re * delta_re - y1 * y1;
+    const float sign = mirror_xy ? -1.0F : 1.0F;
+
+    for (size_t i = 0; i < n; ++i) {
+        const float *c= &cartesian_mm[i * stride];
+        const float x0 = c[X_AXIS] * sign;
+        const float y0 = c[Y_AXIS] * sign;
+        const float z0 = c[Z_AXIS] + z_calc_offset;
+
+        float alpha, beta, gamma;
+        if(calc_angle_yz(x0, y0, z0, y1, ye, rf, k, alpha) &&
+           calc_angle_yz(x0 * cos120 + y0 * sin120, y0 * cos120 - x0 * sin120, z0, y1, ye, rf, k, beta) &&
+           calc_angle_yz(x0 * cos120 - y0 * sin120, y0 * cos120 + x0 * sin120, z0, y1, ye, rf, k, gamma)) {
+            actuator_mm[i][ALPHA_STEPPER] = alpha;
+            actuator_mm[i][BETA_STEPPER ] = beta;
+            actuator_mm[i][GAMMA_STEPPER] = gamma;
+
+        } else {
+            // same as the single point version, go to the home position as we know that is valid
+            actuator_mm[i][ALPHA_STEPPER] = 0;
+            actuator_mm[i][BETA_STEPPER ] = 0;
+            actuator_mm[i][GAMMA_STEPPER] = 0;
+        }
+    }
+}
+
 void RotaryDeltaSolution::actuator_to_cartesian(const ActuatorCoordinates &actuator_mm, float cartesian_mm[] ) const
 {
     float x, y, z;
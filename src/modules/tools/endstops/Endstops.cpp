@@ -15,6 +15,8 @@
 #include "libs/Pin.h"
 #include "libs/StepperMotor.h"
 #include "wait_api.h" // mbed.h lib
+#include "us_ticker_api.h" // mbed.h lib
+#include "InterruptIn.h" // mbed.h lib
 #include "Robot.h"
 #include "Config.h"
 #include "SlowTicker.h"
@@ -24,7 +26,9 @@
 #include "ConfigValue.h"
 #include "libs/StreamOutput.h"
 #include "PublicDataRequest.h"
+#include "PublicData.h"
 #include "EndstopsPublicAccess.h"
+#include "MotorDriverControlPublicAccess.h"
 #include "StreamOutputPool.h"
 #include "StepTicker.h"
 #include "BaseSolution.h"
@@ -60,6 +64,8 @@ enum DEFNS {MIN_PIN, MAX_PIN, MAX_TRAVEL, FAST_RATE, SLOW_RATE, RETRACT, DIRECTI
 
 #define endstop_debounce_count_checksum  CHECKSUM("endstop_debounce_count")
 #define endstop_debounce_ms_checksum     CHECKSUM("endstop_debounce_ms")
+#define endstop_interrupt_checksum       CHECKSUM("endstop_interrupt_enable")
+#define endstop_glitch_us_checksum       CHECKSUM("endstop_glitch_filter_us")
 
 #define home_z_first_checksum            CHECKSUM("home_z_first")
 #define homing_order_checksum            CHECKSUM("homing_order")
@@ -86,6 +92,7 @@ enum DEFNS {MIN_PIN, MAX_PIN, MAX_TRAVEL, FAST_RATE, SLOW_RATE, RETRACT, DIRECTI
 #define max_travel_checksum                CHECKSUM("max_travel")
 #define retract_checksum                   CHECKSUM("retract")
 #define limit_checksum                     CHECKSUM("limit_enable")
+#define sensorless_checksum                CHECKSUM("sensorless")
 
 #define STEPPER THEROBOT->actuators
 #define STEPS_PER_MM(a) (STEPPER[a]->get_steps_per_mm())
@@ -128,9 +135,47 @@ void Endstops::on_module_loaded()
     register_for_event(ON_GCODE_RECEIVED);
     register_for_event(ON_GET_PUBLIC_DATA);
     register_for_event(ON_SET_PUBLIC_DATA);
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, endstops_checksum);
+    PublicData::register_handler(ON_SET_PUBLIC_DATA, this, endstops_checksum);
 
 
     THEKERNEL->slow_ticker->attach(1000, this, &Endstops::read_endstops);
+
+    if(this->use_interrupts) setup_interrupts();
+}
+
+// In interrupt mode the homing endstops on port 0 or 2 stop their motors from the step ticker once a pin interrupt has
+// been held for glitch_us, this removes the up to 1-2ms latency of the polled read_endstops, which is still called for all endstops
+// as a backstop (eg if the endstop was already triggered when the move started so there was no edge)
+void Endstops::setup_interrupts()
+{
+    for(auto& e : homing_axis) {
+        if(e.pin_info == nullptr || e.pin_info->sensorless) continue;
+
+        // use a copy as interrupt_pin() invalidates pins that are not interrupt capable
+        Pin dummy_pin= e.pin_info->pin;
+        mbed::InterruptIn *ip= dummy_pin.interrupt_pin();
+        if(ip == nullptr) {
+            THEKERNEL->streams->printf("WARNING: endstop %c is not on an interrupt capable pin, it will be polled\n", e.axis);
+            continue;
+        }
+
+        // the edge that triggers the endstop depends on if the pin is inverted
+        if(e.pin_info->pin.is_inverting()) {
+            ip->fall(this, &Endstops::on_endstop_edge);
+        }else{
+            ip->rise(this, &Endstops::on_endstop_edge);
+        }
+        e.pin_info->use_interrupt= true;
+        edge_pins.push_back(ip);
+    }
+
+    if(!edge_pins.empty()) {
+        // same priority as the step ticker so neither preempts the other
+        NVIC_SetPriority(EINT3_IRQn, 2);
+        // the step ticker has not been started yet so this is safe to set
+        THEKERNEL->step_ticker->tick_fnc= std::bind(&Endstops::check_edges, this);
+    }
 }
 
 // Get config using old deprecated syntax Does not support ABC
@@ -188,8 +233,12 @@ bool Endstops::load_old_config()
 
             // init struct
             info->debounce= 0;
+            info->edge_pending= false;
             info->axis= 'X'+i;
             info->axis_index= i;
+            info->use_interrupt= false;
+            info->sensorless= false;
+            info->load= nullptr;
 
             // limits enabled
             info->limit_enable= THEKERNEL->config->value(checksums[i][LIMIT])->by_default(false)->as_bool();
@@ -247,7 +296,10 @@ bool Endstops::load_config()
 
         endstop_info_t *pin_info= new endstop_info_t;
         pin_info->pin.from_string(THEKERNEL->config->value(endstop_checksum, cs, pin_checksum)->by_default("nc" )->as_string())->as_input();
-        if(!pin_info->pin.connected()){
+
+        // a sensorless endstop is triggered by the stallguard of the axis motor instead of a pin, see motor_driver_control stallguard_rate
+        bool sensorless= THEKERNEL->config->value(endstop_checksum, cs, sensorless_checksum)->by_default(false)->as_bool();
+        if(!sensorless && !pin_info->pin.connected()){
             // no pin defined try next
             delete pin_info;
             continue;
@@ -275,11 +327,15 @@ bool Endstops::load_config()
 
         // init pin struct
         pin_info->debounce= 0;
+        pin_info->edge_pending= false;
         pin_info->axis= toupper(axis[0]);
         pin_info->axis_index= i;
+        pin_info->use_interrupt= false;
+        pin_info->sensorless= sensorless;
+        pin_info->load= nullptr;
 
-        // are limits enabled
-        pin_info->limit_enable= THEKERNEL->config->value(endstop_checksum, cs, limit_checksum)->by_default(false)->as_bool();
+        // are limits enabled, a stall only means anything when homing
+        pin_info->limit_enable= !sensorless && THEKERNEL->config->value(endstop_checksum, cs, limit_checksum)->by_default(false)->as_bool();
         limit_enabled |= pin_info->limit_enable;
 
         // enter into endstop array
@@ -363,6 +419,10 @@ void Endstops::get_global_configs()
     this->debounce_ms= THEKERNEL->config->value(endstop_debounce_ms_checksum)->by_default(0)->as_number();
     this->debounce_count= THEKERNEL->config->value(endstop_debounce_count_checksum)->by_default(100)->as_number();
 
+    // optionally stop the motors from a pin interrupt, with a short glitch filter in microseconds instead of the ms debounce
+    this->use_interrupts= THEKERNEL->config->value(endstop_interrupt_checksum)->by_default(false)->as_bool();
+    this->glitch_us= THEKERNEL->config->value(endstop_glitch_us_checksum)->by_default(5)->as_number();
+
     this->is_corexy= THEKERNEL->config->value(corexy_homing_checksum)->by_default(false)->as_bool();
     this->is_delta=  THEKERNEL->config->value(delta_homing_checksum)->by_default(false)->as_bool();
     this->is_rdelta= THEKERNEL->config->value(rdelta_homing_checksum)->by_default(false)->as_bool();
@@ -528,6 +588,72 @@ void Endstops::move_to_origin(axis_bitmap_t axis)
     this->status = NOT_HOMING;
 }
 
+// stops the motor(s) for the given homing axis and records where it was when the endstop triggered, called from an ISR
+void Endstops::trigger_endstop(homing_info_t& e)
+{
+    int m= e.axis_index;
+    if(!e.triggered) {
+        e.trigger_steps= (int32_t)STEPPER[m]->get_current_step();
+        e.triggered= true;
+    }
+
+    if(is_corexy && (m == X_AXIS || m == Y_AXIS)) {
+        // corexy when moving in X or Y we need to stop both the X and Y motors
+        STEPPER[X_AXIS]->stop_moving();
+        STEPPER[Y_AXIS]->stop_moving();
+
+    }else{
+        // we signal the motor to stop, which will preempt any moves on that axis
+        STEPPER[m]->stop_moving();
+    }
+}
+
+// Called from the EINT3 ISR on the triggering edge of any interrupt enabled homing endstop, this only notes when the
+// edge happened, check_edges triggers the endstop once the pin has stayed asserted for glitch_us
+void Endstops::on_endstop_edge()
+{
+    if(this->status != MOVING_TO_ENDSTOP_SLOW && this->status != MOVING_TO_ENDSTOP_FAST) return; // not doing anything we need to monitor for
+
+    uint32_t now= us_ticker_read();
+    for(auto& e : homing_axis) {
+        if(e.pin_info == nullptr || !e.pin_info->use_interrupt || e.pin_info->edge_pending) continue;
+
+        if(e.pin_info->pin.get()) {
+            e.pin_info->edge_time= now;
+            e.pin_info->edge_pending= true;
+            edges_pending= true;
+        }
+    }
+}
+
+// Called from the step ticker ISR on every tick of a block, a pin that drops before glitch_us was a glitch
+void Endstops::check_edges()
+{
+    if(!edges_pending) return;
+
+    bool homing= this->status == MOVING_TO_ENDSTOP_SLOW || this->status == MOVING_TO_ENDSTOP_FAST;
+    uint32_t now= us_ticker_read();
+    bool pending= false;
+    for(auto& e : homing_axis) {
+        if(e.pin_info == nullptr || !e.pin_info->edge_pending) continue;
+        int m= e.axis_index;
+
+        if(!homing || !e.pin_info->pin.get()) {
+            e.pin_info->edge_pending= false;
+
+        } else if((now - e.pin_info->edge_time) >= glitch_us) {
+            e.pin_info->edge_pending= false;
+            // for corexy homing in X or Y we must only check the associated endstop
+            if(is_corexy && (m == X_AXIS || m == Y_AXIS) && !axis_to_home[m]) continue;
+            if(STEPPER[m]->is_moving()) trigger_endstop(e);
+
+        } else {
+            pending= true;
+        }
+    }
+    edges_pending= pending;
+}
+
 // Called every millisecond in an ISR
 uint32_t Endstops::read_endstops(uint32_t dummy)
 {
@@ -542,21 +668,19 @@ uint32_t Endstops::read_endstops(uint32_t dummy)
         if(is_corexy && (m == X_AXIS || m == Y_AXIS) && !axis_to_home[m]) continue;
 
         if(STEPPER[m]->is_moving()) {
+            if(e.pin_info->load != nullptr) {
+                // sensorless, the stall has already been filtered by the sampling
+                if(e.pin_info->load->stalled) trigger_endstop(e);
+                continue;
+            }
+
             // if it is moving then we check the associated endstop, and debounce it
             if(e.pin_info->pin.get()) {
                 if(e.pin_info->debounce < debounce_ms) {
                     e.pin_info->debounce++;
 
                 } else {
-                    if(is_corexy && (m == X_AXIS || m == Y_AXIS)) {
-                        // corexy when moving in X or Y we need to stop both the X and Y motors
-                        STEPPER[X_AXIS]->stop_moving();
-                        STEPPER[Y_AXIS]->stop_moving();
-
-                    }else{
-                        // we signal the motor to stop, which will preempt any moves on that axis
-                        STEPPER[m]->stop_moving();
-                    }
+                    trigger_endstop(e);
                 }
 
             } else {
@@ -596,11 +720,49 @@ void Endstops::home_xy()
     THECONVEYOR->wait_for_idle();
 }
 
+// find the stallguard telemetry for the sensorless endstops, the motor drivers are loaded after us so this is done when homing
+bool Endstops::setup_sensorless(axis_bitmap_t a)
+{
+    for(auto& e : homing_axis) {
+        if(!a[e.axis_index] || e.pin_info == nullptr || !e.pin_info->sensorless || e.pin_info->load != nullptr) continue;
+
+        void *returned_data;
+        if(PublicData::get_value(motor_driver_control_checksum, motor_load_checksum, get_checksum(string(1, e.axis)), &returned_data)) {
+            e.pin_info->load= static_cast<pad_motor_load_t *>(returned_data);
+
+        }else{
+            THEKERNEL->streams->printf("ERROR: sensorless endstop %c needs stallguard_rate set on its motor driver\n", e.axis);
+            return false;
+        }
+    }
+    return true;
+}
+
+// clear any stall seen so far, and tell the motor drivers stalls are expected while homing
+void Endstops::arm_sensorless(bool homing)
+{
+    for(auto& e : homing_axis) {
+        if(e.pin_info == nullptr || e.pin_info->load == nullptr) continue;
+        e.pin_info->load->homing= homing && axis_to_home[e.axis_index];
+        e.pin_info->load->stalled= false;
+    }
+}
+
 void Endstops::home(axis_bitmap_t a)
 {
+    if(!setup_sensorless(a)) {
+        THEKERNEL->call_event(ON_HALT, nullptr);
+        return;
+    }
+
     // reset debounce counts for all endstops
     for(auto& e : endstops) {
        e->debounce= 0;
+       e->edge_pending= false;
+    }
+    edges_pending= false;
+    for(auto& e : homing_axis) {
+       e.triggered= false;
     }
 
     if (is_scara) {
@@ -608,6 +770,7 @@ void Endstops::home(axis_bitmap_t a)
     }
 
     this->axis_to_home= a;
+    arm_sensorless(true);
 
     // Start moving the axes to the origin
     this->status = MOVING_TO_ENDSTOP_FAST;
@@ -657,12 +820,21 @@ void Endstops::home(axis_bitmap_t a)
     float delta[homing_axis.size()];
     for (size_t i = 0; i < homing_axis.size(); ++i) delta[i]= 0;
 
+    // on cartesians the actuator is the axis, so we know how far it overshot the trigger point
+    bool compensate_overshoot= !(is_corexy || is_delta || is_rdelta || is_scara);
+
     // use minimum feed rate of all axes that are being homed (sub optimal, but necessary)
     float feed_rate= homing_axis[X_AXIS].slow_rate;
     for (auto& i : homing_axis) {
         int c= i.axis_index;
         if(axis_to_home[c]) {
             delta[c]= i.retract;
+            if(compensate_overshoot && i.triggered) {
+                // back off from where the endstop triggered rather than from where the motor stopped,
+                // so the slow approach always starts the same distance from the endstop
+                int32_t overshoot= abs((int32_t)STEPPER[c]->get_current_step() - i.trigger_steps);
+                delta[c] += overshoot / STEPS_PER_MM(c);
+            }
             if(!i.home_direction) delta[c]= -delta[c];
             feed_rate= std::min(i.slow_rate, feed_rate);
         }
@@ -673,6 +845,7 @@ void Endstops::home(axis_bitmap_t a)
     THECONVEYOR->wait_for_idle();
 
     // Start moving the axes towards the endstops slowly
+    arm_sensorless(true);
     this->status = MOVING_TO_ENDSTOP_SLOW;
     for (auto& i : homing_axis) {
         int c= i.axis_index;
@@ -697,6 +870,7 @@ void Endstops::home(axis_bitmap_t a)
         THEROBOT->disable_arm_solution = false;  // Arm solution enabled again.
     }
 
+    arm_sensorless(false);
     this->status = NOT_HOMING;
 }
 
@@ -1007,12 +1181,17 @@ void Endstops::on_gcode_received(void *argument)
                 for(auto& h : homing_axis) {
                     string name;
                     name.append(1, h.axis).append(h.home_direction ? "_min" : "_max");
-                    gcode->stream->printf("%s:%d ", name.c_str(), h.pin_info->pin.get());
+                    bool triggered= h.pin_info->load != nullptr ? h.pin_info->load->stalled : h.pin_info->pin.get();
+                    gcode->stream->printf("%s:%d ", name.c_str(), triggered);
                 }
                 gcode->stream->printf("pins- ");
                 for(auto& p : endstops) {
                     string str(1, p->axis);
                     if(p->limit_enable) str.append("L");
+                    if(p->sensorless) {
+                        gcode->stream->printf("(%s)stall:%d ", str.c_str(), p->load != nullptr && p->load->stalled);
+                        continue;
+                    }
                     gcode->stream->printf("(%s)P%d.%d:%d ", str.c_str(), p->pin.port_number, p->pin.pin, p->pin.get());
                 }
                 gcode->add_nl = true;
@@ -1135,5 +1314,6 @@ void Endstops::on_set_public_data(void* argument)
         if(!isnan(t[0])) homing_axis[0].home_offset= t[0];
         if(!isnan(t[1])) homing_axis[1].home_offset= t[1];
         if(!isnan(t[2])) homing_axis[2].home_offset= t[2];
+        pdr->set_taken();
     }
 }
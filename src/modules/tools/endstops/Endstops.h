@@ -17,6 +17,11 @@
 class StepperMotor;
 class Gcode;
 class Pin;
+struct pad_motor_load;
+
+namespace mbed {
+    class InterruptIn;
+}
 
 class Endstops : public Module{
     public:
@@ -40,12 +45,18 @@ class Endstops : public Module{
         void process_home_command(Gcode* gcode);
         void set_homing_offset(Gcode* gcode);
         uint32_t read_endstops(uint32_t dummy);
+        void setup_interrupts();
+        void on_endstop_edge();
+        void check_edges();
         void handle_park(Gcode * gcode);
+        bool setup_sensorless(axis_bitmap_t a);
+        void arm_sensorless(bool homing);
 
         // global settings
         float saved_position[3]{0}; // save G28 (in grbl mode)
         uint32_t debounce_count;
         uint32_t  debounce_ms;
+        uint32_t  glitch_us;
         axis_bitmap_t axis_to_home;
 
         float trim_mm[3];
@@ -53,11 +64,16 @@ class Endstops : public Module{
         // per endstop settings
         using endstop_info_t = struct {
             Pin pin;
+            pad_motor_load *load; // stallguard telemetry of the motor when sensorless, set when homing starts
+            volatile uint32_t edge_time; // us_ticker time of the last edge in interrupt mode
+            volatile bool edge_pending;  // the edge has not yet been held for glitch_us, not in the bitfield as ISRs write it
             struct {
                 uint16_t debounce:16;
                 char axis:8; // one of XYZABC
                 uint8_t axis_index:3;
                 bool limit_enable:1;
+                bool use_interrupt:1; // triggered by a pin interrupt as well as polled
+                bool sensorless:1; // triggered by the motor stalling instead of the pin
             };
         };
 
@@ -69,21 +85,29 @@ class Endstops : public Module{
             float fast_rate;
             float slow_rate;
             endstop_info_t *pin_info;
+            volatile int32_t trigger_steps; // actuator position when the endstop was hit
 
             struct {
                 char axis:8; // one of XYZABC
                 uint8_t axis_index:3;
                 bool home_direction:1; // true min or false max
                 bool homed:1;
+                volatile bool triggered:1;
             };
         };
 
+        void trigger_endstop(homing_info_t& e);
+
         // array of endstops
         std::vector<endstop_info_t *> endstops;
 
         // axis that can be homed, 0,1,2 always there and optionally 3 is A, 4 is B, 5 is C
         std::vector<homing_info_t> homing_axis;
 
+        // interrupt pins for endstops on port 0 or 2 when interrupt mode is enabled
+        std::vector<mbed::InterruptIn *> edge_pins;
+        volatile bool edges_pending{false}; // any endstop has an edge_pending
+
         // Global state
         struct {
             uint32_t homing_order:18;
@@ -94,5 +118,6 @@ class Endstops : public Module{
             bool is_scara:1;
             bool home_z_first:1;
             bool move_to_origin_after_home:1;
+            bool use_interrupts:1;
         };
 };
@@ -22,6 +22,7 @@
 #include "Gcode.h"
 #include "libs/StreamOutput.h"
 #include "PublicDataRequest.h"
+#include "PublicData.h"
 #include "StreamOutputPool.h"
 #include "ExtruderPublicAccess.h"
 
@@ -59,6 +60,9 @@
 #define retract_zlift_length_checksum        CHECKSUM("retract_zlift_length")
 #define retract_zlift_feedrate_checksum      CHECKSUM("retract_zlift_feedrate")
 
+#define pressure_advance_checksum            CHECKSUM("pressure_advance")
+#define pressure_advance_smoothing_checksum  CHECKSUM("pressure_advance_smoothing")
+
 #define PI 3.14159265358979F
 
 
@@ -95,6 +99,10 @@ void Extruder::on_module_loaded()
     this->register_for_event(ON_GCODE_RECEIVED);
     this->register_for_event(ON_GET_PUBLIC_DATA);
     this->register_for_event(ON_SET_PUBLIC_DATA);
+
+    // Robot asks the extruder about every G1 so route those straight here
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, extruder_checksum);
+    PublicData::register_handler(ON_SET_PUBLIC_DATA, this, extruder_checksum);
 }
 
 // Get config
@@ -134,6 +142,11 @@ void Extruder::config_load()
     stepper_motor->change_steps_per_mm(steps_per_millimeter);
     stepper_motor->set_selected(false); // not selected by default
     stepper_motor->set_extruder(true);  // indicates it is an extruder
+
+    // pressure advance in seconds, 0 disables it
+    float pressure_advance = THEKERNEL->config->value(extruder_checksum, this->identifier, pressure_advance_checksum)->by_default(0)->as_number();
+    float advance_smoothing = THEKERNEL->config->value(extruder_checksum, this->identifier, pressure_advance_smoothing_checksum)->by_default(0)->as_number();
+    stepper_motor->set_pressure_advance(pressure_advance, advance_smoothing);
 }
 
 void Extruder::select()
@@ -157,7 +170,8 @@ void Extruder::on_get_public_data(void *argument)
 
     if(!pdr->starts_with(extruder_checksum)) return;
 
-    if(!this->selected) return;
+    // an extruder asked for by name answers even when it is not selected, otherwise only the selected one does
+    if(!pdr->second_element_is(this->identifier) && !this->selected) return;
 
     // pointer to structure to return data to is provided
     pad_extruder_t *e = static_cast<pad_extruder_t *>(pdr->get_data_ptr());
@@ -167,6 +181,8 @@ void Extruder::on_get_public_data(void *argument)
     e->accleration = stepper_motor->get_acceleration();
     e->retract_length = this->retract_length;
     e->current_position = stepper_motor->get_current_position();
+    e->motor_id = this->motor_id;
+    e->selected = this->selected;
     pdr->set_taken();
 }
 
@@ -325,6 +341,18 @@ void Extruder::on_gcode_received(void *argument)
             if(gcode->has_letter('S')) retract_recover_length = gcode->get_value('S');
             if(gcode->has_letter('F')) retract_recover_feedrate = gcode->get_value('F') / 60.0F; // specified in mm/min converted to mm/sec
 
+        } else if (gcode->m == 900 && ( (this->selected && !gcode->has_letter('P')) || (gcode->has_letter('P') && gcode->get_value('P') == this->identifier)) ) {
+            // M900 Kxxx Syyy - set pressure advance xxx seconds and its smoothing time yyy seconds, K0 disables it
+            // only affects moves planned after this
+            if(gcode->has_letter('K') || gcode->has_letter('S')) {
+                float k = gcode->has_letter('K') ? gcode->get_value('K') : stepper_motor->get_pressure_advance();
+                float s = gcode->has_letter('S') ? gcode->get_value('S') : stepper_motor->get_advance_smoothing();
+                stepper_motor->set_pressure_advance(k, s);
+
+            } else {
+                gcode->stream->printf("Pressure advance K:%1.4f S:%1.4f\n", stepper_motor->get_pressure_advance(), stepper_motor->get_advance_smoothing());
+            }
+
         } else if (gcode->m == 221 && this->selected) { // M221 S100 change flow rate by percentage
             if(gcode->has_letter('S')) {
                 float last_scale = this->extruder_multiplier;
@@ -350,6 +378,9 @@ void Extruder::on_gcode_received(void *argument)
             if(this->max_volumetric_rate > 0) {
                 gcode->stream->printf(";E max volumetric rate mm³/sec:\nM203 V%1.4f P%d\n", this->max_volumetric_rate, this->identifier);
             }
+            if(stepper_motor->get_pressure_advance() > 0) {
+                gcode->stream->printf(";E pressure advance secs, smoothing secs:\nM900 K%1.4f S%1.4f P%d\n", stepper_motor->get_pressure_advance(), stepper_motor->get_advance_smoothing(), this->identifier);
+            }
         }
 
     } else if( gcode->has_g && this->selected ) {
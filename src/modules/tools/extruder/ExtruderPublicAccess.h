@@ -12,4 +12,6 @@ using pad_extruder_t = struct pad_extruder {
     float accleration;
     float retract_length;
     float current_position;
+    uint8_t motor_id;
+    bool selected;
 };
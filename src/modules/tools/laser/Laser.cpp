@@ -23,6 +23,7 @@
 #include "Gcode.h"
 #include "PwmOut.h" // mbed.h lib
 #include "PublicDataRequest.h"
+#include "PublicData.h"
 
 #include <algorithm>
 
@@ -62,7 +63,8 @@ void Laser::on_module_loaded()
     if (!dummy_pin->connected())
         dummy_pin->from_string(THEKERNEL->config->value(laser_module_pwm_pin_checksum)->by_default("nc")->as_string())->as_output();
 
-    pwm_pin = dummy_pin->hardware_pwm();
+    uint32_t period= THEKERNEL->config->value(laser_module_pwm_period_checksum)->by_default(20)->as_number();
+    pwm_pin = dummy_pin->hardware_pwm(period);
 
     if (pwm_pin == NULL) {
         THEKERNEL->streams->printf("Error: Laser cannot use P%d.%d (P2.0 - P2.5, P1.18, P1.20, P1.21, P1.23, P1.24, P1.26, P3.25, P3.26 only). Laser module disabled.\n", dummy_pin->port_number, dummy_pin->pin);
@@ -90,8 +92,6 @@ void Laser::on_module_loaded()
     }
 
 
-    uint32_t period= THEKERNEL->config->value(laser_module_pwm_period_checksum)->by_default(20)->as_number();
-    this->pwm_pin->period_us(period);
     this->pwm_pin->write(this->pwm_inverting ? 1 : 0);
     this->laser_maximum_power = THEKERNEL->config->value(laser_module_maximum_power_checksum)->by_default(1.0f)->as_number() ;
 
@@ -111,6 +111,7 @@ void Laser::on_module_loaded()
     this->register_for_event(ON_GCODE_RECEIVED);
     this->register_for_event(ON_CONSOLE_LINE_RECEIVED);
     this->register_for_event(ON_GET_PUBLIC_DATA);
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, laser_checksum);
 
     // no point in updating the power more than the PWM frequency, but no more than 1KHz
     THEKERNEL->slow_ticker->attach(std::min(1000UL, 1000000/period), this, &Laser::set_proportional_power);
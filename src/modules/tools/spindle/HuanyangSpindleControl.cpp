@@ -78,24 +78,11 @@
 
 void HuanyangSpindleControl::turn_on() 
 {
-    // prepare data for the spindle off command
-    char turn_on_msg[6] = { 0x01, 0x03, 0x01, 0x01, 0x00, 0x00 };
-    // calculate CRC16 checksum
-    unsigned int crc = modbus->crc16(turn_on_msg, sizeof(turn_on_msg)-2);
-    turn_on_msg[4] = crc & 0xFF;
-    turn_on_msg[5] = (crc >> 8);
-
-    // enable transmitter
-    modbus->dir_output->set();
-    modbus->delay(1);
-    // send the actual message
-    modbus->serial->write(turn_on_msg, sizeof(turn_on_msg));
-    // wait a calculated time for the data to be sent 
-    modbus->delay((int) ceil(sizeof(turn_on_msg) * modbus->delay_time));
-    // disable transmitter
-    modbus->dir_output->clear();
-    // wait 50ms, required by the Modbus standard
-    modbus->delay(50);
+    // prepare data for the spindle on command, the CRC16 checksum is added by modbus
+    char turn_on_msg[4] = { 0x01, 0x03, 0x01, 0x01 };
+    // send it once the moves queued before it are done, and wait for it to go out so the spindle is on before the next move
+    modbus->send_frame(turn_on_msg, sizeof(turn_on_msg), 0, nullptr, true);
+    modbus->wait_for_idle();
     spindle_on = true;
 
 }
@@ -103,23 +90,8 @@ void HuanyangSpindleControl::turn_on()
 void HuanyangSpindleControl::turn_off() 
 {
     // prepare data for the spindle off command
-    char turn_off_msg[6] = { 0x01, 0x03, 0x01, 0x08, 0x00, 0x00 };
-    // calculate CRC16 checksum
-    unsigned int crc = modbus->crc16(turn_off_msg, sizeof(turn_off_msg)-2);
-    turn_off_msg[4] = crc & 0xFF;
-    turn_off_msg[5] = (crc >> 8);
-
-    // enable transmitter
-    modbus->dir_output->set();
-    modbus->delay(1);
-    // send the actual message
-    modbus->serial->write(turn_off_msg, sizeof(turn_off_msg));
-    // wait a calculated time for the data to be sent 
-    modbus->delay((int) ceil(sizeof(turn_off_msg) * modbus->delay_time));
-    // disable transmitter
-    modbus->dir_output->clear();
-    // wait 50ms, required by the Modbus standard
-    modbus->delay(50);
+    char turn_off_msg[4] = { 0x01, 0x03, 0x01, 0x08 };
+    modbus->send_frame(turn_off_msg, sizeof(turn_off_msg), 0, nullptr, true);
     spindle_on = false;
 
 }
@@ -128,69 +100,31 @@ void HuanyangSpindleControl::set_speed(int target_rpm)
 {
 
     // prepare data for the set speed command
-    char set_speed_msg[7] = { 0x01, 0x05, 0x02, 0x00, 0x00, 0x00, 0x00 };
+    char set_speed_msg[5] = { 0x01, 0x05, 0x02, 0x00, 0x00 };
     // convert RPM into Hz
     unsigned int hz = target_rpm / 60 * 100; 
     set_speed_msg[3] = (hz >> 8);
     set_speed_msg[4] = hz & 0xFF;
-    // calculate CRC16 checksum
-    unsigned int crc = modbus->crc16(set_speed_msg, sizeof(set_speed_msg)-2);
-    set_speed_msg[5] = crc & 0xFF;
-    set_speed_msg[6] = (crc >> 8);
-
-    // enable transmitter
-    modbus->dir_output->set();
-    modbus->delay(1);
-    // send the actual message
-    modbus->serial->write(set_speed_msg, sizeof(set_speed_msg));
-    // wait a calculated time for the data to be sent 
-    modbus->delay((int) ceil(sizeof(set_speed_msg) * modbus->delay_time));
-    // disable transmitter
-    modbus->dir_output->clear();
-    // wait 50ms, required by the Modbus standard
-    modbus->delay(50);
+    modbus->send_frame(set_speed_msg, sizeof(set_speed_msg), 0, nullptr, true);
 
 }
 
 void HuanyangSpindleControl::report_speed() 
 {
-    // clear RX buffer before start
-    while(modbus->serial->readable()){
-        modbus->serial->getc();
-    }
-
     // prepare data for the get speed command
-    char get_speed_msg[8] = { 0x01, 0x04, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    // calculate CRC16 checksum
-    unsigned int crc = modbus->crc16(get_speed_msg, sizeof(get_speed_msg)-2);
-    get_speed_msg[6] = crc & 0xFF;
-    get_speed_msg[7] = (crc >> 8);
-
-    // enable transmitter
-    modbus->dir_output->set();
-    modbus->delay(1);
-    // send the actual message
-    modbus->serial->write(get_speed_msg, sizeof(get_speed_msg));
-    // wait a calculated time for the data to be sent 
-    modbus->delay((int) ceil(sizeof(get_speed_msg) * modbus->delay_time));
-    // disable transmitter
-    modbus->dir_output->clear();
-    // wait 50ms, required by the Modbus standard
-    modbus->delay(50);
-
-    // wait for the complete message to be received
-    modbus->delay((int) ceil(8 * modbus->delay_time));
-    // prepare an array for the answer
-    char speed[8] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-   
-    // read the answer into the buffer
-    for(int i=0; i<8; i++) {
-        speed[i] = modbus->serial->getc();
-    }
-    // get the Hz value from trhe answer and convert it into an RPM value
-    unsigned int hz = (speed[4] << 8) | speed[5];
-    unsigned int rpm = hz / 100 * 60;
-
-    // report the current RPM value
-    THEKERNEL->streams->printf("Current RPM: %d\n", rpm);
+    char get_speed_msg[6] = { 0x01, 0x04, 0x03, 0x00, 0x00, 0x00 };
+
+    // the answer is 8 bytes, it is reported when it arrives
+    modbus->send_frame(get_speed_msg, sizeof(get_speed_msg), 8, [](bool ok, const char *reply, uint8_t len) {
+        if(!ok) {
+            THEKERNEL->streams->printf("Spindle did not answer\n");
+            return;
+        }
+        // get the Hz value from the answer and convert it into an RPM value
+        unsigned int hz = ((uint8_t)reply[4] << 8) | (uint8_t)reply[5];
+        unsigned int rpm = hz / 100 * 60;
+
+        // report the current RPM value
+        THEKERNEL->streams->printf("Current RPM: %d\n", rpm);
+    });
 }
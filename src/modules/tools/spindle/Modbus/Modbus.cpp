@@ -8,83 +8,203 @@
 #include "libs/Module.h"
 #include "libs/Kernel.h"
 #include "libs/nuts_bolts.h"
-#include "libs/gpio.h"
-#include "BufferedSoftSerial.h"
+#include "Conveyor.h"
+#include "ModbusTransport.h"
 #include "Modbus.h"
 
-Modbus::Modbus( PinName tx_pin, PinName rx_pin, PinName dir_pin){
-    serial = new BufferedSoftSerial( tx_pin, rx_pin );
-    serial->baud(9600);
-    serial->format(8,serial->Parity::None,1);
-    calculate_delay(9600, 8, 0, 1);
-    dir_output = new GPIO(dir_pin);
-    dir_output->output();
-    dir_output->clear();
-}
-
-Modbus::Modbus( PinName tx_pin, PinName rx_pin, PinName dir_pin, int baud_rate){
-    serial = new BufferedSoftSerial( tx_pin, rx_pin );
-    serial->baud(baud_rate);
-    serial->format(8,serial->Parity::None,1);
-    calculate_delay(baud_rate, 8, 0, 1);
-    dir_output = new GPIO(dir_pin);
-    dir_output->output();
-    dir_output->clear();
-}
-
-Modbus::Modbus( PinName tx_pin, PinName rx_pin, PinName dir_pin, int baud_rate, const char *format){
-    serial = new BufferedSoftSerial( tx_pin, rx_pin );
-    serial->baud(baud_rate);
-    
-    if(strncmp(format, "8N1", 3) == 0){
-        serial->format(8,serial->Parity::None,1);
-        calculate_delay(baud_rate, 8, 0, 1);
-    } else if(strncmp(format, "8O1", 3) == 0){
-        serial->format(8,serial->Parity::Odd,1);
+#include <string.h>
+#include <math.h>
+
+Modbus::Modbus( ModbusTransport *transport, int baud_rate, const char *format){
+    this->transport = transport;
+    transport->baud(baud_rate);
+
+    if(strncmp(format, "8O1", 3) == 0){
+        transport->format(8, ModbusTransport::ODD, 1);
         calculate_delay(baud_rate, 8, 1, 1);
     } else if(strncmp(format, "8E1", 3) == 0){
-        serial->format(8,serial->Parity::Even,1);
+        transport->format(8, ModbusTransport::EVEN, 1);
         calculate_delay(baud_rate, 8, 1, 1);
     } else if(strncmp(format, "8N2", 3) == 0){
-        serial->format(8,serial->Parity::None,2);
+        transport->format(8, ModbusTransport::NONE, 2);
         calculate_delay(baud_rate, 8, 0, 2);
     } else {
-        serial->format(8,serial->Parity::None,1);
+        transport->format(8, ModbusTransport::NONE, 1);
         calculate_delay(baud_rate, 8, 0, 1);
     }
-    dir_output = new GPIO(dir_pin);
-    dir_output->output();
-    dir_output->clear();
+
+    // 50ms is what the Huanyang VFDs need between frames, well above the 3.5 characters the Modbus standard asks for
+    turnaround_time= 50;
+    reply_timeout= 100;
+
+    head= tail= 0;
+    reply_count= 0;
+    reply_ok= false;
+    state= IDLE;
+}
+
+Modbus::~Modbus()
+{
+    timer.detach();
+    delete transport;
 }
 
 // Called when the module has just been loaded
 void Modbus::on_module_loaded() {
-    // We want to be called every time a new char is received
-    serial->attach(this, &Modbus::on_serial_char_received, BufferedSoftSerial::RxIrq);
+    // We want to be called every time a new char is received, and when a frame has been sent
+    transport->rx_fnc= std::bind(&Modbus::on_serial_char_received, this);
+    transport->tx_complete_fnc= std::bind(&Modbus::on_transmit_complete, this);
+
+    register_for_event(ON_IDLE);
+    register_for_event(ON_HALT);
+}
+
+// drop whatever has not been sent yet, frames waiting on the motion queue would never be reached now
+void Modbus::on_halt(void *argument)
+{
+    if(argument != nullptr) return;
+
+    // the frame at the tail may be on the wire or waiting to be handed back, leave that one to finish
+    STATE s= state;
+    unsigned int first= (s == IDLE || s == TURNAROUND) ? tail : next(tail);
+    for (unsigned int i = first; i != head; i = next(i)) {
+        queue[i].fnc= nullptr;
+    }
+    head= first;
 }
 
-// Called on Serial::RxIrq interrupt, meaning we have received a char
+// hand back finished transactions and start the next one, everything that may take time or print happens here
+void Modbus::on_idle(void *)
+{
+    if(state == DONE) {
+        transaction_t &t= queue[tail];
+        if(t.fnc) {
+            t.fnc(reply_ok, reply, reply_count);
+            t.fnc= nullptr;
+        }
+        tail= next(tail);
+        state= TURNAROUND;
+        timer.attach_us(this, &Modbus::on_timeout, turnaround_time * 1000);
+    }
+
+    if(state == IDLE && head != tail) {
+        transaction_t &t= queue[tail];
+        if(!t.synchronized || THECONVEYOR->is_position_reached(t.position)) {
+            start_transaction();
+        }
+    }
+}
+
+// Called from the transport RX interrupt, meaning we have received a char
 void Modbus::on_serial_char_received(){
-    buffer.push_back(serial->getc());
+    while(transport->readable()) {
+        char c= transport->getc();
+        if(state != RECEIVE) continue; // not expecting anything so it is noise or an echo
+
+        reply[reply_count++]= c;
+
+        const transaction_t &t= queue[tail];
+        // exception replies are only 5 bytes long
+        bool exception= reply_count == 5 && (reply[1] & 0x80);
+        if(reply_count >= t.reply_len || exception) {
+            timer.detach();
+            unsigned int crc= crc16(reply, reply_count - 2);
+            reply_ok= !exception && reply[0] == t.frame[0] &&
+                      reply[reply_count - 2] == (char)(crc & 0xFF) && reply[reply_count - 1] == (char)(crc >> 8);
+            state= DONE;
+        }
+    }
+}
+
+void Modbus::start_transaction()
+{
+    const transaction_t &t= queue[tail];
+
+    reply_count= 0;
+    reply_ok= false;
+
+    state= TRANSMIT;
+    transport->write(t.frame, t.len);
+}
+
+// Called from the transport interrupt once the last character is out and the driver released
+void Modbus::on_transmit_complete()
+{
+    if(state != TRANSMIT) return;
+
+    if(queue[tail].reply_len == 0) {
+        // nothing to wait for
+        reply_ok= true;
+        state= DONE;
+    } else {
+        state= RECEIVE;
+        timer.attach_us(this, &Modbus::on_timeout, (unsigned int) ceilf((reply_timeout + queue[tail].reply_len * delay_time) * 1000));
+    }
+}
+
+// timer interrupt, moves the state machine along
+void Modbus::on_timeout()
+{
+    switch(state) {
+        case RECEIVE:
+            // the slave did not answer in time, or not all of it
+            reply_ok= false;
+            state= DONE;
+            break;
+
+        case TURNAROUND:
+            state= IDLE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+// queue a frame, the CRC is added here. reply_len is the expected reply size including the CRC, or 0 if the
+// reply is not needed. Blocks if the queue is full, returns false if the frame cannot be sent at all
+bool Modbus::send_frame(const char *data, uint8_t len, uint8_t reply_len, reply_fnc_t fnc, bool synchronized)
+{
+    if(len + 2 > MODBUS_MAX_FRAME || reply_len > MODBUS_MAX_FRAME) return false;
+
+    // wait for room, the same way the conveyor waits for room in the block queue
+    while(next(head) == tail) {
+        THEKERNEL->call_event(ON_IDLE, this);
+    }
+
+    transaction_t &t= queue[head];
+    memcpy(t.frame, data, len);
+    unsigned int crc = crc16(t.frame, len);
+    t.frame[len] = crc;             // CRC LSB
+    t.frame[len + 1] = (crc >> 8);  // CRC MSB
+    t.len= len + 2;
+    t.reply_len= reply_len;
+    t.fnc= fnc;
+    t.synchronized= synchronized;
+    t.position= synchronized ? THECONVEYOR->get_queue_position() : 0;
+
+    head= next(head);
+    return true;
+}
+
+// Wait for everything queued so far to be sent
+void Modbus::wait_for_idle()
+{
+    while(!is_idle()) {
+        THEKERNEL->call_event(ON_IDLE, this);
+    }
 }
 
-void Modbus::read_coil(int slave_addr, int coil_addr, int n_coils){
-    char telegram[8];
-    unsigned int crc;
+void Modbus::read_coil(int slave_addr, int coil_addr, int n_coils, reply_fnc_t fnc){
+    char telegram[6];
     telegram[0] = slave_addr;       // Slave address
     telegram[1] = 0x01;             // Function code
     telegram[2] = (coil_addr >> 8); // Coil address MSB
     telegram[3] = coil_addr & 0xFF; // Coil address LSB
     telegram[4] = (n_coils >> 8);   // number of coils to read MSB
     telegram[5] = n_coils & 0xFF;   // number of coils to read LSB
-    crc = crc16(telegram, 6);       
-    telegram[6] = crc;              // CRC LSB
-    telegram[7] = (crc >> 8);       // CRC MSB
-    dir_output->set();
-    serial->write(telegram,8);
-    delay((int) ceil(50 + 8 * delay_time));
-    dir_output->clear();
-    // TODO: read reply from buffer and return it
+    // reply is address, function, byte count, the coil bits and CRC
+    send_frame(telegram, 6, 5 + (n_coils + 7) / 8, fnc);
 }
 
 void Modbus::read_holding_register(int slave_addr, int reg_addr, int n_regs){
@@ -92,41 +212,27 @@ void Modbus::read_holding_register(int slave_addr, int reg_addr, int n_regs){
     // TODO: implement this
 }
 
-void Modbus::write_coil(int slave_addr, int coil_addr, bool data){
-    char telegram[8];
-    unsigned int crc;
+void Modbus::write_coil(int slave_addr, int coil_addr, bool data, bool synchronized){
+    char telegram[6];
     telegram[0] = slave_addr;       // Slave address
     telegram[1] = 0x05;             // Function code
     telegram[2] = (coil_addr >> 8); // Coil address MSB
     telegram[3] = coil_addr & 0xFF; // Coil address LSB
     telegram[4] = 0x00;             // Data MSB
     telegram[5] = (data == true) ? 0xFF : 0x00; // Data LSB
-    crc = crc16(telegram, 6);       
-    telegram[6] = crc;              // CRC LSB
-    telegram[7] = (crc >> 8);       // CRC MSB
-    dir_output->set();
-    serial->write(telegram,8);
-    delay((int) ceil(50 + 8 * delay_time));
-    dir_output->clear();
+    send_frame(telegram, 6, 0, nullptr, synchronized);
 }
 
 
-void Modbus::write_holding_register(int slave_addr, int reg_addr, int data){
-    char telegram[8];
-    unsigned int crc;
+void Modbus::write_holding_register(int slave_addr, int reg_addr, int data, bool synchronized){
+    char telegram[6];
     telegram[0] = slave_addr;       // Slave address
     telegram[1] = 0x06;             // Function code
     telegram[2] = (reg_addr >> 8);  // Register address MSB
     telegram[3] = reg_addr;         // Register address LSB
     telegram[4] = (data >> 8);      // Data MSB
     telegram[5] = data;             // Data LSB
-    crc = crc16(telegram, 6);       
-    telegram[6] = crc;              // CRC LSB
-    telegram[7] = (crc >> 8);       // CRC MSB
-    dir_output->set();
-    serial->write(telegram,8);
-    delay((int) ceil(50 + 8 * delay_time));
-    dir_output->clear();
+    send_frame(telegram, 6, 0, nullptr, synchronized);
 }
 
 void Modbus::diagnostic(int slave_addr, int test_sub_code, int data){
@@ -153,16 +259,7 @@ void Modbus::calculate_delay(int baudrate, int bits, int parity, int stop) {
     delay_time = bittime * (1 + bits + parity + 1);
 }
 
-void Modbus::delay(unsigned int value) {
-    
-    uint32_t start = us_ticker_read(); // mbed call
-    while ((us_ticker_read() - start) < value*1000) {
-        THEKERNEL->call_event(ON_IDLE, this);
-    }
-
-}
-
-unsigned int Modbus::crc16(char *data, unsigned int len) {
+unsigned int Modbus::crc16(const char *data, unsigned int len) {
     
     static const unsigned short crc_table[] = {
     0X0000, 0XC0C1, 0XC181, 0X0140, 0XC301, 0X03C0, 0X0280, 0XC241,
@@ -9,38 +9,84 @@
 #define MODBUS_H
 
 #include "libs/Module.h"
-#include <vector>
+#include "Timeout.h" // mbed.h lib
+#include <functional>
+#include <stdint.h>
 
-class BufferedSoftSerial;
-class GPIO;
+class ModbusTransport;
 
+#define MODBUS_QUEUE_SIZE 8
+#define MODBUS_MAX_FRAME 16
+
+// Modbus RTU master
+// Frames are queued and sent one at a time by a state machine run from the transport interrupts and a timeout, replies are
+// handed back through a callback from on_idle. A frame may be synchronized to the motion queue in which case it is
+// not sent until every block queued before it has been executed.
 class Modbus : public Module {
     public:
-        Modbus( PinName rx_pin, PinName tx_pin, PinName dir_pin);
-        Modbus( PinName rx_pin, PinName tx_pin, PinName dir_pin, int baud_rate);
-        Modbus( PinName rx_pin, PinName tx_pin, PinName dir_pin, int baud_rate, const char *format);
+        // called with ok false if the slave did not answer in time or the reply was corrupt
+        using reply_fnc_t= std::function<void(bool ok, const char *reply, uint8_t len)>;
+
+        Modbus( ModbusTransport *transport, int baud_rate= 9600, const char *format= "8N1");
+        ~Modbus();
 
         void on_module_loaded();
+        void on_idle(void *);
+        void on_halt(void *);
         void on_serial_char_received();
+        void on_transmit_complete();
 
-        void read_coil(int slave_addr, int coil_addr, int n_coils);
+        bool send_frame(const char *data, uint8_t len, uint8_t reply_len= 0, reply_fnc_t fnc= nullptr, bool synchronized= false);
+        bool is_idle() const { return head == tail && state == IDLE; }
+        void wait_for_idle();
+
+        void read_coil(int slave_addr, int coil_addr, int n_coils, reply_fnc_t fnc= nullptr);
         void read_holding_register(int slave_addr, int reg_addr, int n_regs);
-        void write_coil(int slave_addr, int coil_addr, bool data);
-        void write_holding_register(int slave_addr, int reg_addr, int data);
+        void write_coil(int slave_addr, int coil_addr, bool data, bool synchronized= false);
+        void write_holding_register(int slave_addr, int reg_addr, int data, bool synchronized= false);
         void diagnostic(int slave_addr, int test_sub_code, int data);
         void write_multiple_coils(int slave_addr, int coil_addr, int n_coils, int data);
         void write_multiple_registers(int slave_addr, int start_addr, int data);
         void read_write_multiple_holding_registers(int slave_addr, int read_addr, int n_read, int write_addr, int data);
         void calculate_delay(int baudrate, int bits, int parity, int stop);
-        void delay(unsigned int);
-        unsigned int crc16(char *data, unsigned int len); 
+        static unsigned int crc16(const char *data, unsigned int len);
+
+        ModbusTransport *transport;
+
+        float delay_time;        // time in ms one character takes on the wire
+        uint32_t turnaround_time; // silence in ms after each transaction before the next frame is sent
+        uint32_t reply_timeout;   // time in ms the slave has to start answering
+
+    private:
+        enum STATE {
+            IDLE,       // waiting for a frame to send
+            TRANSMIT,   // frame is going out, waiting for the last character to leave
+            RECEIVE,    // collecting the reply
+            DONE,       // transaction complete, waiting for on_idle to hand it back
+            TURNAROUND  // waiting out the silent interval
+        };
+
+        struct transaction_t {
+            reply_fnc_t fnc;
+            uint32_t position; // motion queue position this frame waits for
+            char frame[MODBUS_MAX_FRAME];
+            uint8_t len;
+            uint8_t reply_len;
+            bool synchronized;
+        };
 
-        GPIO *dir_output;
+        void start_transaction();
+        void on_timeout();
+        unsigned int next(unsigned int i) const { return (i + 1) % MODBUS_QUEUE_SIZE; }
 
-        BufferedSoftSerial* serial;
-        std::vector<int> buffer;
+        transaction_t queue[MODBUS_QUEUE_SIZE];
+        volatile unsigned int head, tail;
 
-        float delay_time;        
+        mbed::Timeout timer;
+        char reply[MODBUS_MAX_FRAME];
+        volatile uint8_t reply_count;
+        volatile STATE state;
+        volatile bool reply_ok;
 };
 
 #endif
@@ -0,0 +1,34 @@
+/*
+    This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+    Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+    Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MODBUS_TRANSPORT_H
+#define MODBUS_TRANSPORT_H
+
+#include <functional>
+#include <stdint.h>
+
+// The serial link Modbus talks over, it owns the RS485 direction pin
+class ModbusTransport {
+    public:
+        enum PARITY { NONE, ODD, EVEN };
+
+        virtual ~ModbusTransport() {};
+
+        virtual void baud(int baud_rate) = 0;
+        virtual void format(int bits, PARITY parity, int stop_bits) = 0;
+
+        // enables the driver and starts sending, tx_complete_fnc is called once the last stop bit is out and the driver released
+        virtual void write(const char *data, uint8_t len) = 0;
+        virtual bool readable() = 0;
+        virtual char getc() = 0;
+
+        // both are called from interrupt context
+        std::function<void()> rx_fnc;
+        std::function<void()> tx_complete_fnc;
+};
+
+#endif
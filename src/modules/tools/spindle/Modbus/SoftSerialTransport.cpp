@@ -0,0 +1,79 @@
+/*
+    This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+    Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+    Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SoftSerialTransport.h"
+#include "BufferedSoftSerial.h"
+#include "libs/gpio.h"
+
+SoftSerialTransport::SoftSerialTransport(PinName tx_pin, PinName rx_pin, PinName dir_pin)
+{
+    serial = new BufferedSoftSerial(tx_pin, rx_pin);
+    serial->attach(this, &SoftSerialTransport::on_char_received, BufferedSoftSerial::RxIrq);
+
+    dir_output = new GPIO(dir_pin);
+    dir_output->output();
+    dir_output->clear();
+
+    baud_rate= 9600;
+    frame_bits= 10;
+    calculate_char_time();
+}
+
+SoftSerialTransport::~SoftSerialTransport()
+{
+    timer.detach();
+    delete serial;
+    delete dir_output;
+}
+
+void SoftSerialTransport::baud(int baud_rate)
+{
+    this->baud_rate= baud_rate;
+    serial->baud(baud_rate);
+    calculate_char_time();
+}
+
+void SoftSerialTransport::format(int bits, PARITY parity, int stop_bits)
+{
+    serial->format(bits, parity == ODD ? BufferedSoftSerial::Odd : parity == EVEN ? BufferedSoftSerial::Even : BufferedSoftSerial::None, stop_bits);
+    frame_bits= 1 + bits + (parity == NONE ? 0 : 1) + stop_bits;
+    calculate_char_time();
+}
+
+void SoftSerialTransport::calculate_char_time()
+{
+    char_time= (frame_bits * 1000000 + baud_rate - 1) / baud_rate;
+}
+
+void SoftSerialTransport::write(const char *data, uint8_t len)
+{
+    dir_output->set();
+    serial->write(data, len);
+    // allow one extra character to be sure the last one is gone
+    timer.attach_us(this, &SoftSerialTransport::on_sent, (len + 1) * char_time);
+}
+
+void SoftSerialTransport::on_sent()
+{
+    dir_output->clear();
+    if(tx_complete_fnc) tx_complete_fnc();
+}
+
+void SoftSerialTransport::on_char_received()
+{
+    if(rx_fnc) rx_fnc();
+}
+
+bool SoftSerialTransport::readable()
+{
+    return serial->readable();
+}
+
+char SoftSerialTransport::getc()
+{
+    return serial->getc();
+}
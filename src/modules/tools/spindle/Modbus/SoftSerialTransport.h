@@ -0,0 +1,44 @@
+/*
+    This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+    Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+    Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOFT_SERIAL_TRANSPORT_H
+#define SOFT_SERIAL_TRANSPORT_H
+
+#include "ModbusTransport.h"
+#include "Timeout.h" // mbed.h lib
+#include "PinNames.h" // mbed.h lib
+
+class BufferedSoftSerial;
+class GPIO;
+
+// Modbus over a bit banged serial port on any two pins
+// there is no transmit complete interrupt so the end of the frame is timed from the baud rate
+class SoftSerialTransport : public ModbusTransport {
+    public:
+        SoftSerialTransport(PinName tx_pin, PinName rx_pin, PinName dir_pin);
+        ~SoftSerialTransport();
+
+        void baud(int baud_rate);
+        void format(int bits, PARITY parity, int stop_bits);
+        void write(const char *data, uint8_t len);
+        bool readable();
+        char getc();
+
+    private:
+        void on_char_received();
+        void on_sent();
+        void calculate_char_time();
+
+        BufferedSoftSerial *serial;
+        GPIO *dir_output;
+        mbed::Timeout timer;
+        int baud_rate;
+        uint8_t frame_bits; // start, data, parity and stop bits
+        uint32_t char_time; // us
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*
+    This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+    Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+    Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "UartTransport.h"
+#include "libs/gpio.h"
+#include "serial_api.h"
+#include "lpc17xx_uart.h"
+
+#include <string.h>
+
+UartTransport::UartTransport(PinName tx_pin, PinName rx_pin, PinName dir_pin) : mbed::Serial(tx_pin, rx_pin)
+{
+    dir_output = new GPIO(dir_pin);
+    dir_output->output();
+    dir_output->clear();
+
+    tx_len= tx_index= 0;
+    baud_rate= 9600;
+    frame_bits= 10;
+    mbed::Serial::baud(baud_rate);
+    calculate_char_time();
+
+    attach(this, &UartTransport::on_rx_irq, mbed::Serial::RxIrq);
+}
+
+UartTransport::~UartTransport()
+{
+    serial_irq_set(&_serial, (SerialIrq)RxIrq, 0);
+    serial_irq_set(&_serial, (SerialIrq)TxIrq, 0);
+    timer.detach();
+    delete dir_output;
+}
+
+void UartTransport::baud(int baud_rate)
+{
+    this->baud_rate= baud_rate;
+    mbed::Serial::baud(baud_rate);
+    calculate_char_time();
+}
+
+void UartTransport::format(int bits, PARITY parity, int stop_bits)
+{
+    mbed::Serial::format(bits, parity == ODD ? mbed::Serial::Odd : parity == EVEN ? mbed::Serial::Even : mbed::Serial::None, stop_bits);
+    frame_bits= 1 + bits + (parity == NONE ? 0 : 1) + stop_bits;
+    calculate_char_time();
+}
+
+void UartTransport::calculate_char_time()
+{
+    char_time= (frame_bits * 1000000 + baud_rate - 1) / baud_rate;
+}
+
+void UartTransport::write(const char *data, uint8_t len)
+{
+    if(len > UART_TRANSPORT_BUFFER) len= UART_TRANSPORT_BUFFER;
+    memcpy(tx_buffer, data, len);
+    tx_len= len;
+    tx_index= 0;
+
+    dir_output->set();
+    fill_fifo();
+    // THRE fires once the FIFO has drained
+    attach(this, &UartTransport::on_tx_irq, mbed::Serial::TxIrq);
+}
+
+// the transmit FIFO is empty when this is called, so up to 16 characters can go in at once
+void UartTransport::fill_fifo()
+{
+    for (int n = 0; n < UART_FIFO_SIZE && tx_index < tx_len; n++) {
+        _serial.uart->THR= tx_buffer[tx_index++];
+    }
+}
+
+void UartTransport::on_tx_irq()
+{
+    // THRE is also raised when the interrupt is enabled on an empty FIFO
+    if(!(_serial.uart->LSR & UART_LSR_THRE)) return;
+
+    if(tx_index < tx_len) {
+        fill_fifo();
+        return;
+    }
+
+    // everything is in the shift register, which has no interrupt of its own, so check back after one character
+    serial_irq_set(&_serial, (SerialIrq)TxIrq, 0);
+    timer.attach_us(this, &UartTransport::on_shift_empty, char_time);
+}
+
+void UartTransport::on_shift_empty()
+{
+    // at most a bit time or so left if the timer was early
+    while(!(_serial.uart->LSR & UART_LSR_TEMT)) ;
+    dir_output->clear();
+    if(tx_complete_fnc) tx_complete_fnc();
+}
+
+void UartTransport::on_rx_irq()
+{
+    if(rx_fnc) rx_fnc();
+    // make sure the interrupt is cleared even if nobody wanted the data
+    while(mbed::Serial::readable()) (void)_serial.uart->RBR;
+}
+
+bool UartTransport::readable()
+{
+    return mbed::Serial::readable();
+}
+
+char UartTransport::getc()
+{
+    return _serial.uart->RBR;
+}
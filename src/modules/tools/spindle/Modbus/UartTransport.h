@@ -0,0 +1,49 @@
+/*
+    This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+    Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+    Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UART_TRANSPORT_H
+#define UART_TRANSPORT_H
+
+#include "ModbusTransport.h"
+#include "Serial.h" // mbed.h lib
+#include "Timeout.h" // mbed.h lib
+
+class GPIO;
+
+#define UART_TRANSPORT_BUFFER 32
+#define UART_FIFO_SIZE 16
+
+// Modbus over one of the hardware UARTs, frames are fed to the transmit FIFO from the THRE interrupt
+// and the RS485 driver is released as soon as the transmitter reports it is empty
+class UartTransport : public ModbusTransport, public mbed::Serial {
+    public:
+        UartTransport(PinName tx_pin, PinName rx_pin, PinName dir_pin);
+        ~UartTransport();
+
+        void baud(int baud_rate);
+        void format(int bits, PARITY parity, int stop_bits);
+        void write(const char *data, uint8_t len);
+        bool readable();
+        char getc();
+
+    private:
+        void on_rx_irq();
+        void on_tx_irq();
+        void on_shift_empty();
+        void fill_fifo();
+        void calculate_char_time();
+
+        GPIO *dir_output;
+        mbed::Timeout timer;
+        char tx_buffer[UART_TRANSPORT_BUFFER];
+        volatile uint8_t tx_len, tx_index;
+        int baud_rate;
+        uint8_t frame_bits;
+        uint32_t char_time; // us
+};
+
+#endif
@@ -10,6 +10,8 @@
 #include "libs/Pin.h"
 #include "mbed.h"
 #include "Modbus.h"
+#include "SoftSerialTransport.h"
+#include "UartTransport.h"
 #include "Config.h"
 #include "checksumm.h"
 #include "ConfigValue.h"
@@ -19,6 +21,9 @@
 #define spindle_rx_pin_checksum             CHECKSUM("rx_pin")
 #define spindle_tx_pin_checksum             CHECKSUM("tx_pin")
 #define spindle_dir_pin_checksum            CHECKSUM("dir_pin")
+#define spindle_baud_rate_checksum          CHECKSUM("baud_rate")
+#define spindle_format_checksum             CHECKSUM("format")
+#define spindle_hardware_uart_checksum      CHECKSUM("hardware_uart")
 
 void ModbusSpindleControl::on_module_loaded()
 {
@@ -46,10 +51,24 @@ void ModbusSpindleControl::on_module_loaded()
         delete smoothie_pin;
     }
 
-    // setup the Modbus interface
-    modbus = new Modbus(tx_pin, rx_pin, dir_pin);
+    // setup the Modbus interface, the hardware UART needs the rx and tx pins to be one of UART1-3
+    ModbusTransport *transport;
+    if(THEKERNEL->config->value(spindle_checksum, spindle_hardware_uart_checksum)->by_default(false)->as_bool()) {
+        transport = new UartTransport(tx_pin, rx_pin, dir_pin);
+    } else {
+        transport = new SoftSerialTransport(tx_pin, rx_pin, dir_pin);
+    }
+    int baud_rate = THEKERNEL->config->value(spindle_checksum, spindle_baud_rate_checksum)->by_default(9600)->as_int();
+    std::string format = THEKERNEL->config->value(spindle_checksum, spindle_format_checksum)->by_default("8N1")->as_string();
+    modbus = new Modbus(transport, baud_rate, format.c_str());
+    THEKERNEL->add_module(modbus);
 
     // register for events
     register_for_event(ON_GCODE_RECEIVED);
 }
 
+
+void ModbusSpindleControl::wait_for_commands()
+{
+    modbus->wait_for_idle();
+}
@@ -25,6 +25,8 @@ class ModbusSpindleControl: public SpindleControl {
         virtual void turn_off(void);
         virtual void set_speed(int);
         virtual void report_speed(void);
+        virtual bool is_queue_synchronized(void) { return true; };
+        virtual void wait_for_commands(void);
 
 };
 
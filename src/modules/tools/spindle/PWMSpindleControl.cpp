@@ -67,9 +67,10 @@ void PWMSpindleControl::on_module_loaded()
 
     // Get the pin for hardware pwm
     {
+        int period = THEKERNEL->config->value(spindle_checksum, spindle_pwm_period_checksum)->by_default(1000)->as_int();
         Pin *smoothie_pin = new Pin();
         smoothie_pin->from_string(THEKERNEL->config->value(spindle_checksum, spindle_pwm_pin_checksum)->by_default("nc")->as_string());
-        pwm_pin = smoothie_pin->as_output()->hardware_pwm();
+        pwm_pin = smoothie_pin->as_output()->hardware_pwm(period);
         output_inverted = smoothie_pin->is_inverting();
         delete smoothie_pin;
     }
@@ -81,8 +82,6 @@ void PWMSpindleControl::on_module_loaded()
         return;
     }
     
-    int period = THEKERNEL->config->value(spindle_checksum, spindle_pwm_period_checksum)->by_default(1000)->as_int();
-    pwm_pin->period_us(period);
     pwm_pin->write(output_inverted ? 1 : 0);
 
     // Get the pin for interrupt
@@ -39,8 +39,12 @@ void SpindleControl::on_gcode_received(void *argument)
         }
         else if (gcode->m == 3) 
         {
-            THECONVEYOR->wait_for_idle();
+            // a spindle that is off must be started before the next move
+            if(!spindle_on || !is_queue_synchronized()) {
+                THECONVEYOR->wait_for_idle();
+            }
             // M3: Spindle on
+            bool was_on = spindle_on;
             if(!spindle_on) {
                 turn_on();
             }
@@ -49,11 +53,17 @@ void SpindleControl::on_gcode_received(void *argument)
             if (gcode->has_letter('S'))
             {
                 set_speed(gcode->get_value('S'));
+                // a spindle that was just started must also be at speed before the next move
+                if(!was_on) {
+                    wait_for_commands();
+                }
             }
         }
         else if (gcode->m == 5)
         {
-            THECONVEYOR->wait_for_idle();
+            if(!is_queue_synchronized()) {
+                THECONVEYOR->wait_for_idle();
+            }
             // M5: spindle off
             if(spindle_on) {
                 turn_off();
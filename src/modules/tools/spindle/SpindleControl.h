@@ -26,6 +26,10 @@ class SpindleControl: public Module {
         virtual void turn_off(void) {};
         virtual void set_speed(int) {};
         virtual void report_speed(void) {};
+        // true if the spindle queues its commands in step with the motion queue itself so it need not be drained first
+        virtual bool is_queue_synchronized(void) { return false; };
+        // waits until the commands given so far have reached the spindle
+        virtual void wait_for_commands(void) {};
         virtual void set_p_term(float) {};
         virtual void set_i_term(float) {};
         virtual void set_d_term(float) {};
@@ -13,6 +13,7 @@
 #include "libs/Pin.h"
 #include "modules/robot/Conveyor.h"
 #include "PublicDataRequest.h"
+#include "PublicData.h"
 #include "SwitchPublicAccess.h"
 #include "SlowTicker.h"
 #include "Config.h"
@@ -79,6 +80,8 @@ void Switch::on_module_loaded()
     this->register_for_event(ON_MAIN_LOOP);
     this->register_for_event(ON_GET_PUBLIC_DATA);
     this->register_for_event(ON_SET_PUBLIC_DATA);
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, switch_checksum, this->name_checksum);
+    PublicData::register_handler(ON_SET_PUBLIC_DATA, this, switch_checksum, this->name_checksum);
     this->register_for_event(ON_HALT);
 
     // Settings
@@ -136,7 +139,9 @@ void Switch::on_config_reload(void *argument)
         this->output_type= HWPWM;
         Pin *pin= new Pin();
         pin->from_string(THEKERNEL->config->value(switch_checksum, this->name_checksum, output_pin_checksum )->by_default("nc")->as_string())->as_output();
-        this->pwm_pin= pin->hardware_pwm();
+        // default is 50Hz
+        float p= THEKERNEL->config->value(switch_checksum, this->name_checksum, pwm_period_ms_checksum )->by_default(20)->as_number() * 1000.0F; // ms but fractions are allowed
+        this->pwm_pin= pin->hardware_pwm(roundf(p));
         if(failsafe == 1) {
             set_high_on_debug(pin->port_number, pin->pin);
         }else{
@@ -162,10 +167,6 @@ void Switch::on_config_reload(void *argument)
         }
 
     } else if(this->output_type == HWPWM) {
-        // default is 50Hz
-        float p= THEKERNEL->config->value(switch_checksum, this->name_checksum, pwm_period_ms_checksum )->by_default(20)->as_number() * 1000.0F; // ms but fractions are allowed
-        this->pwm_pin->period_us(p);
-
         // default is 0% duty cycle
         this->switch_value = THEKERNEL->config->value(switch_checksum, this->name_checksum, startup_value_checksum )->by_default(0)->as_number();
         if(this->switch_state) {
@@ -8,12 +8,23 @@
 #include "TemperatureControlPublicAccess.h"
 #include "PublicDataRequest.h"
 #include "PublicData.h"
+#include "ExtruderPublicAccess.h"
+#include "Robot.h"
+#include "Conveyor.h"
+#include "SerialMessage.h"
 
 #include <cmath>        // std::abs
 
 //#define DEBUG_PRINTF s->printf
 #define DEBUG_PRINTF(...)
 
+// feed forward tune timings in milliseconds
+#define FF_SETTLE_TIME 30000       // how long the temperature must be within FF_SETTLE_BAND before we start
+#define FF_SETTLE_BAND 1.0F
+#define FF_MEASURE_TIME 30000      // how long the pwm is averaged over, with and without the flow
+#define FF_EXTRUDE_SETTLE_TIME 35000 // how long the PID gets to settle at the new load
+#define FF_EXTRUDE_PIECE 2000      // the test extrude is queued as moves this long, so an abort only has to wait for one
+
 PID_Autotuner::PID_Autotuner()
 {
     temp_control = NULL;
@@ -22,6 +33,9 @@ PID_Autotuner::PID_Autotuner()
     tick = false;
     tickCnt = 0;
     nLookBack = 10 * 20; // 10 seconds of lookback (fixed 20ms tick period)
+    ff_phase = FF_NONE;
+    ff_extruding = false;
+    ff_abort_pending = false;
 }
 
 void PID_Autotuner::on_module_loaded()
@@ -29,6 +43,7 @@ void PID_Autotuner::on_module_loaded()
     tick = false;
     THEKERNEL->slow_ticker->attach(20, this, &PID_Autotuner::on_tick );
     register_for_event(ON_IDLE);
+    register_for_event(ON_MAIN_LOOP);
     register_for_event(ON_GCODE_RECEIVED);
 }
 
@@ -67,6 +82,21 @@ void PID_Autotuner::abort()
     if (temp_control == NULL)
         return;
 
+    if(ff_phase != FF_NONE) {
+        temp_control->feedforward_factor = ff_saved_factor;
+        ff_phase = FF_NONE;
+        ff_abort_pending = false;
+
+        if(ff_extruding) {
+            // throw away the queued pieces of the test extrude, a halt has already done that
+            ff_extruding = false;
+            if(!THEKERNEL->is_halted()) {
+                THECONVEYOR->flush_queue();
+                THEROBOT->reset_position_from_current_actuator_position();
+            }
+        }
+    }
+
     temp_control->target_temperature = 0;
     temp_control->heater_pin.set(0);
     temp_control = NULL;
@@ -127,6 +157,17 @@ void PID_Autotuner::on_gcode_received(void *argument)
                 nLookBack = gcode->get_value('L');
             }
 
+            if (gcode->has_letter('V')) {
+                // M303 En Snnn Vnnn tunes the feed forward by extruding Vnnn mm³/sec, the PID must already be tuned
+                if(!this->begin_feedforward(target, gcode->get_value('V'))) {
+                    gcode->stream->printf("Feed forward tune needs the extruder of this heater to be selected and a flow > 0\n");
+                    this->temp_control = NULL;
+                    return;
+                }
+                gcode->stream->printf("%s: Starting feed forward tune at %1.1f mm³/sec, the extruder will run, M304 aborts\n", temp_control->designator.c_str(), ff_flow);
+                return;
+            }
+
             gcode->stream->printf("Start PID tune for index E%d, designator: %s\n", pool_index, this->temp_control->designator.c_str());
 
             this->begin(target, ncycles);
@@ -136,6 +177,34 @@ void PID_Autotuner::on_gcode_received(void *argument)
     }
 }
 
+// moves must be queued from the main loop, as on_idle may be called while the queue is full
+void PID_Autotuner::on_main_loop(void *)
+{
+    if(ff_abort_pending) {
+        THEKERNEL->streams->printf("// Feed forward tune aborted\n");
+        abort();
+        return;
+    }
+
+    // keep a piece of the test extrude queued ahead of the one running
+    if(ff_extruding && (long)(ff_queued_until - tickCnt) < FF_EXTRUDE_PIECE) {
+        if((long)(ff_queued_until - tickCnt) < 0) ff_queued_until = tickCnt;
+        ff_queued_until += FF_EXTRUDE_PIECE;
+
+        // a relative E only move in mm, whatever the modes are set to
+        char buf[48];
+        snprintf(buf, sizeof(buf), "G1 E%1.4f F%1.4f", ff_extrude_length, ff_extrude_rate * 60);
+        THEROBOT->push_state();
+        THEROBOT->inch_mode = false;
+        THEROBOT->e_absolute_mode = false;
+        struct SerialMessage message;
+        message.message = buf;
+        message.stream = &(StreamOutput::NullStream);
+        THEKERNEL->call_event(ON_CONSOLE_LINE_RECEIVED, &message );
+        THEROBOT->pop_state();
+    }
+}
+
 uint32_t PID_Autotuner::on_tick(uint32_t dummy)
 {
     if (temp_control != NULL)
@@ -158,6 +227,11 @@ void PID_Autotuner::on_idle(void *)
     if (temp_control == NULL)
         return;
 
+    if(ff_phase != FF_NONE) {
+        feedforward_step();
+        return;
+    }
+
     if(peakCount >= requested_cycles) {
         // NOTE we output to kernel::streams becuase it is out-of-band data and original stream may be closed
         THEKERNEL->streams->printf("// WARNING: Autopid did not resolve within %d cycles, these results are probably innacurate\n", requested_cycles);
@@ -252,6 +326,130 @@ void PID_Autotuner::on_idle(void *)
 }
 
 
+// The feed forward gain is the extra pwm the PID settles at while extruding a known flow, divided by that flow.
+// The temperature is held by the PID as normal, first the pwm needed with no flow is measured then the extruder
+// is run at the test flow and it is measured again.
+bool PID_Autotuner::begin_feedforward(float target, float flow)
+{
+    if(flow <= 0) return false;
+
+    // the extruder of this heaters tool must be the one that runs
+    pad_extruder_t rd;
+    if(!PublicData::get_value( extruder_checksum, temp_control->name_checksum, (void *)&rd ) || !rd.selected) return false;
+
+    ff_flow = flow;
+    ff_saved_factor = temp_control->feedforward_factor;
+    temp_control->feedforward_factor = 0; // measure the PID on its own
+    temp_control->feedforward = 0;
+    temp_control->set_desired_temperature(target);
+    target_temperature = target;
+    tickCnt = 0;
+    phase_start = 0;
+    ff_extruding = false;
+    ff_abort_pending = false;
+    ff_phase = FF_SETTLE;
+    return true;
+}
+
+void PID_Autotuner::feedforward_step()
+{
+    float refVal = temp_control->get_temperature();
+    unsigned long elapsed = tickCnt - phase_start;
+
+    if ((tickCnt % 1000) == 0) {
+        THEKERNEL->streams->printf("// Feed forward tune Status - %5.1f/%5.1f @%d phase %d\n", refVal, target_temperature, temp_control->o, ff_phase);
+    }
+
+    if(ff_abort_pending) return;
+
+    if(THEKERNEL->is_halted() || temp_control->target_temperature <= 0) {
+        ff_abort_pending = true;
+        return;
+    }
+
+    switch(ff_phase) {
+        case FF_SETTLE:
+            // wait for the temperature to sit at the target
+            if(fabsf(refVal - target_temperature) > FF_SETTLE_BAND) {
+                phase_start = tickCnt;
+
+            } else if(elapsed >= FF_SETTLE_TIME) {
+                pwm_sum = 0;
+                pwm_samples = 0;
+                phase_start = tickCnt;
+                ff_phase = FF_BASE;
+            }
+            break;
+
+        case FF_BASE:
+            pwm_sum += temp_control->o;
+            pwm_samples++;
+            if(elapsed >= FF_MEASURE_TIME) {
+                base_pwm = pwm_sum / pwm_samples;
+
+                // run the extruder at the test flow, the length is in gcode units so undo the extruders scaling
+                pad_extruder_t rd;
+                if(!PublicData::get_value( extruder_checksum, temp_control->name_checksum, (void *)&rd )) {
+                    THEKERNEL->streams->printf("// Feed forward tune: this heater has no extruder\n");
+                    ff_abort_pending = true;
+                    return;
+                }
+                float area = powf((rd.filament_diameter > 0.01F ? rd.filament_diameter : 1.75F) / 2, 2) * 3.14159265358979F;
+                float e_scale = (rd.filament_diameter > 0.01F ? 1.0F / area : 1.0F) * rd.flow_rate;
+                ff_extrude_rate = ff_flow / area;
+                ff_extrude_length = ff_extrude_rate * (FF_EXTRUDE_PIECE / 1000.0F) / e_scale;
+
+                // the moves are queued from the main loop
+                ff_queued_until = tickCnt;
+                ff_extruding = true;
+                ff_phase = FF_EXTRUDE_SETTLE;
+                phase_start = tickCnt;
+            }
+            break;
+
+        case FF_EXTRUDE_SETTLE:
+            // give the PID time to settle at the new load
+            if(elapsed >= FF_EXTRUDE_SETTLE_TIME) {
+                pwm_sum = 0;
+                pwm_samples = 0;
+                phase_start = tickCnt;
+                ff_phase = FF_EXTRUDE;
+            }
+            break;
+
+        case FF_EXTRUDE:
+            pwm_sum += temp_control->o;
+            pwm_samples++;
+            if(elapsed >= FF_MEASURE_TIME) finish_feedforward();
+            break;
+
+        case FF_NONE:
+            break;
+    }
+}
+
+void PID_Autotuner::finish_feedforward()
+{
+    float extrude_pwm = pwm_sum / pwm_samples;
+    float kff = (extrude_pwm - base_pwm) / ff_flow;
+    THEKERNEL->streams->printf("\tpwm at rest: %1.1f, pwm at %1.1f mm³/sec: %1.1f\n", base_pwm, ff_flow, extrude_pwm);
+
+    if(kff <= 0) {
+        THEKERNEL->streams->printf("Feed forward tune failed, the heater did not need more power while extruding\n");
+        temp_control->feedforward_factor = ff_saved_factor;
+
+    } else {
+        THEKERNEL->streams->printf("\tFeed forward: %1.4f pwm per mm³/sec\n", kff);
+        temp_control->feedforward_factor = kff;
+        THEKERNEL->streams->printf("Feed forward tune Complete! The setting above has been loaded into memory, but not written to your config file.\n");
+    }
+
+    // no more of the extrude is queued, but the extruder may still be finishing what was so leave the heater on at the target
+    ff_phase = FF_NONE;
+    ff_extruding = false;
+    temp_control = NULL;
+}
+
 void PID_Autotuner::finishUp()
 {
     //we can generate tuning parameters!
@@ -19,12 +19,16 @@ public:
     void on_module_loaded(void);
     uint32_t on_tick(uint32_t);
     void on_idle(void *);
+    void on_main_loop(void *);
     void on_gcode_received(void *);
 
 private:
     void begin(float, int );
     void abort();
     void finishUp();
+    bool begin_feedforward(float, float);
+    void feedforward_step();
+    void finish_feedforward();
 
     TemperatureControl *temp_control;
     float target_temperature;
@@ -43,10 +47,26 @@ private:
     float oStep;
     int output;
     volatile unsigned long tickCnt;
+
+    // feed forward tune
+    enum FF_PHASE { FF_NONE, FF_SETTLE, FF_BASE, FF_EXTRUDE_SETTLE, FF_EXTRUDE };
+    float ff_flow;          // test flow in mm³/sec
+    float ff_saved_factor;
+    float pwm_sum;
+    float base_pwm;
+    uint32_t pwm_samples;
+    unsigned long phase_start;
+    float ff_extrude_length;      // E of each piece of the test extrude in gcode units
+    float ff_extrude_rate;        // mm/sec of filament
+    unsigned long ff_queued_until; // tick count when the queued pieces of the test extrude run out
+
     struct {
         bool justchanged:1;
         volatile bool tick:1;
         bool firstPeak:1;
+        FF_PHASE ff_phase:3;
+        bool ff_extruding:1;     // the test extrude is being queued
+        bool ff_abort_pending:1; // the tune is to be aborted from the main loop
     };
 };
 
@@ -25,6 +25,7 @@
 #include "PID_Autotuner.h"
 #include "SerialMessage.h"
 #include "utils.h"
+#include "ExtruderPublicAccess.h"
 
 // Temp sensor implementations:
 #include "Thermistor.h"
@@ -40,6 +41,7 @@
 #define readings_per_second_checksum       CHECKSUM("readings_per_second")
 #define max_pwm_checksum                   CHECKSUM("max_pwm")
 #define pwm_frequency_checksum             CHECKSUM("pwm_frequency")
+#define hardware_pwm_checksum              CHECKSUM("hardware_pwm")
 #define bang_bang_checksum                 CHECKSUM("bang_bang")
 #define hysteresis_checksum                CHECKSUM("hysteresis")
 #define heater_pin_checksum                CHECKSUM("heater_pin")
@@ -67,6 +69,12 @@
 #define runaway_cooling_timeout_checksum   CHECKSUM("runaway_cooling_timeout")
 #define runaway_error_range_checksum       CHECKSUM("runaway_error_range")
 
+#define feedforward_factor_checksum        CHECKSUM("feedforward_factor")
+#define feedforward_lookahead_checksum     CHECKSUM("feedforward_lookahead")
+
+// used to convert the extrusion rate to a flow if the extruder is not set for volumetric extrusion
+#define DEFAULT_FILAMENT_DIAMETER 1.75F
+
 TemperatureControl::TemperatureControl(uint16_t name, int index)
 {
     name_checksum= name;
@@ -76,6 +84,9 @@ TemperatureControl::TemperatureControl(uint16_t name, int index)
     sensor= nullptr;
     readonly= false;
     tick= 0;
+    feedforward= 0;
+    feedforward_motor= -1;
+    feedforward_update= false;
 }
 
 TemperatureControl::~TemperatureControl()
@@ -96,11 +107,14 @@ void TemperatureControl::on_module_loaded()
     // Register for events
     this->register_for_event(ON_GCODE_RECEIVED);
     this->register_for_event(ON_GET_PUBLIC_DATA);
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, temperature_control_checksum);
 
     if(!this->readonly) {
         this->register_for_event(ON_SECOND_TICK);
         this->register_for_event(ON_MAIN_LOOP);
+        this->register_for_event(ON_IDLE);
         this->register_for_event(ON_SET_PUBLIC_DATA);
+        PublicData::register_handler(ON_SET_PUBLIC_DATA, this, temperature_control_checksum, this->name_checksum);
         this->register_for_event(ON_HALT);
     }
 }
@@ -198,8 +212,16 @@ void TemperatureControl::load_config()
         this->heater_pin.max_pwm( THEKERNEL->config->value(temperature_control_checksum, this->name_checksum, max_pwm_checksum)->by_default(255)->as_number() );
         this->heater_pin.set(0);
         set_low_on_debug(heater_pin.port_number, heater_pin.pin);
-        // activate SD-DAC timer
-        THEKERNEL->slow_ticker->attach( THEKERNEL->config->value(temperature_control_checksum, this->name_checksum, pwm_frequency_checksum)->by_default(2000)->as_number(), &heater_pin, &Pwm::on_tick);
+        float pwm_frequency= THEKERNEL->config->value(temperature_control_checksum, this->name_checksum, pwm_frequency_checksum)->by_default(2000)->as_number();
+        bool hardware_pwm= THEKERNEL->config->value(temperature_control_checksum, this->name_checksum, hardware_pwm_checksum)->by_default(false)->as_bool();
+        if(hardware_pwm && this->heater_pin.use_hardware(pwm_frequency)) {
+            // the PWM peripheral drives the pin so the SD-DAC timer is not needed
+
+        } else {
+            if(hardware_pwm) THEKERNEL->streams->printf("WARNING: %s heater pin cannot use the PWM hardware, using sigma-delta\n", this->designator.c_str());
+            // activate SD-DAC timer
+            THEKERNEL->slow_ticker->attach(pwm_frequency, &heater_pin, &Pwm::on_tick);
+        }
     }
 
 
@@ -217,6 +239,11 @@ void TemperatureControl::load_config()
         this->i_max = THEKERNEL->config->value(temperature_control_checksum, this->name_checksum, i_max_checksum   )->by_default(this->heater_pin.max_pwm())->as_number();
     }
 
+    // feed forward, adds pwm in proportion to the flow that is about to go through the hotend, 0 disables it
+    this->feedforward_factor = THEKERNEL->config->value(temperature_control_checksum, this->name_checksum, feedforward_factor_checksum)->by_default(0)->as_number();
+    this->feedforward_lookahead = THEKERNEL->config->value(temperature_control_checksum, this->name_checksum, feedforward_lookahead_checksum)->by_default(2.0F)->as_number();
+    this->filament_area = powf(DEFAULT_FILAMENT_DIAMETER / 2, 2) * 3.14159265358979F;
+
     this->iTerm = 0.0;
     this->lastInput = -1.0;
     this->last_reading = 0.0;
@@ -293,13 +320,22 @@ void TemperatureControl::on_gcode_received(void *argument)
                     this->i_max = gcode->get_value('X');
                 if (gcode->has_letter('Y'))
                     this->heater_pin.max_pwm(gcode->get_value('Y'));
+                if (gcode->has_letter('C'))
+                    this->feedforward_factor = gcode->get_value('C');
+                if (gcode->has_letter('L'))
+                    this->feedforward_lookahead = gcode->get_value('L');
+                if (this->feedforward_factor <= 0)
+                    this->feedforward = 0;
 
             }else if(!gcode->has_letter('S')) {
-                gcode->stream->printf("%s(S%d): Pf:%g If:%g Df:%g X(I_max):%g max pwm: %d O:%d\n", this->designator.c_str(), this->pool_index, this->p_factor, this->i_factor / this->PIDdt, this->d_factor * this->PIDdt, this->i_max, this->heater_pin.max_pwm(), o);
+                gcode->stream->printf("%s(S%d): Pf:%g If:%g Df:%g X(I_max):%g max pwm: %d O:%d C(feed forward):%g L(lookahead):%g FF:%1.1f\n", this->designator.c_str(), this->pool_index, this->p_factor, this->i_factor / this->PIDdt, this->d_factor * this->PIDdt, this->i_max, this->heater_pin.max_pwm(), o, this->feedforward_factor, this->feedforward_lookahead, this->feedforward);
             }
 
         } else if (gcode->m == 500 || gcode->m == 503) { // M500 saves some volatile settings to config override file, M503 just prints the settings
             gcode->stream->printf(";PID settings:\nM301 S%d P%1.4f I%1.4f D%1.4f X%1.4f Y%d\n", this->pool_index, this->p_factor, this->i_factor / this->PIDdt, this->d_factor * this->PIDdt, this->i_max, this->heater_pin.max_pwm());
+            if(this->feedforward_factor > 0) {
+                gcode->stream->printf(";Feed forward pwm per mm³/sec, lookahead secs:\nM301 S%d C%1.4f L%1.4f\n", this->pool_index, this->feedforward_factor, this->feedforward_lookahead);
+            }
 
             gcode->stream->printf(";Max temperature setting:\nM143 S%d P%1.4f\n", this->pool_index, this->max_temp);
 
@@ -519,6 +555,12 @@ void TemperatureControl::pid_process(float temperature)
     // TODO does this need to be scaled by max_pwm/256? I think not as p_factor already does that
     this->o = (this->p_factor * error) + new_I - (this->d_factor * d);
 
+    // add the heat needed for the flow that is about to arrive, rather than waiting for the temperature to drop
+    if(this->feedforward_factor > 0) {
+        this->o += this->feedforward;
+        this->feedforward_update= true;
+    }
+
     if (this->o >= heater_pin.max_pwm())
         this->o = heater_pin.max_pwm();
     else if (this->o < 0)
@@ -530,8 +572,38 @@ void TemperatureControl::pid_process(float temperature)
     this->lastInput = temperature;
 }
 
+// the flow has to be looked up from the queue which is not safe to do in the reading tick, so it is done here
+// and the reading tick uses whatever was last calculated
+void TemperatureControl::on_idle(void *argument)
+{
+    if(!feedforward_update) return;
+    feedforward_update= false;
+
+    if(this->feedforward_motor < 0) {
+        this->feedforward= 0;
+        return;
+    }
+    float mm_per_sec= THECONVEYOR->get_extrusion_rate(this->feedforward_lookahead, this->feedforward_motor);
+    this->feedforward= this->feedforward_factor * mm_per_sec * this->filament_area;
+}
+
+// the flow through this heater is that of the extruder of the same tool, which is the one with the same name as this
+// temperature control, eg extruder.hotend2 and temperature_control.hotend2. Its filament diameter can be changed with
+// M200 so check it now and then
+void TemperatureControl::update_feedforward_extruder()
+{
+    pad_extruder_t rd;
+    if(PublicData::get_value( extruder_checksum, this->name_checksum, (void *)&rd )) {
+        this->feedforward_motor = rd.motor_id;
+        this->filament_area = powf((rd.filament_diameter > 0.01F ? rd.filament_diameter : DEFAULT_FILAMENT_DIAMETER) / 2, 2) * 3.14159265358979F;
+    } else {
+        this->feedforward_motor = -1;
+    }
+}
+
 void TemperatureControl::on_second_tick(void *argument)
 {
+    if(this->feedforward_factor > 0) update_feedforward_extruder();
 
     // If waiting for a temperature to be reach, display it to keep host programs up to date on the progress
     if (waiting)
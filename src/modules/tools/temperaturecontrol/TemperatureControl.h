@@ -23,6 +23,7 @@ class TemperatureControl : public Module {
         void on_main_loop(void* argument);
         void on_gcode_received(void* argument);
         void on_second_tick(void* argument);
+        void on_idle(void* argument);
         void on_get_public_data(void* argument);
         void on_set_public_data(void* argument);
         void on_halt(void* argument);
@@ -41,6 +42,7 @@ class TemperatureControl : public Module {
         void setPIDp(float p);
         void setPIDi(float i);
         void setPIDd(float d);
+        void update_feedforward_extruder();
 
         int pool_index;
 
@@ -69,6 +71,13 @@ class TemperatureControl : public Module {
         float d_factor;
         float PIDdt;
 
+        // feed forward from the extrusion rate of the queued moves
+        float feedforward_factor;    // pwm per mm³/sec
+        float feedforward_lookahead; // seconds of queued moves the flow is averaged over
+        float feedforward;           // current feed forward pwm
+        float filament_area;         // mm² of the filament of this heaters extruder
+        int8_t feedforward_motor;    // actuator of this heaters extruder, -1 if it has none
+
         float runaway_error_range;
 
         enum RUNAWAY_TYPE {NOT_HEATING, HEATING_UP, COOLING_DOWN, TARGET_TEMPERATURE_REACHED};
@@ -94,6 +103,7 @@ class TemperatureControl : public Module {
             bool readonly:1;
             bool windup:1;
             bool sensor_settings:1;
+            volatile bool feedforward_update:1;
         };
 };
 
@@ -20,6 +20,7 @@
 #include "predefined_thermistors.h"
 
 #include <fastmath.h>
+#include <algorithm>
 
 #include "MRI_Hooks.h"
 
@@ -37,6 +38,8 @@
 #define rt_curve_checksum                  CHECKSUM("rt_curve")
 #define coefficients_checksum              CHECKSUM("coefficients")
 #define use_beta_table_checksum            CHECKSUM("use_beta_table")
+#define use_lookup_table_checksum          CHECKSUM("use_lookup_table")
+#define lookup_table_max_error_checksum    CHECKSUM("lookup_table_max_error")
 
 
 Thermistor::Thermistor()
@@ -47,10 +50,18 @@ Thermistor::Thermistor()
     min_temp= 999;
     max_temp= 0;
     this->thermistor_number= 0; // not a predefined thermistor
+    this->use_table= true;
+    this->table_adc= nullptr;
+    this->table_temp= nullptr;
+    this->table_size= 0;
+    this->table_max_error= 0.1F;
+    this->table_error= 0;
 }
 
 Thermistor::~Thermistor()
 {
+    delete [] table_adc;
+    delete [] table_temp;
 }
 
 // Get configuration from the config file
@@ -66,6 +77,10 @@ void Thermistor::UpdateConfig(uint16_t module_checksum, uint16_t name_checksum)
     // force use of beta perdefined thermistor table based on betas
     bool use_beta_table= THEKERNEL->config->value(module_checksum, name_checksum, use_beta_table_checksum)->by_default(false)->as_bool();
 
+    // interpolate temperatures from a table built here rather than evaluating the thermistor equation on every reading
+    this->use_table= THEKERNEL->config->value(module_checksum, name_checksum, use_lookup_table_checksum)->by_default(true)->as_bool();
+    this->table_max_error= THEKERNEL->config->value(module_checksum, name_checksum, lookup_table_max_error_checksum)->by_default(0.1F)->as_number();
+
     bool found= false;
     int cnt= 0;
     // load a predefined thermistor name if found
@@ -180,6 +195,7 @@ void Thermistor::UpdateConfig(uint16_t module_checksum, uint16_t name_checksum)
         return;
     }
 
+    build_table();
 }
 
 // print out predefined thermistors
@@ -270,6 +286,13 @@ void Thermistor::get_raw()
         THEKERNEL->streams->printf("beta temp= %f, min= %f, max= %f, delta= %f\n", t, min_temp, max_temp, max_temp-min_temp);
     }
 
+    if(table_size > 0) {
+        THEKERNEL->streams->printf("lookup table: %d entries, %f to %f, temp= %f, max error= %f\n", table_size,
+            table_temp[0], table_temp[table_size-1], adc_value_to_temperature(adc_value), table_error);
+    }else{
+        THEKERNEL->streams->printf("lookup table: not used\n");
+    }
+
     // if using a predefined thermistor show its name and which table it is from
     if(thermistor_number != 0) {
         string name= (thermistor_number&0x80) ? predefined_thermistors_beta[(thermistor_number&0x7F)-1].name :  predefined_thermistors[thermistor_number-1].name;
@@ -286,8 +309,38 @@ float Thermistor::adc_value_to_temperature(uint32_t adc_value)
     if ((adc_value >= max_adc_value) || (adc_value == 0))
         return infinityf();
 
+    // readings outside the table (open circuit or very hot) use the equation
+    if(table_size > 0 && adc_value <= table_adc[0] && adc_value >= table_adc[table_size-1]) {
+        return table_temperature(adc_value);
+    }
+
+    return analytic_temperature(adc_value);
+}
+
+// interpolate between the two table entries either side of adc_value, which must be within the table
+float Thermistor::table_temperature(uint32_t adc_value) const
+{
+    // binary search for the last entry whose adc value is >= adc_value
+    int lo= 0, hi= table_size - 1;
+    while(hi - lo > 1) {
+        int mid= (lo + hi) / 2;
+        if(table_adc[mid] >= adc_value) lo= mid;
+        else hi= mid;
+    }
+
+    if(table_adc[lo] == table_adc[hi]) return table_temp[lo];
+    float f= (float)(table_adc[lo] - adc_value) / (table_adc[lo] - table_adc[hi]);
+    return table_temp[lo] + (table_temp[hi] - table_temp[lo]) * f;
+}
+
+float Thermistor::analytic_temperature(float adc_value)
+{
+    const float max_adc_value= THEKERNEL->adc->get_max_value();
+    if ((adc_value >= max_adc_value) || (adc_value <= 0))
+        return infinityf();
+
     // resistance of the thermistor in ohms
-    float r = r2 / (((float)max_adc_value / adc_value) - 1.0F);
+    float r = r2 / ((max_adc_value / adc_value) - 1.0F);
     if (r1 > 0.0F) r = (r1 * r) / (r1 - r);
 
     if(r > this->r0 * 8) return infinityf(); // 800k is probably open circuit
@@ -304,6 +357,84 @@ float Thermistor::adc_value_to_temperature(uint32_t adc_value)
     return t;
 }
 
+// true if a straight line from adc_value down to adc_value-len stays within table_max_error of the equation
+// it is only sampled, so it is held to 90% of the error to leave room for the readings between the samples
+bool Thermistor::segment_fits(float adc_value, float len, float temp)
+{
+    float end= analytic_temperature(adc_value - len);
+    if(isinf(end) || isnan(end) || end <= temp) return false;
+
+    const float max_error= table_max_error * 0.9F;
+    for (int i = 1; i < 8; ++i) {
+        float f= i / 8.0F;
+        if(fabsf(temp + (end - temp) * f - analytic_temperature(adc_value - len * f)) > max_error) return false;
+    }
+    return true;
+}
+
+// Build a table of adc values and temperatures from the beta or Steinhart-Hart settings.
+// Each entry is placed as far from the previous one as the error bound allows, starting at the cold end,
+// so it is dense where the curve bends and sparse where it is nearly straight.
+void Thermistor::build_table()
+{
+    table_size= 0;
+    table_error= 0;
+    if(!use_table || bad_config) return;
+
+    // the cold end is the highest reading that is not considered an open circuit
+    int adc= THEKERNEL->adc->get_max_value() - 1;
+    while(adc > 0 && isinf(analytic_temperature(adc))) --adc;
+    if(adc <= 1) return;
+
+    if(table_adc == nullptr) {
+        table_adc= new uint16_t[THERMISTOR_TABLE_SIZE];
+        table_temp= new float[THERMISTOR_TABLE_SIZE];
+    }
+
+    float temp= analytic_temperature(adc);
+    table_adc[0]= adc;
+    table_temp[0]= temp;
+    int n= 1;
+    while(n < THERMISTOR_TABLE_SIZE && adc > 1) {
+        // find the longest segment that fits, doubling then bisecting
+        const int max_len= adc - 1;
+        int len= 1;
+        if(!segment_fits(adc, len, temp)) break;
+        while(len * 2 <= max_len && segment_fits(adc, len * 2, temp)) len *= 2;
+        int bad= std::min(len * 2, max_len + 1);
+        while(bad - len > 1) {
+            int mid= (len + bad) / 2;
+            if(segment_fits(adc, mid, temp)) len= mid;
+            else bad= mid;
+        }
+
+        adc -= len;
+        temp= analytic_temperature(adc);
+        table_adc[n]= adc;
+        table_temp[n]= temp;
+        ++n;
+    }
+    table_size= n;
+
+    if(table_size < 2) {
+        table_size= 0;
+        return;
+    }
+
+    // check every reading covered by the table against the equation, segments are only sampled while building
+    float worst= 0;
+    for (int a = table_adc[0]; a >= table_adc[table_size-1]; --a) {
+        float e= fabsf(table_temperature(a) - analytic_temperature(a));
+        if(e > worst) worst= e;
+    }
+    table_error= worst;
+
+    if(worst > table_max_error) {
+        THEKERNEL->streams->printf("WARNING: thermistor lookup table error %f exceeds %f, using the equation\n", worst, table_max_error);
+        table_size= 0;
+    }
+}
+
 int Thermistor::new_thermistor_reading()
 {
     // filtering now done in ADC
@@ -352,6 +483,7 @@ bool Thermistor::set_optional(const sensor_options_t& options) {
             calc_jk();
             thermistor_number= predefined;
             this->bad_config= false;
+            build_table();
             return true;
 
         }else {
@@ -370,6 +502,7 @@ bool Thermistor::set_optional(const sensor_options_t& options) {
             use_steinhart_hart= true;
             thermistor_number= predefined;
             this->bad_config= false;
+            build_table();
             return true;
         }
     }
@@ -397,6 +530,7 @@ bool Thermistor::set_optional(const sensor_options_t& options) {
 
     if(this->bad_config) this->bad_config= false;
 
+    build_table();
     return true;
 }
 
@@ -16,6 +16,9 @@
 
 #define QUEUE_LEN 32
 
+// maximum number of entries in the adc to temperature lookup table
+#define THERMISTOR_TABLE_SIZE 64
+
 class StreamOutput;
 
 class Thermistor : public TempSensor
@@ -36,6 +39,10 @@ class Thermistor : public TempSensor
     private:
         int new_thermistor_reading();
         float adc_value_to_temperature(uint32_t adc_value);
+        float analytic_temperature(float adc_value);
+        float table_temperature(uint32_t adc_value) const;
+        bool segment_fits(float adc_value, float len, float temp);
+        void build_table();
         void calc_jk();
 
         // Thermistor computation settings using beta, not used if using Steinhart-Hart
@@ -62,10 +69,18 @@ class Thermistor : public TempSensor
 
         Pin  thermistor_pin;
 
+        // adc to temperature lookup table, adc values are in descending order
+        uint16_t *table_adc;
+        float *table_temp;
+        float table_max_error;
+        float table_error;
+        uint8_t table_size;
+
         float min_temp, max_temp;
         struct {
             bool bad_config:1;
             bool use_steinhart_hart:1;
+            bool use_table:1;
         };
         uint8_t thermistor_number;
 };
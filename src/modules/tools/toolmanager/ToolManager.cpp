@@ -38,6 +38,7 @@ void ToolManager::on_module_loaded()
     this->register_for_event(ON_GCODE_RECEIVED);
     this->register_for_event(ON_GET_PUBLIC_DATA);
     this->register_for_event(ON_SET_PUBLIC_DATA);
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, tool_manager_checksum);
 }
 
 void ToolManager::on_gcode_received(void *argument)
@@ -29,6 +29,11 @@ using namespace std;
 #define digipotchip_checksum                    CHECKSUM("digipotchip")
 #define digipot_max_current                     CHECKSUM("digipot_max_current")
 #define digipot_factor                          CHECKSUM("digipot_factor")
+#define idle_current_factor_checksum            CHECKSUM("currentcontrol_idle_factor")
+#define accel_current_factor_checksum           CHECKSUM("currentcontrol_accel_factor")
+#define cruise_current_factor_checksum          CHECKSUM("currentcontrol_cruise_factor")
+#define decel_current_factor_checksum           CHECKSUM("currentcontrol_decel_factor")
+#define current_hold_time_checksum              CHECKSUM("currentcontrol_hold_time")
 
 #define mcp4451_checksum                        CHECKSUM("mcp4451")
 #define ad5206_checksum                         CHECKSUM("ad5206")
@@ -62,18 +67,43 @@ void CurrentControl::on_module_loaded()
     digipot->set_max_current( THEKERNEL->config->value(digipot_max_current )->by_default(2.0f)->as_number());
     digipot->set_factor( THEKERNEL->config->value(digipot_factor )->by_default(113.33f)->as_number());
 
+    // the current can follow the motion, eg lower when idle or cruising and full when accelerating
+    const uint16_t motion_settings[5]= { idle_current_factor_checksum, accel_current_factor_checksum, cruise_current_factor_checksum, decel_current_factor_checksum, current_hold_time_checksum };
+    motion_current.config_load(motion_settings);
+
     // Get configuration
-    this->digipot->set_current(0, THEKERNEL->config->value(alpha_current_checksum  )->by_default(0.8f)->as_number());
-    this->digipot->set_current(1, THEKERNEL->config->value(beta_current_checksum   )->by_default(0.8f)->as_number());
-    this->digipot->set_current(2, THEKERNEL->config->value(gamma_current_checksum  )->by_default(0.8f)->as_number());
-    this->digipot->set_current(3, THEKERNEL->config->value(delta_current_checksum  )->by_default(0.8f)->as_number());
-    this->digipot->set_current(4, THEKERNEL->config->value(epsilon_current_checksum)->by_default(-1)->as_number());
-    this->digipot->set_current(5, THEKERNEL->config->value(zeta_current_checksum   )->by_default(-1)->as_number());
-    this->digipot->set_current(6, THEKERNEL->config->value(eta_current_checksum    )->by_default(-1)->as_number());
-    this->digipot->set_current(7, THEKERNEL->config->value(theta_current_checksum  )->by_default(-1)->as_number());
+    set_current(0, THEKERNEL->config->value(alpha_current_checksum  )->by_default(0.8f)->as_number());
+    set_current(1, THEKERNEL->config->value(beta_current_checksum   )->by_default(0.8f)->as_number());
+    set_current(2, THEKERNEL->config->value(gamma_current_checksum  )->by_default(0.8f)->as_number());
+    set_current(3, THEKERNEL->config->value(delta_current_checksum  )->by_default(0.8f)->as_number());
+    set_current(4, THEKERNEL->config->value(epsilon_current_checksum)->by_default(-1)->as_number());
+    set_current(5, THEKERNEL->config->value(zeta_current_checksum   )->by_default(-1)->as_number());
+    set_current(6, THEKERNEL->config->value(eta_current_checksum    )->by_default(-1)->as_number());
+    set_current(7, THEKERNEL->config->value(theta_current_checksum  )->by_default(-1)->as_number());
 
 
     this->register_for_event(ON_GCODE_RECEIVED);
+    // the digipot can't be written from the step interrupt, so the phase is looked at from the main loop
+    if(motion_current.is_dynamic()) this->register_for_event(ON_IDLE);
+}
+
+// sets the current for a channel, less than 0 means the channel is not used
+void CurrentControl::set_current(int channel, float current)
+{
+    currents[channel]= current;
+    this->digipot->set_current(channel, current < 0 ? current : current * motion_current.factor());
+}
+
+void CurrentControl::apply_currents()
+{
+    for (int i = 0; i < 8; i++) {
+        if(currents[i] >= 0) this->digipot->set_current(i, currents[i] * motion_current.factor());
+    }
+}
+
+void CurrentControl::on_idle(void *argument)
+{
+    if(motion_current.follow()) apply_currents();
 }
 
 
@@ -88,7 +118,7 @@ void CurrentControl::on_gcode_received(void *argument)
                 // this is the old format where E => A, A => B, B => C, C => D
                 for (int i = 0; i < 7; i++) {
                     if (gcode->has_letter(alpha[i])) {
-                        this->digipot->set_current(i, gcode->get_value(alpha[i]));
+                        set_current(i, gcode->get_value(alpha[i]));
                     }
                 }
 
@@ -98,7 +128,7 @@ void CurrentControl::on_gcode_received(void *argument)
                     char axis= i < 3 ? 'X'+i : 'A'+i-3;
                     if (gcode->has_letter(axis)) {
                         float c = gcode->get_value(axis);
-                        this->digipot->set_current(i, c);
+                        set_current(i, c);
                     }
                 }
             }
@@ -107,7 +137,8 @@ void CurrentControl::on_gcode_received(void *argument)
             float currents[7];
             bool has_setting= false;
             for (int i = 0; i < 7; i++) {
-                currents[i]= this->digipot->get_current(i);
+                // the digipot has the scaled current, save what was set
+                currents[i]= motion_current.is_dynamic() ? this->currents[i] : this->digipot->get_current(i);
                 if(currents[i] >= 0) has_setting= true;
             }
             if(!has_setting) return; // don't ouput anything if none are set using this current control
@@ -2,6 +2,9 @@
 #define CURRENTCONTROL_H
 
 #include "Module.h"
+#include "MotionCurrent.h"
+
+#include <stdint.h>
 
 class DigipotBase;
 
@@ -12,10 +15,18 @@ class CurrentControl : public Module {
 
         void on_module_loaded();
         void on_gcode_received(void *);
+        void on_idle(void *);
 
     private:
+        void set_current(int channel, float current);
+        void apply_currents();
+
         DigipotBase* digipot;
 
+        // currents set by config or M907, what is sent to the digipot is these scaled by the factor for the motion phase
+        float currents[8];
+        MotionCurrent motion_current;
+
 };
 
 
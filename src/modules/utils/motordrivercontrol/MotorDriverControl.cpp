@@ -8,6 +8,8 @@
 #include "Robot.h"
 #include "StepperMotor.h"
 #include "PublicDataRequest.h"
+#include "PublicData.h"
+#include "SlowTicker.h"
 
 #include "Gcode.h"
 #include "Config.h"
@@ -20,7 +22,6 @@
 
 #include <string>
 
-#define motor_driver_control_checksum  CHECKSUM("motor_driver_control")
 #define enable_checksum                CHECKSUM("enable")
 #define chip_checksum                  CHECKSUM("chip")
 #define designator_checksum            CHECKSUM("designator")
@@ -29,12 +30,22 @@
 
 #define current_checksum               CHECKSUM("current")
 #define max_current_checksum           CHECKSUM("max_current")
+#define idle_factor_checksum           CHECKSUM("idle_factor")
+#define accel_factor_checksum          CHECKSUM("accel_factor")
+#define cruise_factor_checksum         CHECKSUM("cruise_factor")
+#define decel_factor_checksum          CHECKSUM("decel_factor")
+#define current_hold_time_checksum     CHECKSUM("current_hold_time")
 
 #define microsteps_checksum            CHECKSUM("microsteps")
 #define decay_mode_checksum            CHECKSUM("decay_mode")
 
 #define raw_register_checksum          CHECKSUM("reg")
 
+#define stallguard_rate_checksum       CHECKSUM("stallguard_rate")
+#define stall_threshold_checksum       CHECKSUM("stall_threshold")
+#define stall_samples_checksum         CHECKSUM("stall_samples")
+#define stall_settle_samples_checksum  CHECKSUM("stall_settle_samples")
+
 #define spi_channel_checksum           CHECKSUM("spi_channel")
 #define spi_cs_pin_checksum            CHECKSUM("spi_cs_pin")
 #define spi_frequency_checksum         CHECKSUM("spi_frequency")
@@ -44,6 +55,9 @@ MotorDriverControl::MotorDriverControl(uint8_t id) : id(id)
     enable_event= false;
     current_override= false;
     microstep_override= false;
+    motor= nullptr;
+    sample_due= false;
+    load= {0, 0, 0, 0, 1023, false, false};
 }
 
 MotorDriverControl::~MotorDriverControl()
@@ -138,6 +152,10 @@ bool MotorDriverControl::config_module(uint16_t cs)
 
     current= THEKERNEL->config->value(motor_driver_control_checksum, cs, current_checksum )->by_default(1000)->as_number(); // in mA
     microsteps= THEKERNEL->config->value(motor_driver_control_checksum, cs, microsteps_checksum )->by_default(16)->as_number(); // 1/n
+
+    // the current can follow the motion, eg lower when idle or cruising and full when accelerating
+    const uint16_t motion_settings[5]= { idle_factor_checksum, accel_factor_checksum, cruise_factor_checksum, decel_factor_checksum, current_hold_time_checksum };
+    motion_current.config_load(motion_settings, motor_driver_control_checksum, cs);
     //decay_mode= THEKERNEL->config->value(motor_driver_control_checksum, cs, decay_mode_checksum )->by_default(1)->as_number();
 
     // setup the chip via SPI
@@ -180,6 +198,31 @@ bool MotorDriverControl::config_module(uint16_t cs)
         this->register_for_event(ON_SECOND_TICK);
     }
 
+    // read stallguard at a high rate while the motor moves, for load telemetry and sensorless homing
+    uint32_t stallguard_rate= THEKERNEL->config->value(motor_driver_control_checksum, cs, stallguard_rate_checksum )->by_default(0)->as_number(); // Hz
+    if(stallguard_rate > 0) {
+        uint32_t a= (designator >= 'X' && designator <= 'Z') ? designator-'X' : designator-'A'+3;
+        if(chip != TMC2660) {
+            THEKERNEL->streams->printf("MotorDriverControl %c ERROR: stallguard is only supported on the TMC2660\n", designator);
+
+        }else if(a >= THEROBOT->get_number_registered_motors()) {
+            THEKERNEL->streams->printf("MotorDriverControl %c ERROR: no motor for stallguard sampling\n", designator);
+
+        }else{
+            motor= THEROBOT->actuators[a];
+            stall_threshold= THEKERNEL->config->value(motor_driver_control_checksum, cs, stall_threshold_checksum )->by_default(0)->as_number();
+            stall_samples= THEKERNEL->config->value(motor_driver_control_checksum, cs, stall_samples_checksum )->by_default(2)->as_number();
+            // readings are meaningless until the motor is up to speed
+            settle_samples= THEKERNEL->config->value(motor_driver_control_checksum, cs, stall_settle_samples_checksum )->by_default(20)->as_number();
+            settle_count= 0;
+            stall_count= 0;
+
+            this->register_for_event(ON_GET_PUBLIC_DATA);
+            PublicData::register_handler(ON_GET_PUBLIC_DATA, this, motor_driver_control_checksum, motor_load_checksum, get_checksum(std::string(1, designator)));
+            THEKERNEL->slow_ticker->attach(stallguard_rate, this, &MotorDriverControl::sample_load);
+        }
+    }
+
     THEKERNEL->streams->printf("MotorDriverControl INFO: configured motor %c (%d): as %s, cs: %04X\n", designator, id, chip==TMC2660?"TMC2660":chip==DRV8711?"DRV8711":"UNKNOWN", (spi_cs_pin.port_number<<8)|spi_cs_pin.pin);
 
     return true;
@@ -209,6 +252,99 @@ void MotorDriverControl::on_idle(void *argument)
         enable_event= false;
         enable(enable_flg);
     }
+
+    if(motion_current.follow()) set_current(phase_current());
+
+    if(sample_due) {
+        sample_due= false;
+        read_load();
+    }
+
+    // a stall when not homing probably means steps were lost
+    if(load.stalled && !load.homing) {
+        load.stalled= false;
+        if(THEKERNEL->is_halted()) return;
+        THEKERNEL->streams->printf("Motor %c stalled, steps may have been lost\r\n", designator);
+        if(halt_on_alarm) {
+            THEKERNEL->call_event(ON_HALT, nullptr);
+            THEKERNEL->streams->printf("Motor Driver alarm - reset or M999 required to continue\r\n");
+        }
+    }
+}
+
+// the current for the motion phase, a factor over 1 is still limited by max_current
+uint32_t MotorDriverControl::phase_current() const
+{
+    if(!motion_current.is_dynamic()) return current;
+    return std::min((uint32_t)lroundf(current * motion_current.factor()), max_current);
+}
+
+// Called from the SlowTicker ISR, the SPI bus may be shared with the SD card so the reading is left to on_idle
+uint32_t MotorDriverControl::sample_load(uint32_t)
+{
+    sample_due= true;
+    return 0;
+}
+
+// called from on_idle when a sample is due, reads the stallguard value while the motor is moving
+void MotorDriverControl::read_load()
+{
+    if(!motor->is_moving()) {
+        settle_count= 0;
+        stall_count= 0;
+        return;
+    }
+
+    int sg= tmc26x->readStallGuard();
+    if(sg < 0) return;
+
+    if(settle_count < settle_samples) {
+        ++settle_count;
+        return;
+    }
+
+    load.last= sg;
+    if(sg < load.min) load.min= sg;
+    load.total += sg;
+    ++load.samples;
+
+    if(sg <= stall_threshold) {
+        if(++stall_count == stall_samples) {
+            ++load.stalls;
+            load.stalled= true;
+        }
+    }else{
+        stall_count= 0;
+    }
+}
+
+void MotorDriverControl::report_load(StreamOutput *stream)
+{
+    if(motor == nullptr) {
+        stream->printf("Motor %c: stallguard sampling not enabled\n", designator);
+        return;
+    }
+
+    uint32_t samples= load.samples;
+    float avg= samples > 0 ? (float)load.total / samples : 0;
+    stream->printf("Motor %c: stallguard last: %u, min: %u, avg: %1.1f, samples: %lu, stalls: %lu", designator, load.last, load.min, avg, samples, load.stalls);
+
+    // the coolstep current needs the readout changed, so put it back for the sampling
+    unsigned int cs= tmc26x->getCoolstepCurrent();
+    tmc26x->getCurrentStallGuardReading();
+    stream->printf(", coolstep current: %umA\n", cs);
+}
+
+void MotorDriverControl::on_get_public_data(void *argument)
+{
+    PublicDataRequest *pdr = static_cast<PublicDataRequest *>(argument);
+
+    if(!pdr->starts_with(motor_driver_control_checksum)) return;
+    if(!pdr->second_element_is(motor_load_checksum)) return;
+    if(!pdr->third_element_is(get_checksum(std::string(1, designator)))) return;
+
+    pdr->set_data_ptr(&this->load);
+    pdr->set_taken();
 }
 
 void MotorDriverControl::on_halt(void *argument)
@@ -232,6 +368,8 @@ void MotorDriverControl::on_second_tick(void *argument)
 
         case TMC2660:
             alarm= tmc26x->checkAlarm();
+            // leave the readout on stallguard for the sampling
+            if(motor != nullptr) tmc26x->getCurrentStallGuardReading();
             break;
     }
 
@@ -251,7 +389,7 @@ void MotorDriverControl::on_gcode_received(void *argument)
                 // set motor currents in mA (Note not using M907 as digipots use that)
                 current= gcode->get_value(designator);
                 current= std::min(current, max_current);
-                set_current(current);
+                set_current(phase_current());
                 current_override= true;
             }
 
@@ -294,6 +432,7 @@ void MotorDriverControl::on_gcode_received(void *argument)
             // M911.3 S3 Zn setDoubleEdge Z=on|off Z1 is on Z0 is off
             // M911.3 S4 Zn setStepInterpolation Z=on|off Z1 is on Z0 is off
             // M911.3 S5 Zn setCoolStepEnabled Z=on|off Z1 is on Z0 is off
+            // M911.4 Pn (or X0) shows the stallguard load telemetry, with R1 it is also reset
 
             if(gcode->subcode == 0 && gcode->get_num_args() == 0) {
                 // M911 no args dump status for all drivers, M911.1 P0|A0 dump for specific driver
@@ -309,6 +448,14 @@ void MotorDriverControl::on_gcode_received(void *argument)
 
                 }else if(gcode->subcode == 3 ) {
                     set_options(gcode);
+
+                }else if(gcode->subcode == 4 ) {
+                    report_load(gcode->stream);
+                    if(gcode->has_letter('R') && gcode->get_value('R') == 1) {
+                        __disable_irq();
+                        load= {0, 0, 0, 0, 1023, false, load.homing};
+                        __enable_irq();
+                    }
                 }
             }
 
@@ -331,12 +478,12 @@ void MotorDriverControl::initialize_chip(uint16_t cs)
     // send initialization sequence to chips
     if(chip == DRV8711) {
         drv8711->init(cs);
-        set_current(current);
+        set_current(phase_current());
         set_microstep(microsteps);
 
     }else if(chip == TMC2660){
         tmc26x->init(cs);
-        set_current(current);
+        set_current(phase_current());
         set_microstep(microsteps);
         //set_decay_mode(decay_mode);
     }
@@ -405,6 +552,8 @@ void MotorDriverControl::dump_status(StreamOutput *stream, bool b)
 
         case TMC2660:
             tmc26x->dumpStatus(stream, b);
+            // leave the readout on stallguard for the sampling
+            if(motor != nullptr) tmc26x->getCurrentStallGuardReading();
             break;
     }
 }
@@ -2,6 +2,8 @@
 
 #include "Module.h"
 #include "Pin.h"
+#include "MotionCurrent.h"
+#include "MotorDriverControlPublicAccess.h"
 
 #include <stdint.h>
 
@@ -13,6 +15,7 @@ class DRV8711DRV;
 class TMC26X;
 class StreamOutput;
 class Gcode;
+class StepperMotor;
 
 class MotorDriverControl : public Module {
     public:
@@ -25,22 +28,36 @@ class MotorDriverControl : public Module {
         void on_enable(void *argument);
         void on_idle(void *argument);
         void on_second_tick(void *argument);
+        void on_get_public_data(void *argument);
 
     private:
         bool config_module(uint16_t cs);
         void initialize_chip(uint16_t cs);
         void set_current( uint32_t current );
+        uint32_t phase_current() const;
         uint32_t set_microstep( uint32_t ms );
         void set_decay_mode( uint8_t dm );
         void dump_status(StreamOutput*, bool);
         void set_raw_register(StreamOutput *stream, uint32_t reg, uint32_t val);
         void set_options(Gcode *gcode);
+        uint32_t sample_load(uint32_t);
+        void read_load();
+        void report_load(StreamOutput *stream);
 
         void enable(bool on);
         int sendSPI(uint8_t *b, int cnt, uint8_t *r);
 
         Pin spi_cs_pin;
         mbed::SPI *spi;
+        // stallguard load telemetry and stall detection, sampled at the SlowTicker rate while the motor moves
+        pad_motor_load_t load;
+        volatile bool sample_due; // set by the SlowTicker, the reading is done in on_idle
+        StepperMotor *motor;
+        uint16_t stall_threshold; // readings at or below this are a stall
+        uint16_t settle_samples;  // readings ignored after the motor starts moving
+        uint16_t settle_count;
+        uint8_t stall_samples;    // consecutive readings needed for a stall
+        uint8_t stall_count;
 
         enum CHIP_TYPE {
             DRV8711,
@@ -59,6 +76,9 @@ class MotorDriverControl : public Module {
         uint32_t current; // in milliamps
         uint32_t microsteps;
 
+        // the current sent to the chip is scaled by the factor for the motion phase
+        MotionCurrent motion_current;
+
         char designator;
 
         struct{
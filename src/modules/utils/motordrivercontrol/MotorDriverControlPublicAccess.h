@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// addresses used for public data access, the third element is the checksum of the motor designator eg "X"
+#define motor_driver_control_checksum  CHECKSUM("motor_driver_control")
+#define motor_load_checksum            CHECKSUM("motor_load")
+
+// returned as a pointer, updated by the stallguard sampling while the motor moves
+using pad_motor_load_t = struct pad_motor_load {
+    volatile uint32_t samples; // stallguard readings taken
+    volatile uint32_t stalls;  // number of times the motor was seen to stall
+    volatile uint64_t total;   // sum of the readings, for the average
+    volatile uint16_t last;    // last reading 0 - 1023, the lower it is the higher the load
+    volatile uint16_t min;     // highest load seen
+    volatile bool stalled;     // latched when a stall is detected, cleared by whoever is watching for it
+    volatile bool homing;      // set by endstops while it is homing this motor sensorless, stalls are expected then
+};
@@ -738,6 +738,16 @@ int TMC26X::getCurrentStallGuardReading(void)
     return getReadoutValue();
 }
 
+// unlike getCurrentStallGuardReading() this never changes the readout selection, so it is cheap enough to sample often
+int TMC26X::readStallGuard(void)
+{
+    if (!started || (driver_configuration_register_value & READ_SELECTION_PATTERN) != READ_STALL_GUARD_READING) {
+        return -1;
+    }
+    send262(driver_configuration_register_value);
+    return getReadoutValue();
+}
+
 uint8_t TMC26X::getCurrentCSReading(void)
 {
     //if we don't yet started there cannot be a stall guard value
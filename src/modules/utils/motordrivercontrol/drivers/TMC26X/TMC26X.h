@@ -278,6 +278,12 @@ public:
      */
     int getCurrentStallGuardReading(void);
 
+    /*!
+     * \brief reads the StallGuard value with a single transfer, used for the high rate sampling while the motor moves
+     * \return the StallGuard value, or -1 if the readout is not currently set to StallGuard (eg after getCurrentCSReading())
+     */
+    int readStallGuard(void);
+
     /*!
      * \brief Reads the current current setting value as fraction of the maximum current
      * Returns values between 0 and 31, representing 1/32 to 32/32 (=1)
@@ -8,6 +8,7 @@
 #include "libs/Kernel.h"
 #include "Panel.h"
 #include "PanelScreen.h"
+#include "PanelCache.h"
 
 #include "libs/nuts_bolts.h"
 #include "libs/utils.h"
@@ -88,6 +89,7 @@ Panel::Panel()
     this->idle_time = 0;
     this->start_up = true;
     this->current_screen = NULL;
+    this->cache = new PanelCache();
     this->sd= nullptr;
     this->extmounter= nullptr;
     this->external_sd_enable= false;
@@ -99,6 +101,7 @@ Panel::Panel()
 Panel::~Panel()
 {
     delete this->lcd;
+    delete this->cache;
     delete this->extmounter;
     delete this->sd;
 }
@@ -202,6 +205,7 @@ void Panel::on_module_loaded()
     this->register_for_event(ON_IDLE);
     this->register_for_event(ON_MAIN_LOOP);
     this->register_for_event(ON_SET_PUBLIC_DATA);
+    PublicData::register_handler(ON_SET_PUBLIC_DATA, this, panel_checksum, panel_display_message_checksum);
 
     // Refresh timer
     THEKERNEL->slow_ticker->attach( 20, this, &Panel::refresh_tick );
@@ -213,6 +217,9 @@ void Panel::enter_screen(PanelScreen *screen)
     if(this->current_screen != nullptr)
         this->current_screen->on_exit();
 
+    // the new screen subscribes to what it needs in on_enter
+    this->cache->clear();
+
     if(screen == nullptr) {
         screen= top_screen;
     }
@@ -306,6 +313,7 @@ void Panel::on_set_public_data(void *argument)
     } else {
         this->message= *s;
     }
+    pdr->set_taken();
 }
 
 // on main loop, we can send gcodes or do anything that waits in this loop
@@ -434,6 +442,7 @@ void Panel::idle_processing()
     if ( this->refresh_flag ) {
         this->refresh_flag = false;
         if (this->current_screen != NULL) {
+            this->cache->update();
             this->current_screen->on_refresh();
             this->lcd->on_refresh();
         }
@@ -628,26 +637,12 @@ float Panel::get_control_value()
 
 bool Panel::is_playing() const
 {
-    void *returned_data;
-
-    bool ok = PublicData::get_value( player_checksum, is_playing_checksum, &returned_data );
-    if (ok) {
-        bool b = *static_cast<bool *>(returned_data);
-        return b;
-    }
-    return false;
+    return this->cache->is_playing();
 }
 
 bool Panel::is_suspended() const
 {
-    void *returned_data;
-
-    bool ok = PublicData::get_value( player_checksum, is_suspended_checksum, &returned_data );
-    if (ok) {
-        bool b = *static_cast<bool *>(returned_data);
-        return b;
-    }
-    return false;
+    return this->cache->is_suspended();
 }
 
 bool Panel::is_extruder_display_enabled(void)
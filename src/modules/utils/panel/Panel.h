@@ -17,6 +17,7 @@
 #define THEPANEL Panel::instance
 
 class LcdBase;
+class PanelCache;
 class PanelScreen;
 class ModifyValuesScreen;
 class SDCard;
@@ -90,6 +91,7 @@ class Panel : public Module {
         // TODO pass lcd into ctor of each sub screen
         LcdBase* lcd;
         PanelScreen* custom_screen;
+        PanelCache* cache;
 
         using encoder_cb_t= std::function<void(int ticks)>;
         bool enter_direct_encoder_mode(encoder_cb_t fnc);
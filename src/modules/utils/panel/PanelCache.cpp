@@ -0,0 +1,205 @@
+/*
+      This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+      Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+      Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PanelCache.h"
+#include "libs/Kernel.h"
+#include "PublicData.h"
+#include "checksumm.h"
+#include "SwitchPublicAccess.h"
+#include "NetworkPublicAccess.h"
+#include "ExtruderPublicAccess.h"
+
+#include "us_ticker_api.h" // mbed.h lib
+
+#include <math.h>
+#include <string.h>
+
+#define extruder_checksum CHECKSUM("extruder")
+
+PanelCache::PanelCache()
+{
+    memset(items, 0, sizeof(items));
+    memset(ip, 0, sizeof(ip));
+    progress.percent_complete= 0;
+    progress.elapsed_secs= 0;
+    extruder_position= 0;
+    fan_state= playing= suspended= false;
+    dirty= false;
+}
+
+// the current screen wants item to be no older than period_ms
+void PanelCache::subscribe(ITEM item, uint32_t period_ms)
+{
+    items[item].subscribed= true;
+    items[item].period= period_ms;
+    read(item);
+}
+
+void PanelCache::clear()
+{
+    for (auto &i : items) i.subscribed= false;
+    dirty= false;
+}
+
+// called by the panel before each screen refresh, fetches the subscribed items that are due
+void PanelCache::update()
+{
+    uint32_t now= us_ticker_read() / 1000;
+    for (int i = 0; i < N_ITEMS; ++i) {
+        item_t &it= items[i];
+        if(!it.subscribed || (now - it.last) < it.period) continue;
+        if(fetch((ITEM)i)) dirty= true;
+    }
+}
+
+// true if anything subscribed changed since the last time this was asked
+bool PanelCache::changed()
+{
+    bool d= dirty;
+    dirty= false;
+    return d;
+}
+
+// an item that is not subscribed has no period to go by, so it is fetched on every read
+void PanelCache::read(ITEM item)
+{
+    if(!items[item].subscribed) {
+        if(fetch(item)) dirty= true;
+    }
+}
+
+// ask the modules for the item, returns true if what would be displayed changed
+bool PanelCache::fetch(ITEM item)
+{
+    items[item].last= us_ticker_read() / 1000;
+    bool ok= false, changed= false;
+
+    switch(item) {
+        case TEMPERATURES: {
+            std::vector<pad_temperature> v;
+            ok= PublicData::get_value(temperature_control_checksum, poll_controls_checksum, &v);
+            // temperatures are displayed as whole degrees
+            changed= v.size() != temperatures.size();
+            for (size_t i = 0; !changed && i < v.size(); ++i) {
+                changed= v[i].id != temperatures[i].id ||
+                         lroundf(v[i].current_temperature) != lroundf(temperatures[i].current_temperature) ||
+                         lroundf(v[i].target_temperature) != lroundf(temperatures[i].target_temperature);
+            }
+            temperatures.swap(v);
+            break;
+        }
+
+        case FAN: {
+            struct pad_switch s;
+            ok= PublicData::get_value(switch_checksum, fan_checksum, 0, &s);
+            bool state= ok && s.state; // fan probably disabled if not ok
+            changed= state != fan_state;
+            fan_state= state;
+            break;
+        }
+
+        case PROGRESS: {
+            void *returned_data;
+            ok= PublicData::get_value(player_checksum, get_progress_checksum, &returned_data);
+            if(ok) {
+                struct pad_progress p= *static_cast<struct pad_progress *>(returned_data);
+                changed= p.percent_complete != progress.percent_complete || p.elapsed_secs != progress.elapsed_secs || p.filename != progress.filename;
+                progress= p;
+            }
+            break;
+        }
+
+        case PLAYER_STATE: {
+            void *returned_data;
+            bool p= false, s= false;
+            if(PublicData::get_value(player_checksum, is_playing_checksum, &returned_data)) {
+                p= *static_cast<bool *>(returned_data);
+                ok= true;
+            }
+            if(PublicData::get_value(player_checksum, is_suspended_checksum, &returned_data)) {
+                s= *static_cast<bool *>(returned_data);
+                ok= true;
+            }
+            changed= p != playing || s != suspended;
+            playing= p;
+            suspended= s;
+            break;
+        }
+
+        case NETWORK: {
+            void *returned_data;
+            ok= PublicData::get_value(network_checksum, get_ip_checksum, &returned_data);
+            if(ok) {
+                changed= memcmp(ip, returned_data, sizeof(ip)) != 0;
+                memcpy(ip, returned_data, sizeof(ip));
+            }
+            break;
+        }
+
+        case EXTRUDER: {
+            pad_extruder_t rd;
+            ok= PublicData::get_value(extruder_checksum, (void *)&rd);
+            if(ok) {
+                changed= lroundf(rd.current_position * 100) != lroundf(extruder_position * 100);
+                extruder_position= rd.current_position;
+            }
+            break;
+        }
+
+        default: break;
+    }
+
+    changed= changed || ok != items[item].valid;
+    items[item].valid= ok;
+    return changed;
+}
+
+const std::vector<pad_temperature>& PanelCache::get_temperatures()
+{
+    read(TEMPERATURES);
+    return temperatures;
+}
+
+bool PanelCache::get_fan_state()
+{
+    read(FAN);
+    return fan_state;
+}
+
+bool PanelCache::get_progress(pad_progress &p)
+{
+    read(PROGRESS);
+    if(!items[PROGRESS].valid) return false;
+    p= progress;
+    return true;
+}
+
+bool PanelCache::is_playing()
+{
+    read(PLAYER_STATE);
+    return playing;
+}
+
+bool PanelCache::is_suspended()
+{
+    read(PLAYER_STATE);
+    return suspended;
+}
+
+// nullptr if there is no network
+const uint8_t *PanelCache::get_ip()
+{
+    read(NETWORK);
+    return items[NETWORK].valid ? ip : nullptr;
+}
+
+bool PanelCache::get_extruder_position(float &pos)
+{
+    read(EXTRUDER);
+    pos= extruder_position;
+    return items[EXTRUDER].valid;
+}
@@ -0,0 +1,73 @@
+/*
+      This file is part of Smoothie (http://smoothieware.org/). The motion control part is heavily based on Grbl (https://github.com/simen/grbl).
+      Smoothie is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+      Smoothie is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License along with Smoothie. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PANELCACHE_H
+#define PANELCACHE_H
+
+#include "TemperatureControlPublicAccess.h"
+#include "PlayerPublicAccess.h"
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// Holds the PublicData the screens display so each value is only fetched from the modules as often as the current
+// screen asked for it, however many lines read it. Every fetch is an ON_GET_PUBLIC_DATA broadcast to every module.
+// Subscriptions are dropped whenever the panel changes screen, an item that is not subscribed is fetched on every read.
+class PanelCache {
+    public:
+        enum ITEM {
+            TEMPERATURES,   // every temperature control, from one poll
+            FAN,            // switch.fan state
+            PROGRESS,       // sd play progress
+            PLAYER_STATE,   // is playing and is suspended
+            NETWORK,        // ip address
+            EXTRUDER,       // current extruder position
+            N_ITEMS
+        };
+
+        PanelCache();
+
+        void subscribe(ITEM item, uint32_t period_ms);
+        void clear();
+        void update();
+        bool changed();
+
+        const std::vector<pad_temperature>& get_temperatures();
+        bool get_fan_state();
+        bool get_progress(pad_progress &p);
+        bool is_playing();
+        bool is_suspended();
+        const uint8_t *get_ip();
+        bool get_extruder_position(float &pos);
+
+    private:
+        bool fetch(ITEM item);
+        void read(ITEM item);
+
+        struct item_t {
+            uint32_t period; // ms
+            uint32_t last;   // ms
+            bool subscribed:1;
+            bool valid:1;    // the module answered
+        };
+        item_t items[N_ITEMS];
+
+        std::vector<pad_temperature> temperatures;
+        pad_progress progress;
+        float extruder_position;
+        uint8_t ip[4];
+
+        struct {
+            bool fan_state:1;
+            bool playing:1;
+            bool suspended:1;
+            bool dirty:1;
+        };
+};
+
+#endif
@@ -13,6 +13,8 @@
 #include "checksumm.h"
 #include "StreamOutputPool.h"
 #include "ConfigValue.h"
+#include "lpc17xx_gpdma.h"
+#include "lpc17xx_clkpwr.h"
 
 
 
@@ -42,6 +44,15 @@
 #define a0_pin_checksum            CHECKSUM("a0_pin")
 #define red_led_checksum           CHECKSUM("red_led_pin")
 #define blue_led_checksum          CHECKSUM("blue_led_pin")
+#define spi_dma_checksum           CHECKSUM("spi_dma")
+
+// the ADC has channel 7
+#define LCD_DMA_CHANNEL 6
+#define LCD_DMA_CH LPC_GPDMACH6
+
+#define SSP_SR_BSY (1 << 4)
+#define SSP_SR_RNE (1 << 2)
+#define SSP_DMACR_TXDMAE (1 << 1)
 
 #define CLAMP(x, low, high) { if ( (x) < (low) ) x = (low); if ( (x) > (high) ) x = (high); } while (0);
 #define swap(a, b) { uint8_t t = a; a = b; b = t; }
@@ -51,6 +62,12 @@ ST7565::ST7565(uint8_t variant)
     is_viki2 = false;
     is_mini_viki2 = false;
     is_ssd1306= false;
+    use_dma= false;
+    dma_busy= false;
+    dma_buffer= nullptr;
+    dirty_pages= 0xFF;
+    pending_pages= 0;
+    memset(sent_hash, 0, sizeof(sent_hash));
 
     // set the variant
     switch(variant) {
@@ -155,17 +172,43 @@ ST7565::ST7565(uint8_t variant)
         THEKERNEL->streams->printf("Not enough memory available for frame buffer");
     }
 
+    // only safe if nothing else is on the same SPI bus, as the transfer runs on while the main loop does other things
+    if(THEKERNEL->config->value(panel_checksum, spi_dma_checksum)->by_default(false)->as_bool()) {
+        setup_dma(spi_channel);
+    }
 }
 
 ST7565::~ST7565()
 {
+    wait_dma();
     delete this->spi;
     AHB0.dealloc(framebuffer);
+    if(dma_buffer != nullptr) AHB0.dealloc(dma_buffer);
+}
+
+void ST7565::setup_dma(int spi_channel)
+{
+    // DMA cannot access the local SRAM so the page being sent is copied to AHB SRAM
+    dma_buffer= (unsigned char *)AHB0.alloc(LCDWIDTH);
+    if(dma_buffer == nullptr) return;
+
+    if(spi_channel == 1) {
+        ssp= LPC_SSP1;
+        dma_conn= GPDMA_CONN_SSP1_Tx;
+    } else {
+        ssp= LPC_SSP0;
+        dma_conn= GPDMA_CONN_SSP0_Tx;
+    }
+
+    // GPDMA_Init() resets every channel, so only call it if nobody has powered the GPDMA up yet
+    if(!(LPC_SC->PCONP & CLKPWR_PCONP_PCGPDMA)) GPDMA_Init();
+    use_dma= true;
 }
 
 //send commands to lcd
 void ST7565::send_commands(const unsigned char *buf, size_t size)
 {
+    wait_dma();
     cs.set(0);
     if(a0.connected()) a0.set(0);
     while(size-- > 0) {
@@ -177,6 +220,7 @@ void ST7565::send_commands(const unsigned char *buf, size_t size)
 //send data to lcd
 void ST7565::send_data(const unsigned char *buf, size_t size)
 {
+    wait_dma();
     cs.set(0);
     if(a0.connected()) a0.set(1);
     while(size-- > 0) {
@@ -190,6 +234,7 @@ void ST7565::send_data(const unsigned char *buf, size_t size)
 void ST7565::clear()
 {
     memset(framebuffer, 0, FB_SIZE);
+    dirty_pages= 0xFF;
     this->tx = 0;
     this->ty = 0;
 }
@@ -339,6 +384,8 @@ int ST7565::drawChar(int x, int y, unsigned char c, int color)
     if(c == '\r') {
         retVal = -tx;
     } else {
+        mark_dirty(y);
+        if(y + 8 < 63) mark_dirty(y + 8);
         for (uint8_t i = 0; i < 5; i++ ) {
             if(color == 0) {
                 framebuffer[x + (y / 8 * 128) ] = ~(glcd_font[(c * 5) + i] << y % 8);
@@ -381,8 +428,108 @@ void ST7565::on_refresh(bool now)
     refresh_counts++;
     // 10Hz refresh rate
     if(now || refresh_counts % 2 == 0 ) {
-        send_pic(framebuffer);
+        queue_dirty_pages(now);
+        if(now || !use_dma) {
+            // send it all now
+            while(pending_pages != 0) send_next_page();
+            wait_dma();
+        } else {
+            send_next_page();
+        }
+    }
+}
+
+// with DMA one page is sent per main loop, the first from on_refresh
+void ST7565::on_main_loop()
+{
+    if(!use_dma || (!dma_busy && pending_pages == 0)) return;
+    // still going
+    if(dma_busy && (LPC_GPDMA->DMACEnbldChns & GPDMA_DMACEnbldChns_Ch(LCD_DMA_CHANNEL))) return;
+
+    wait_dma();
+    send_next_page();
+}
+
+// FNV-1a, only has to tell if a page changed since it was last sent
+uint32_t ST7565::page_hash(int page) const
+{
+    const unsigned char *p = &framebuffer[page * LCDWIDTH];
+    uint32_t h = 2166136261UL;
+    for (int i = 0; i < LCDWIDTH; i++) {
+        h ^= p[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+// screens tend to redraw everything every refresh, so a page that was drawn to is only sent if it is different to what is on the glass
+void ST7565::queue_dirty_pages(bool all)
+{
+    if(all) dirty_pages = 0xFF;
+    for (int i = 0; i < LCDPAGES; i++) {
+        if(!(dirty_pages & (1 << i))) continue;
+        uint32_t h = page_hash(i);
+        if(all || h != sent_hash[i]) {
+            sent_hash[i] = h;
+            pending_pages |= (1 << i);
+        }
+    }
+    dirty_pages = 0;
+}
+
+void ST7565::send_next_page()
+{
+    int page = 0;
+    while(page < LCDPAGES && !(pending_pages & (1 << page))) page++;
+    if(page == LCDPAGES) return;
+    pending_pages &= ~(1 << page);
+
+    set_xy(0, page); // also waits for any previous page to finish
+    if(!use_dma) {
+        send_data(framebuffer + page * LCDWIDTH, LCDWIDTH);
+        return;
+    }
+
+    memcpy(dma_buffer, framebuffer + page * LCDWIDTH, LCDWIDTH);
+
+    GPDMA_Channel_CFG_Type cfg;
+    cfg.ChannelNum= LCD_DMA_CHANNEL;
+    cfg.TransferSize= LCDWIDTH;
+    cfg.TransferWidth= 0; // set from the peripheral
+    cfg.TransferType= GPDMA_TRANSFERTYPE_M2P;
+    cfg.SrcConn= 0;
+    cfg.DstConn= dma_conn;
+    cfg.SrcMemAddr= (uint32_t)dma_buffer;
+    cfg.DstMemAddr= 0;
+    cfg.DMALLI= 0;
+    if(GPDMA_Setup(&cfg) != SUCCESS) {
+        // should not happen, but the page still needs to go out
+        send_data(framebuffer + page * LCDWIDTH, LCDWIDTH);
+        return;
     }
+
+    cs.set(0);
+    if(a0.connected()) a0.set(1);
+    ssp->DMACR |= SSP_DMACR_TXDMAE;
+    dma_busy= true;
+    GPDMA_ChannelCmd(LCD_DMA_CHANNEL, ENABLE);
+}
+
+// wait for a DMA page transfer to complete and put the SPI back the way mbed::SPI expects it
+void ST7565::wait_dma()
+{
+    if(!dma_busy) return;
+
+    while(LPC_GPDMA->DMACEnbldChns & GPDMA_DMACEnbldChns_Ch(LCD_DMA_CHANNEL)) ;
+    // the last few bytes are still in the FIFO
+    while(ssp->SR & SSP_SR_BSY) ;
+    ssp->DMACR &= ~SSP_DMACR_TXDMAE;
+    // everything clocked out also clocked something in, which mbed::SPI would read as the reply to its next write
+    while(ssp->SR & SSP_SR_RNE) (void)ssp->DR;
+
+    cs.set(1);
+    if(a0.connected()) a0.set(0);
+    dma_busy= false;
 }
 
 //reading button state
@@ -456,6 +603,7 @@ void ST7565::renderGlyph(int x, int y, const uint8_t *g, int w, int h)
 
 void ST7565::pixel(int x, int y, int colour)
 {
+    mark_dirty(y);
     int page = y / 8;
     unsigned char mask = 1 << (y % 8);
     unsigned char *byte = &framebuffer[page * LCDWIDTH + x];
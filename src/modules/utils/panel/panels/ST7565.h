@@ -25,6 +25,7 @@ public:
 	void write(const char* line, int len);
 
 	void on_refresh(bool now=false);
+	void on_main_loop();
 	//encoder which dosent exist :/
 	uint8_t readButtons();
 	int readEncoderDelta();
@@ -55,10 +56,26 @@ public:
     void setLed(int led, bool onoff);
 
 private:
+    void mark_dirty(int y) { dirty_pages |= 1 << ((y / 8) & 0x07); }
+    uint32_t page_hash(int page) const;
+    void queue_dirty_pages(bool all);
+    void setup_dma(int spi_channel);
+    void send_next_page();
+    void wait_dma();
 
     //buffer
 	unsigned char *framebuffer;
 	mbed::SPI* spi;
+
+    // pages drawn to since the last refresh, pages waiting to be sent and a hash of what is on the glass for each page
+    uint8_t dirty_pages;
+    uint8_t pending_pages;
+    uint32_t sent_hash[8];
+
+    // optional GPDMA transfer of the page data, the page is copied to AHB SRAM so it can be drawn to while it is sent
+    unsigned char *dma_buffer;
+    LPC_SSP_TypeDef *ssp;
+    uint32_t dma_conn;
 	Pin cs;
 	Pin rst;
 	Pin a0;
@@ -82,6 +99,8 @@ private:
         bool is_ssd1306:1;
         bool use_pause:1;
         bool use_back:1;
+        bool use_dma:1;
+        bool dma_busy:1;
     };
 };
 
@@ -8,6 +8,7 @@
 #include "Kernel.h"
 #include "LcdBase.h"
 #include "Panel.h"
+#include "PanelCache.h"
 #include "PanelScreen.h"
 #include "MainMenuScreen.h"
 #include "WatchScreen.h"
@@ -46,14 +47,14 @@ static const uint8_t icons[] = { // 16x80 - he1, he2, he3, bed, fan
 	0xa1, 0xc0, 0xa1, 0xc5, 0x93, 0xd9, 0x47, 0xc2, 0x37, 0x9c
 };
 
-#define extruder_checksum CHECKSUM("extruder")
-
 WatchScreen::WatchScreen()
 {
     speed_changed = false;
     issue_change_speed = false;
     ipstr = nullptr;
     update_counts= 0;
+    last_pos[0]= last_pos[1]= last_pos[2]= 0;
+    last_speed= 0;
 }
 
 WatchScreen::~WatchScreen()
@@ -63,6 +64,15 @@ WatchScreen::~WatchScreen()
 
 void WatchScreen::on_enter()
 {
+    // everything on this screen is shown once a second, the ip address hardly ever changes
+    PanelCache *cache= THEPANEL->cache;
+    cache->subscribe(PanelCache::TEMPERATURES, 1000);
+    cache->subscribe(PanelCache::FAN, 1000);
+    cache->subscribe(PanelCache::PROGRESS, 1000);
+    cache->subscribe(PanelCache::PLAYER_STATE, 1000);
+    cache->subscribe(PanelCache::NETWORK, 10000);
+    if(THEPANEL->is_extruder_display_enabled()) cache->subscribe(PanelCache::EXTRUDER, 1000);
+
     THEPANEL->lcd->clear();
     THEPANEL->setup_menu(4);
     get_current_status();
@@ -72,23 +82,6 @@ void WatchScreen::on_enter()
     this->refresh_screen(false);
     THEPANEL->enter_control_mode(1, 0.5);
     THEPANEL->set_control_value(this->current_speed);
-
-    // enumerate temperature controls
-    temp_controllers.clear();
-    std::vector<struct pad_temperature> controllers;
-    bool ok = PublicData::get_value(temperature_control_checksum, poll_controls_checksum, &controllers);
-    if (ok) {
-        for (auto &c : controllers) {
-            temp_controllers.push_back(c.id);
-        }
-    }
-}
-
-static struct pad_temperature getTemperatures(uint16_t heater_cs)
-{
-    struct pad_temperature temp;
-    PublicData::get_value( temperature_control_checksum, current_temperature_checksum, heater_cs, &temp );
-    return temp;
 }
 
 void WatchScreen::on_refresh()
@@ -117,6 +110,7 @@ void WatchScreen::on_refresh()
     // Update Only every 20 refreshes, 1 a second
     update_counts++;
     if ( update_counts % 20 == 0 ) {
+        bool changed= THEPANEL->cache->changed();
         get_sd_play_info();
         get_current_pos(this->pos);
         get_current_status();
@@ -130,13 +124,22 @@ void WatchScreen::on_refresh()
             THEPANEL->reset_counter();
         }
 
+        // only redraw if something shown changed, with more than two heaters they are cycled every 5 seconds
+        const char *status= this->get_status();
+        changed= changed || this->current_speed != this->last_speed || this->last_status != status ||
+                 memcmp(this->pos, this->last_pos, sizeof(this->pos)) != 0 ||
+                 (THEPANEL->cache->get_temperatures().size() > 2 && update_counts % 100 == 0);
+        if(!changed) return;
+        this->last_speed= this->current_speed;
+        this->last_status= status;
+        memcpy(this->last_pos, this->pos, sizeof(this->pos));
+
         this->refresh_screen(THEPANEL->lcd->hasGraphics() ? true : false); // graphics screens should be cleared
 
         // for LCDs with leds set them according to heater status
         bool bed_on= false, hotend_on= false, is_hot= false;
         uint8_t heon=0, hemsk= 0x01; // bit set for which hotend is on bit0: hotend1, bit1: hotend2 etc
-        for(auto id : temp_controllers) {
-            struct pad_temperature c= getTemperatures(id);
+        for(auto &c : THEPANEL->cache->get_temperatures()) {
             if(c.current_temperature > 50) is_hot= true; // anything is hot
             if(c.designator.front() == 'B' && c.target_temperature > 0) bed_on= true;   // bed on/off
             if(c.designator.front() == 'T') { // a hotend by convention
@@ -185,15 +188,8 @@ void WatchScreen::on_main_loop()
 // fetch the data we are displaying
 void WatchScreen::get_current_status()
 {
-    // get fan status
-    struct pad_switch s;
-    bool ok = PublicData::get_value( switch_checksum, fan_checksum, 0, &s );
-    if (ok) {
-        this->fan_state = s.state;
-    } else {
-        // fan probably disabled
-        this->fan_state = false;
-    }
+    // get fan status, false if the fan is disabled
+    this->fan_state = THEPANEL->cache->get_fan_state();
 }
 
 // fetch the data we are displaying
@@ -205,10 +201,8 @@ float WatchScreen::get_current_speed()
 
 void WatchScreen::get_sd_play_info()
 {
-    void *returned_data;
-    bool ok = PublicData::get_value( player_checksum, get_progress_checksum, &returned_data );
-    if (ok) {
-        struct pad_progress p =  *static_cast<struct pad_progress *>(returned_data);
+    struct pad_progress p;
+    if (THEPANEL->cache->get_progress(p)) {
         this->elapsed_time = p.elapsed_secs;
         this->sd_pcnt_played = p.percent_complete;
         THEPANEL->set_playing_file(p.filename);
@@ -225,7 +219,7 @@ void WatchScreen::display_menu_line(uint16_t line)
     switch ( line ) {
         case 0:
         {
-            auto& tm= this->temp_controllers;
+            auto& tm= THEPANEL->cache->get_temperatures();
             if(tm.size() > 0) {
                 // only if we detected heaters in config
                 int n= 0;
@@ -240,7 +234,7 @@ void WatchScreen::display_menu_line(uint16_t line)
                 for (size_t i = 0; i < 2; ++i) {
                     size_t o= i+(n*2);
                     if(o>tm.size()-1) break;
-                    struct pad_temperature temp= getTemperatures(tm[o]);
+                    const struct pad_temperature &temp= tm[o];
                     int t= std::min(999, (int)roundf(temp.current_temperature));
                     int tt= roundf(temp.target_temperature);
                     THEPANEL->lcd->setCursor(off, 0); // col, row
@@ -253,9 +247,8 @@ void WatchScreen::display_menu_line(uint16_t line)
             break;
         }
         case 1: {
-            pad_extruder_t rd;
-            if ( THEPANEL->is_extruder_display_enabled() && THEPANEL->is_playing() && PublicData::get_value(extruder_checksum, (void *)&rd)) {
-                float extruder_pos = rd.current_position;
+            float extruder_pos;
+            if ( THEPANEL->is_extruder_display_enabled() && THEPANEL->is_playing() && THEPANEL->cache->get_extruder_position(extruder_pos)) {
                 THEPANEL->lcd->printf("E %1.2f", extruder_pos);
                 THEPANEL->lcd->setCursor(12, line);
                 THEPANEL->lcd->printf("Z%7.2f", this->pos[2]);
@@ -301,11 +294,8 @@ void WatchScreen::set_speed()
 
 const char *WatchScreen::get_network()
 {
-    void *returned_data;
-
-    bool ok = PublicData::get_value( network_checksum, get_ip_checksum, &returned_data );
-    if (ok) {
-        uint8_t *ipaddr = (uint8_t *)returned_data;
+    const uint8_t *ipaddr = THEPANEL->cache->get_ip();
+    if (ipaddr != nullptr) {
         char buf[20];
         int n = snprintf(buf, sizeof(buf), "IP %d.%d.%d.%d", ipaddr[0], ipaddr[1], ipaddr[2], ipaddr[3]);
         buf[n] = 0;
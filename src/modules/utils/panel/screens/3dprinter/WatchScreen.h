@@ -11,6 +11,7 @@
 #include "PanelScreen.h"
 
 #include <tuple>
+#include <string>
 
 class WatchScreen : public PanelScreen
 {
@@ -30,11 +31,14 @@ private:
     const char *get_status();
     const char *get_network();
 
-    std::vector<uint16_t> temp_controllers;
-
     uint32_t update_counts;
     int current_speed;
     float pos[3];
+
+    // what was last drawn
+    int last_speed;
+    float last_pos[3];
+    std::string last_status;
     unsigned long elapsed_time;
     unsigned int sd_pcnt_played;
     char *ipstr;
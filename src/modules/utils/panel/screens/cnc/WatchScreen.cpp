@@ -8,6 +8,7 @@
 #include "libs/Kernel.h"
 #include "LcdBase.h"
 #include "Panel.h"
+#include "PanelCache.h"
 #include "PanelScreen.h"
 #include "MainMenuScreen.h"
 #include "WatchScreen.h"
@@ -44,6 +45,9 @@ WatchScreen::WatchScreen()
     issue_change_speed = false;
     ipstr = nullptr;
     update_counts= 0;
+    last_speed= 0;
+    memset(last_pos, 0, sizeof(last_pos));
+    last_feedrate= 0;
 }
 
 WatchScreen::~WatchScreen()
@@ -53,6 +57,13 @@ WatchScreen::~WatchScreen()
 
 void WatchScreen::on_enter()
 {
+    // the positions come straight from the robot, the rest is shown once a second and the ip address hardly ever changes
+    PanelCache *cache= THEPANEL->cache;
+    cache->subscribe(PanelCache::FAN, 1000);
+    cache->subscribe(PanelCache::PROGRESS, 1000);
+    cache->subscribe(PanelCache::PLAYER_STATE, 1000);
+    cache->subscribe(PanelCache::NETWORK, 10000);
+
     THEPANEL->lcd->clear();
     THEPANEL->setup_menu(8);
     get_current_status();
@@ -90,6 +101,7 @@ void WatchScreen::on_refresh()
     // Update Only every 20 refreshes, 1 a second
     update_counts++;
     if ( update_counts % 20 == 0 ) {
+        bool changed= THEPANEL->cache->changed();
         get_sd_play_info();
         get_wpos();
         get_current_status();
@@ -103,6 +115,20 @@ void WatchScreen::on_refresh()
             THEPANEL->reset_counter();
         }
 
+        // only redraw if something shown changed, the laser power is not tracked so that is always redrawn
+        const char *status= this->get_status();
+        float feedrate= THEKERNEL->conveyor->get_current_feedrate();
+        changed= changed || THEPANEL->has_laser() || this->current_speed != this->last_speed || this->last_status != status ||
+                 memcmp(this->wpos, this->last_pos, sizeof(this->wpos)) != 0 || memcmp(this->mpos, this->last_pos + 3, sizeof(this->mpos)) != 0 ||
+                 feedrate != this->last_feedrate || this->wcs != this->last_wcs;
+        if(!changed) return;
+        this->last_speed= this->current_speed;
+        this->last_status= status;
+        memcpy(this->last_pos, this->wpos, sizeof(this->wpos));
+        memcpy(this->last_pos + 3, this->mpos, sizeof(this->mpos));
+        this->last_feedrate= feedrate;
+        this->last_wcs= this->wcs;
+
         this->refresh_screen(THEPANEL->lcd->hasGraphics() ? true : false); // graphics screens should be cleared
     }
 }
@@ -138,15 +164,8 @@ void WatchScreen::on_main_loop()
 // fetch the data we are displaying
 void WatchScreen::get_current_status()
 {
-    // get spindle status
-    struct pad_switch s;
-    bool ok = PublicData::get_value( switch_checksum, fan_checksum, 0, &s );
-    if (ok) {
-        this->spindle_state = s.state;
-    } else {
-        // spindle probably disabled
-        this->spindle_state = false;
-    }
+    // get spindle status, false if the spindle is disabled
+    this->spindle_state = THEPANEL->cache->get_fan_state();
 }
 
 // fetch the data we are displaying
@@ -158,10 +177,8 @@ float WatchScreen::get_current_speed()
 
 void WatchScreen::get_sd_play_info()
 {
-    void *returned_data;
-    bool ok = PublicData::get_value( player_checksum, get_progress_checksum, &returned_data );
-    if (ok) {
-        struct pad_progress p =  *static_cast<struct pad_progress *>(returned_data);
+    struct pad_progress p;
+    if (THEPANEL->cache->get_progress(p)) {
         this->elapsed_time = p.elapsed_secs;
         this->sd_pcnt_played = p.percent_complete;
         THEPANEL->set_playing_file(p.filename);
@@ -231,11 +248,8 @@ void WatchScreen::set_speed()
 
 const char *WatchScreen::get_network()
 {
-    void *returned_data;
-
-    bool ok = PublicData::get_value( network_checksum, get_ip_checksum, &returned_data );
-    if (ok) {
-        uint8_t *ipaddr = (uint8_t *)returned_data;
+    const uint8_t *ipaddr = THEPANEL->cache->get_ip();
+    if (ipaddr != nullptr) {
         char buf[20];
         int n = snprintf(buf, sizeof(buf), "IP %d.%d.%d.%d", ipaddr[0], ipaddr[1], ipaddr[2], ipaddr[3]);
         buf[n] = 0;
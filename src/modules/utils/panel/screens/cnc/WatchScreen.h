@@ -11,6 +11,7 @@
 #include "PanelScreen.h"
 
 #include <tuple>
+#include <string>
 
 class WatchScreen : public PanelScreen
 {
@@ -39,6 +40,13 @@ private:
     unsigned int sd_pcnt_played;
     char *ipstr;
 
+    // what was last drawn
+    int last_speed;
+    float last_pos[6];
+    float last_feedrate;
+    std::string last_wcs;
+    std::string last_status;
+
     struct {
         bool speed_changed:1;
         bool issue_change_speed:1;
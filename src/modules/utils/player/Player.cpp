@@ -62,6 +62,8 @@ void Player::on_module_loaded()
     this->register_for_event(ON_SECOND_TICK);
     this->register_for_event(ON_GET_PUBLIC_DATA);
     this->register_for_event(ON_SET_PUBLIC_DATA);
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, this, player_checksum);
+    PublicData::register_handler(ON_SET_PUBLIC_DATA, this, player_checksum);
     this->register_for_event(ON_GCODE_RECEIVED);
     this->register_for_event(ON_HALT);
 
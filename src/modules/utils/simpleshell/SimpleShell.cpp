@@ -29,6 +29,7 @@
 #include "StepperMotor.h"
 #include "Configurator.h"
 #include "Block.h"
+#include "SlowTicker.h"
 
 #include "TemperatureControlPublicAccess.h"
 #include "EndstopsPublicAccess.h"
@@ -86,6 +87,10 @@ const SimpleShell::ptentry_t SimpleShell::commands_table[] = {
     {"thermistors", SimpleShell::print_thermistors_command},
     {"md5sum",   SimpleShell::md5sum_command},
     {"test",     SimpleShell::test_command},
+    {"ticker",   SimpleShell::ticker_command},
+#ifdef PERF_PROFILING
+    {"perf",     SimpleShell::perf_command},
+#endif
 
     // unknown command
     {NULL, NULL}
@@ -612,7 +617,7 @@ static uint32_t getDeviceType()
     return result[1];
 }
 
-// get network config
+// get network config and the ethernet frame statistics
 void SimpleShell::net_command( string parameters, StreamOutput *stream)
 {
     void *returned_data;
@@ -624,9 +629,44 @@ void SimpleShell::net_command( string parameters, StreamOutput *stream)
 
     } else {
         stream->printf("No network detected\n");
+        return;
+    }
+
+    if(PublicData::get_value( network_checksum, get_netstats_checksum, &returned_data )) {
+        char *str = (char *)returned_data;
+        stream->printf("%s", str);
+        free(str);
     }
 }
 
+// show SlowTicker hook execution times and ISR load, -r resets the statistics
+void SimpleShell::ticker_command( string parameters, StreamOutput *stream)
+{
+    string opt = shift_parameter(parameters);
+    if(opt == "-r") {
+        THEKERNEL->slow_ticker->reset_stats();
+        stream->printf("SlowTicker statistics reset\n");
+        return;
+    }
+
+    THEKERNEL->slow_ticker->print_stats(stream);
+}
+
+#ifdef PERF_PROFILING
+// show the time spent in each module event handler, the tick interrupts and the main loop, -r resets them
+void SimpleShell::perf_command( string parameters, StreamOutput *stream)
+{
+    string opt = shift_parameter(parameters);
+    if(opt == "-r") {
+        Perf::reset();
+        stream->printf("Profiling statistics reset\n");
+        return;
+    }
+
+    Perf::print(stream);
+}
+#endif
+
 // print out build version
 void SimpleShell::version_command( string parameters, StreamOutput *stream)
 {
@@ -1151,5 +1191,9 @@ void SimpleShell::help_command( string parameters, StreamOutput *stream )
     stream->printf("calc_thermistor [-s0] T1,R1,T2,R2,T3,R3 - calculate the Steinhart Hart coefficients for a thermistor\r\n");
     stream->printf("thermistors - print out the predefined thermistors\r\n");
     stream->printf("md5sum file - prints md5 sum of the given file\r\n");
+    stream->printf("ticker [-r] - shows SlowTicker hook timings and ISR load, -r resets them\r\n");
+#ifdef PERF_PROFILING
+    stream->printf("perf [-r] - shows module event, interrupt and main loop timings, -r resets them\r\n");
+#endif
 }
 
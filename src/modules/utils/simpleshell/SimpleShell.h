@@ -60,6 +60,10 @@ private:
     static void remount_command( string parameters, StreamOutput *stream);
 
     static void test_command( string parameters, StreamOutput *stream);
+    static void ticker_command( string parameters, StreamOutput *stream);
+#ifdef PERF_PROFILING
+    static void perf_command( string parameters, StreamOutput *stream);
+#endif
 
     typedef void (*PFUNC)(string parameters, StreamOutput *stream);
     typedef struct {
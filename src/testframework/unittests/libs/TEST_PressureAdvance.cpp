@@ -0,0 +1,161 @@
+#include "Kernel.h"
+#include "StepTicker.h"
+#include "StepperMotor.h"
+#include "Block.h"
+#include "Pin.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <math.h>
+
+#include "easyunit/test.h"
+
+// Drives the extruder through a series of blocks to compare the commanded E steps with what pressure advance
+// actually delivers. The blocks are stepped by StepTicker::run_block, the same path the step tick ISR uses, on a
+// ticker of our own that is never started so the timers are left alone.
+
+DECLARE(PressureAdvance)
+    StepTicker *ticker;
+    StepTicker *saved_ticker;
+    uint8_t saved_n_actuators;
+    StepperMotor *x_motor;
+    StepperMotor *e_motor;
+END_DECLARE
+
+SETUP(PressureAdvance)
+{
+    saved_ticker= THEKERNEL->step_ticker;
+    saved_n_actuators= Block::n_actuators;
+
+    // does not replace StepTicker::getInstance() if there is one already
+    ticker= new StepTicker();
+    ticker->set_frequency(100000);
+    THEKERNEL->step_ticker= ticker;
+
+    Pin nc;
+    nc.from_string("nc");
+    x_motor= new StepperMotor(nc, nc, nc);
+    e_motor= new StepperMotor(nc, nc, nc);
+    e_motor->set_extruder(true);
+    ticker->register_motor(x_motor);
+    ticker->register_motor(e_motor);
+    Block::n_actuators= 2;
+}
+
+TEARDOWN(PressureAdvance)
+{
+    delete x_motor;
+    delete e_motor;
+    delete ticker;
+    THEKERNEL->step_ticker= saved_ticker;
+    Block::n_actuators= saved_n_actuators;
+}
+
+// next_e is true if the block after this one extrudes as well, which is what the planner works out
+static void make_block(Block &b, uint32_t xsteps, uint32_t esteps, float mm, float speed, float entry, float exit, bool next_e)
+{
+    b.clear();
+    b.steps[0]= xsteps;
+    b.steps[1]= esteps;
+    b.steps_event_count= std::max(xsteps, esteps);
+    b.millimeters= mm;
+    b.nominal_speed= speed;
+    b.nominal_rate= b.steps_event_count * speed / mm;
+    b.acceleration= 1000;
+    b.primary_axis= true;
+    b.next_advance_motor= next_e ? 1 : -1;
+    b.calculate_trapezoid(entry, exit);
+}
+
+// run the block to completion and return the number of E steps issued
+static uint32_t run_block(StepTicker *ticker, Block &b)
+{
+    ticker->run_block(&b);
+    return b.tick_info[1].step_count;
+}
+
+// accelerate from rest, cruise, stop, then a short move that does not reach full speed
+struct move_t { uint32_t x, e; float mm, speed, entry, exit; bool next_e; };
+static const move_t moves[]= {
+    {4000, 200, 50, 100, 0, 100, true},
+    {8000, 400, 100, 100, 100, 100, true},
+    {4000, 200, 50, 100, 100, 0, true},
+    {4000, 200, 50, 100, 0, 30, true},
+    {4000, 200, 50, 100, 30, 0, false},
+};
+
+TESTF(PressureAdvance, disabled_delivers_commanded)
+{
+    e_motor->set_pressure_advance(0, 0);
+    Block b;
+    for(auto &mv : moves) {
+        make_block(b, mv.x, mv.e, mv.mm, mv.speed, mv.entry, mv.exit, mv.next_e);
+        ASSERT_TRUE(b.advance_motor == -1);
+        ASSERT_TRUE(run_block(ticker, b) == mv.e);
+    }
+}
+
+TESTF(PressureAdvance, runs_ahead_and_returns)
+{
+    const float k= 0.05F;
+    e_motor->set_pressure_advance(k, 0);
+    Block b;
+    uint32_t commanded= 0, delivered= 0;
+    for(auto &mv : moves) {
+        make_block(b, mv.x, mv.e, mv.mm, mv.speed, mv.entry, mv.exit, mv.next_e);
+        ASSERT_TRUE(b.advance_motor == 1);
+        delivered += run_block(ticker, b);
+        commanded += mv.e;
+
+        // at the end of each block the extruder should be ahead by K * its rate, the block ends when X is done
+        // so it may be a couple of steps short which is made up in the next block
+        float e_rate= mv.e * mv.exit / mv.mm; // steps/sec
+        int32_t expected= lroundf(k * e_rate);
+        ASSERT_TRUE(abs(e_motor->get_advance_offset() - expected) <= 2);
+        ASSERT_TRUE(abs((int32_t)(delivered - commanded) - expected) <= 2);
+    }
+
+    // back at rest so everything commanded has been delivered
+    ASSERT_TRUE(abs((int32_t)delivered - (int32_t)commanded) <= 1);
+}
+
+TESTF(PressureAdvance, smoothing_delivers_commanded)
+{
+    e_motor->set_pressure_advance(0.05F, 0.01F);
+    Block b;
+    uint32_t commanded= 0, delivered= 0;
+    for(auto &mv : moves) {
+        make_block(b, mv.x, mv.e, mv.mm, mv.speed, mv.entry, mv.exit, mv.next_e);
+        delivered += run_block(ticker, b);
+        commanded += mv.e;
+    }
+    ASSERT_TRUE(abs((int32_t)delivered - (int32_t)commanded) <= 1);
+}
+
+TESTF(PressureAdvance, released_before_travel)
+{
+    // still at full speed at the end, but the next block does not extrude so the pressure is all let off
+    e_motor->set_pressure_advance(0.05F, 0);
+    Block b;
+    make_block(b, 4000, 200, 50, 100, 0, 100, false);
+    ASSERT_TRUE(b.advance_steps == 0);
+    uint32_t delivered= run_block(ticker, b);
+    ASSERT_TRUE(abs(e_motor->get_advance_offset()) <= 2);
+    ASSERT_TRUE(abs((int32_t)delivered - 200) <= 2);
+}
+
+TESTF(PressureAdvance, retract_not_advanced)
+{
+    e_motor->set_pressure_advance(0.05F, 0);
+    Block b;
+    make_block(b, 4000, 200, 50, 100, 0, 0, false);
+    b.direction_bits[1]= 1;
+    b.prepare();
+    ASSERT_TRUE(b.advance_motor == -1);
+
+    make_block(b, 0, 200, 2, 40, 0, 0, false);
+    b.primary_axis= false;
+    b.prepare();
+    ASSERT_TRUE(b.advance_motor == -1);
+}
@@ -0,0 +1,157 @@
+#include "Kernel.h"
+#include "Test_kernel.h"
+#include "Module.h"
+#include "PublicData.h"
+#include "PublicDataRequest.h"
+#include "checksumm.h"
+#include "us_ticker_api.h"
+
+#include <stdio.h>
+
+#include "easyunit/test.h"
+
+#define foo_checksum CHECKSUM("foo")
+#define bar_checksum CHECKSUM("bar")
+#define baz_checksum CHECKSUM("baz")
+
+// answers get requests for one namespace the way the real modules do, and counts how often it is asked
+class PublicDataModule : public Module {
+    public:
+        PublicDataModule(uint16_t cs) : cs(cs), value(0), calls(0) {}
+        void on_get_public_data(void *argument)
+        {
+            ++calls;
+            PublicDataRequest *pdr = static_cast<PublicDataRequest *>(argument);
+            if(!pdr->starts_with(cs)) return;
+            *static_cast<int *>(pdr->get_data_ptr())= value;
+            pdr->set_taken();
+        }
+        void on_set_public_data(void *argument)
+        {
+            ++calls;
+            PublicDataRequest *pdr = static_cast<PublicDataRequest *>(argument);
+            if(!pdr->starts_with(cs)) return;
+            value= *static_cast<int *>(pdr->get_data_ptr());
+            pdr->set_taken();
+        }
+
+        uint16_t cs;
+        int value;
+        int calls;
+};
+
+// about as many modules as a typical config has listening for public data requests
+#define N_MODULES 12
+
+DECLARE(PublicData)
+    PublicDataModule *modules[N_MODULES];
+END_DECLARE
+
+SETUP(PublicData)
+{
+    for (int i = 0; i < N_MODULES; ++i) {
+        // the last one is the one being asked
+        modules[i]= new PublicDataModule(i == N_MODULES-1 ? foo_checksum : bar_checksum);
+        THEKERNEL->register_for_event(ON_GET_PUBLIC_DATA, modules[i]);
+        THEKERNEL->register_for_event(ON_SET_PUBLIC_DATA, modules[i]);
+    }
+    // the test kernel complains about events nobody trapped
+    test_kernel_trap_event(ON_GET_PUBLIC_DATA, [](void *) {});
+    test_kernel_trap_event(ON_SET_PUBLIC_DATA, [](void *) {});
+}
+
+TEARDOWN(PublicData)
+{
+    for (int i = 0; i < N_MODULES; ++i) {
+        THEKERNEL->unregister_for_event(ON_GET_PUBLIC_DATA, modules[i]);
+        THEKERNEL->unregister_for_event(ON_SET_PUBLIC_DATA, modules[i]);
+        PublicData::unregister_handlers(modules[i]);
+        delete modules[i];
+    }
+    test_kernel_teardown();
+}
+
+TESTF(PublicData, broadcast_when_not_registered)
+{
+    PublicDataModule *foo= modules[N_MODULES-1];
+    foo->value= 42;
+    int v= 0;
+    ASSERT_TRUE(PublicData::get_value(foo_checksum, &v));
+    ASSERT_TRUE(v == 42);
+    for (int i = 0; i < N_MODULES; ++i) ASSERT_TRUE(modules[i]->calls == 1);
+}
+
+TESTF(PublicData, registered_is_called_directly)
+{
+    PublicDataModule *foo= modules[N_MODULES-1];
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, foo, foo_checksum);
+    PublicData::register_handler(ON_SET_PUBLIC_DATA, foo, foo_checksum);
+
+    int v= 123;
+    ASSERT_TRUE(PublicData::set_value(foo_checksum, &v));
+    v= 0;
+    ASSERT_TRUE(PublicData::get_value(foo_checksum, bar_checksum, baz_checksum, &v));
+    ASSERT_TRUE(v == 123);
+
+    ASSERT_TRUE(foo->calls == 2);
+    for (int i = 0; i < N_MODULES-1; ++i) ASSERT_TRUE(modules[i]->calls == 0);
+}
+
+TESTF(PublicData, registered_match)
+{
+    PublicDataModule *foo= modules[N_MODULES-1];
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, foo, foo_checksum, bar_checksum);
+
+    int v;
+    ASSERT_TRUE(PublicData::get_value(foo_checksum, bar_checksum, &v));
+    ASSERT_TRUE(foo->calls == 1);
+    ASSERT_TRUE(modules[0]->calls == 0);
+
+    // does not match the second element so is broadcast, and still answered
+    ASSERT_TRUE(PublicData::get_value(foo_checksum, baz_checksum, &v));
+    ASSERT_TRUE(foo->calls == 2);
+    ASSERT_TRUE(modules[0]->calls == 1);
+}
+
+TESTF(PublicData, falls_back_when_not_taken)
+{
+    // registered for a namespace it does not answer, the module that does answer it is only reached by the broadcast
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, modules[0], foo_checksum);
+
+    modules[N_MODULES-1]->value= 7;
+    int v= 0;
+    ASSERT_TRUE(PublicData::get_value(foo_checksum, &v));
+    ASSERT_TRUE(v == 7);
+    ASSERT_TRUE(modules[0]->calls == 2);
+
+    ASSERT_TRUE(!PublicData::get_value(baz_checksum, &v));
+}
+
+// not really a test, times the broadcast against the direct dispatch of the same request
+// NOTE the test kernel also calls the trap on each broadcast so it is a little slower than the real kernel
+TESTF(PublicData, benchmark)
+{
+    const int n= 10000;
+    PublicDataModule *foo= modules[N_MODULES-1];
+    int v;
+
+    uint32_t t1= us_ticker_read();
+    for (int i = 0; i < n; ++i) {
+        // this is what get_value used to do
+        PublicDataRequest pdr(foo_checksum, bar_checksum, baz_checksum);
+        pdr.set_data_ptr(&v, false);
+        THEKERNEL->call_event(ON_GET_PUBLIC_DATA, &pdr);
+        ASSERT_TRUE(pdr.is_taken());
+    }
+    uint32_t t2= us_ticker_read();
+
+    PublicData::register_handler(ON_GET_PUBLIC_DATA, foo, foo_checksum);
+    uint32_t t3= us_ticker_read();
+    for (int i = 0; i < n; ++i) {
+        ASSERT_TRUE(PublicData::get_value(foo_checksum, bar_checksum, baz_checksum, &v));
+    }
+    uint32_t t4= us_ticker_read();
+
+    printf("PublicData get_value x %d with %d modules: broadcast %lu us, direct %lu us\n", n, N_MODULES, (unsigned long)(t2 - t1), (unsigned long)(t4 - t3));
+    ASSERT_TRUE(t4 - t3 < t2 - t1);
+}
@@ -0,0 +1,254 @@
+#include "UploadSink.h"
+#include "FATFileSystem.h"
+#include "ff.h"
+#include "us_ticker_api.h"
+
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "easyunit/test.h"
+
+// a bit more than the upload, and small enough that the FAT is only a couple of sectors
+#define N_SECTORS 4096
+#define UPLOAD_SIZE (1024 * 1024)
+// what a full ethernet frame carries
+#define CHUNK_SIZE 1460
+
+// Stands in for the sdcard. The card is far too big to keep in memory, so only the sectors the filesystem itself uses are
+// kept. The sectors of the uploaded file are checked against what was sent, and that they went to the right sector, as
+// they are written and then thrown away, apart from the last one which the filesystem may read back when the file is reopened.
+class TestDisk : public mbed::FATFileSystem {
+    public:
+        TestDisk() : FATFileSystem("test")
+        {
+            last_data_sector= -1;
+            reset();
+        }
+        ~TestDisk()
+        {
+            for(auto &i : sectors) free(i.second);
+        }
+
+        // forget what has been written so far, but not what is on the disk
+        void reset()
+        {
+            seen.assign(UPLOAD_SIZE / 512 + 1, 0);
+            bad= 0;
+            writes= 0;
+            sectors_written= 0;
+            block_sector= -1;
+        }
+
+        virtual int disk_read(char *buffer, int sector)
+        {
+            if(sector == last_data_sector) {
+                memcpy(buffer, last_data, 512);
+            } else {
+                auto i= sectors.find(sector);
+                if(i != sectors.end()) memcpy(buffer, i->second, 512);
+                else memset(buffer, 0, 512);
+            }
+            return 0;
+        }
+
+        virtual int disk_write(const char *buffer, int sector)
+        {
+            ++writes;
+            store(buffer, sector);
+            return 0;
+        }
+
+        virtual int disk_write_blocks(const char *buffer, int sector, int count)
+        {
+            ++writes;
+            for (int i = 0; i < count; ++i) {
+                store(&buffer[i * 512], sector + i);
+            }
+            return 0;
+        }
+
+        virtual int disk_sectors() { return N_SECTORS; }
+
+        // the number of times each block of the file was written, and how many were not what was sent
+        std::vector<uint8_t> seen;
+        int bad;
+        int writes;
+        int sectors_written;
+
+    private:
+        void store(const char *buffer, int sector);
+
+        std::map<int, char*> sectors;
+        int last_data_sector;
+        char last_data[512];
+        int block_sector; // the file is on a freshly formatted disk so block n should be at sector block_sector + n
+};
+
+// each 512 byte block of the upload starts with a marker and its block number, so the disk can tell which it is
+static void fill_block(char *p, uint32_t block)
+{
+    memcpy(p, "UPLD", 4);
+    memcpy(&p[4], &block, 4);
+    for (int i = 8; i < 512; ++i) p[i]= (block + i) & 0xFF;
+}
+
+void TestDisk::store(const char *buffer, int sector)
+{
+    ++sectors_written;
+
+    if(memcmp(buffer, "UPLD", 4) == 0) {
+        uint32_t block;
+        memcpy(&block, &buffer[4], 4);
+        char expect[512];
+        fill_block(expect, block);
+        // the last block is only partly the file
+        size_t n= std::min(512, UPLOAD_SIZE - (int)block * 512);
+        if(block_sector < 0) block_sector= sector - block;
+        if(block >= seen.size() || memcmp(buffer, expect, n) != 0 || sector != block_sector + (int)block) ++bad;
+        else ++seen[block];
+        last_data_sector= sector;
+        memcpy(last_data, buffer, 512);
+        return;
+    }
+
+    if(sector == last_data_sector) last_data_sector= -1;
+
+    bool zero= true;
+    for (int i = 0; i < 512; ++i) {
+        if(buffer[i] != 0) {
+            zero= false;
+            break;
+        }
+    }
+
+    auto i= sectors.find(sector);
+    if(zero) {
+        if(i != sectors.end()) {
+            free(i->second);
+            sectors.erase(i);
+        }
+    } else {
+        if(i == sectors.end()) i= sectors.insert(std::make_pair(sector, (char *)malloc(512))).first;
+        memcpy(i->second, buffer, 512);
+    }
+}
+
+// hands out the upload in network sized chunks
+static const char *next_chunk(char *chunk, int offset, int& len)
+{
+    static char blocks[1024 + CHUNK_SIZE];
+    int start= offset & ~511;
+    int n= 0;
+    for (int b = start; b < offset + CHUNK_SIZE; b += 512, n += 512) {
+        fill_block(&blocks[n], b / 512);
+    }
+    len= std::min(CHUNK_SIZE, UPLOAD_SIZE - offset);
+    memcpy(chunk, &blocks[offset - start], len);
+    return chunk;
+}
+
+static bool all_written_once(TestDisk *disk)
+{
+    if(disk->bad != 0) return false;
+    for (int b = 0; b < (UPLOAD_SIZE + 511) / 512; ++b) {
+        if(disk->seen[b] != 1) {
+            printf("block %d written %d times\n", b, disk->seen[b]);
+            return false;
+        }
+    }
+    return true;
+}
+
+DECLARE(UploadSink)
+    TestDisk *disk;
+    char *chunk;
+END_DECLARE
+
+SETUP(UploadSink)
+{
+    disk= new TestDisk();
+    chunk= (char *)malloc(CHUNK_SIZE);
+    // 4K clusters so the filesystem can write several sectors at once
+    f_mkfs(disk->_fsid, 1, 4096);
+    disk->reset();
+}
+
+TEARDOWN(UploadSink)
+{
+    free(chunk);
+    delete disk;
+}
+
+TESTF(UploadSink, sector_aligned_writes)
+{
+    UploadSink sink;
+    ASSERT_TRUE(sink.open("/test/upload.g"));
+
+    uint32_t t1= us_ticker_read();
+    for (int offset = 0; offset < UPLOAD_SIZE; offset += CHUNK_SIZE) {
+        int len;
+        next_chunk(chunk, offset, len);
+        ASSERT_TRUE(sink.write(chunk, len));
+    }
+    ASSERT_TRUE(sink.close());
+    uint32_t t2= us_ticker_read();
+
+    ASSERT_TRUE(all_written_once(disk));
+    printf("UploadSink: %d bytes in %lu us, %1.3f MB/s, %d disk writes of %d sectors\n", UPLOAD_SIZE, (unsigned long)(t2 - t1),
+           (float)UPLOAD_SIZE / (t2 - t1), disk->writes, disk->sectors_written);
+
+    FILE *fp= fopen("/test/upload.g", "r");
+    ASSERT_TRUE(fp != NULL);
+    fseek(fp, 0, SEEK_END);
+    ASSERT_TRUE(ftell(fp) == UPLOAD_SIZE);
+    fclose(fp);
+}
+
+TESTF(UploadSink, append_at_offset)
+{
+    // start part way into a sector, as plan9 does when a write does not follow on from the last one
+    UploadSink sink;
+    int len;
+    ASSERT_TRUE(sink.open("/test/upload.g"));
+    next_chunk(chunk, 0, len);
+    ASSERT_TRUE(sink.write(chunk, 100));
+    ASSERT_TRUE(sink.close());
+    // the filesystem wrote a part filled first block, the rest of it is written after the reopen
+    disk->reset();
+
+    ASSERT_TRUE(sink.open("/test/upload.g", "r+", 100));
+    ASSERT_TRUE(sink.tell() == 100);
+    for (int offset = 100; offset < UPLOAD_SIZE; offset += CHUNK_SIZE) {
+        next_chunk(chunk, offset, len);
+        ASSERT_TRUE(sink.write(chunk, len));
+    }
+    ASSERT_TRUE(sink.close());
+
+    ASSERT_TRUE(all_written_once(disk));
+}
+
+// not really a test, what the webserver used to do, a write per packet and the file reopened every 400 bytes
+TESTF(UploadSink, benchmark_per_packet)
+{
+    FILE *fp= fopen("/test/upload.g", "w");
+    ASSERT_TRUE(fp != NULL);
+
+    uint32_t t1= us_ticker_read();
+    for (int offset = 0; offset < UPLOAD_SIZE; offset += CHUNK_SIZE) {
+        int len;
+        next_chunk(chunk, offset, len);
+        ASSERT_TRUE(fwrite(chunk, 1, len, fp) == (size_t)len);
+        fclose(fp);
+        fp= fopen("/test/upload.g", "a");
+        ASSERT_TRUE(fp != NULL);
+    }
+    fclose(fp);
+    uint32_t t2= us_ticker_read();
+
+    printf("per packet: %d bytes in %lu us, %1.3f MB/s, %d disk writes of %d sectors\n", UPLOAD_SIZE, (unsigned long)(t2 - t1),
+           (float)UPLOAD_SIZE / (t2 - t1), disk->writes, disk->sectors_written);
+}
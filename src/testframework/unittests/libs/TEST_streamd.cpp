@@ -0,0 +1,232 @@
+#include "Kernel.h"
+#include "Test_kernel.h"
+#include "Conveyor.h"
+#include "SerialMessage.h"
+#include "Network.h"
+#include "streamd.h"
+#include "uip.h"
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include "easyunit/test.h"
+#include "uip_test_peer.h"
+
+// The test is the host streaming gcode to the stream port, and it traps the lines that are dispatched.
+// The conveyor of the test kernel is never started so it always says its queue is full, which is used as a planner
+// that has no room, a started one in its place has room for every line.
+
+#define STREAM_PORT 7000
+
+// the host end of the connection
+class Host {
+    public:
+        Host() : snd_nxt(PEER_ISS), rcv_nxt(0), wnd(0) {}
+
+        bool connect()
+        {
+            Segment seg;
+            peer_send(TCP_SYN, snd_nxt, 0);
+            if(!take_output(seg) || seg.flags != (TCP_SYN | TCP_ACK)) return false;
+            ++snd_nxt;
+            rcv_nxt= seg.seq + 1;
+            wnd= seg.wnd;
+            peer_send(TCP_ACK, snd_nxt, rcv_nxt);
+            take_output(seg);
+            return true;
+        }
+
+        // sends what fits in the window, returns how much that was
+        int send(const std::string &data)
+        {
+            int n= std::min<int>(data.size(), std::min<int>(wnd, UIP_TCP_MSS));
+            if(n == 0) return 0;
+            peer_send(TCP_ACK | TCP_PSH, snd_nxt, rcv_nxt, data.data(), n);
+            snd_nxt+= n;
+            receive();
+            return n;
+        }
+
+        // what the Network does from on_idle, the stream connection is polled when it wants to be
+        void poll()
+        {
+            struct uip_conn *conn= Streamd::connection_to_poll();
+            if(conn == NULL) return;
+            uip_poll_conn(conn);
+            receive();
+        }
+
+        void close()
+        {
+            peer_send(TCP_RST | TCP_ACK, snd_nxt, rcv_nxt);
+            uip_len= 0;
+        }
+
+        uint32_t snd_nxt;
+        uint32_t rcv_nxt;
+        uint16_t wnd;
+        std::string replies;
+
+    private:
+        // takes uIPs answer and acks any replies in it
+        void receive()
+        {
+            Segment seg;
+            if(!take_output(seg)) return;
+            wnd= seg.wnd;
+            if(seg.data.size() > 0) {
+                replies.append(seg.data);
+                rcv_nxt+= seg.data.size();
+                peer_send(TCP_ACK, snd_nxt, rcv_nxt);
+                if(take_output(seg)) wnd= seg.wnd;
+            }
+        }
+};
+
+static std::vector<std::string> dispatched;
+
+const static char streamd_config[]= "\
+planner_queue_size 4 \n\
+";
+
+DECLARE(Streamd)
+    Host host;
+    Network *network;
+    Conveyor *full_conveyor;
+    Conveyor *free_conveyor;
+END_DECLARE
+
+SETUP(Streamd)
+{
+    // the network is only needed to route the connection to the stream, nothing is started
+    network= new Network();
+    network->webserver_enabled= false;
+    network->telnet_enabled= false;
+    network->plan9_enabled= false;
+    network->use_dhcp= false;
+    network->gcode_stream_enabled= true;
+    network->gcode_stream_port= STREAM_PORT;
+
+    // a started conveyor never fills up as nothing is planned, it is only asked if it is full
+    test_kernel_setup_config(streamd_config, &streamd_config[sizeof(streamd_config)]);
+    full_conveyor= THEKERNEL->conveyor;
+    free_conveyor= new Conveyor();
+    free_conveyor->on_module_loaded();
+    THEKERNEL->unregister_for_event(ON_IDLE, free_conveyor);
+    THEKERNEL->unregister_for_event(ON_HALT, free_conveyor);
+    free_conveyor->start(Block::n_actuators);
+    THEKERNEL->conveyor= free_conveyor;
+
+    dispatched.clear();
+    test_kernel_trap_event(ON_CONSOLE_LINE_RECEIVED, [](void *argument) {
+        SerialMessage *message= static_cast<SerialMessage *>(argument);
+        dispatched.push_back(message->message);
+        message->stream->printf("ok\n");
+    });
+
+    uip_init();
+    uip_ipaddr_t addr;
+    uip_ipaddr(addr, 10, 0, 0, 1);
+    uip_sethostaddr(addr);
+    uip_ipaddr(addr, 255, 255, 255, 0);
+    uip_setnetmask(addr);
+    uip_ipaddr(peer_addr, 10, 0, 0, 2);
+    server_port= STREAM_PORT;
+    Streamd::init(STREAM_PORT);
+
+    host= Host();
+    ASSERT_TRUE(host.connect());
+}
+
+TEARDOWN(Streamd)
+{
+    // only one host may stream at a time, so the next test needs this one gone
+    host.close();
+    THEKERNEL->conveyor= full_conveyor;
+    delete free_conveyor;
+    delete network;
+    test_kernel_teardown();
+}
+
+TESTF(Streamd, lines_in_order)
+{
+    // a CR ends a line too, as on the serial console
+    std::string data= "G1 X1\rG1 X2\nM114\r";
+    ASSERT_TRUE(host.send(data) == (int)data.size());
+    Streamd::dispatch_lines();
+    host.poll();
+
+    ASSERT_TRUE(dispatched.size() == 3);
+    ASSERT_TRUE(dispatched[0] == "G1 X1");
+    ASSERT_TRUE(dispatched[1] == "G1 X2");
+    ASSERT_TRUE(dispatched[2] == "M114");
+    ASSERT_TRUE(host.replies == "ok\nok\nok\n");
+
+    // a line split over two segments
+    ASSERT_TRUE(host.send("G1 Y") == 4);
+    Streamd::dispatch_lines();
+    ASSERT_TRUE(dispatched.size() == 3);
+    ASSERT_TRUE(host.send("5\n") == 2);
+    Streamd::dispatch_lines();
+    ASSERT_TRUE(dispatched.size() == 4);
+    ASSERT_TRUE(dispatched[3] == "G1 Y5");
+}
+
+TESTF(Streamd, long_line_dropped)
+{
+    // the first part of an over long line would be a valid move, so the whole line has to go
+    std::string data= "G1 X1\nG1 X2 ; " + std::string(200, 'a') + "\nG1 X3\n";
+    ASSERT_TRUE(host.send(data) == (int)data.size());
+    Streamd::dispatch_lines();
+    host.poll();
+
+    ASSERT_TRUE(dispatched.size() == 2);
+    ASSERT_TRUE(dispatched[0] == "G1 X1");
+    ASSERT_TRUE(dispatched[1] == "G1 X3");
+    ASSERT_TRUE(host.replies.find("error: line too long\n") != std::string::npos);
+
+    // it is the same when the line arrives in pieces
+    std::string part= "G1 X4 " + std::string(100, 'b');
+    ASSERT_TRUE(host.send(part) == (int)part.size());
+    ASSERT_TRUE(host.send(part) == (int)part.size());
+    ASSERT_TRUE(host.send("\nG1 X5\n") == 7);
+    Streamd::dispatch_lines();
+    ASSERT_TRUE(dispatched.size() == 3);
+    ASSERT_TRUE(dispatched[2] == "G1 X5");
+}
+
+TESTF(Streamd, window_closes_when_planner_full)
+{
+    // the planner has no room, so the lines stay buffered until the window closes
+    THEKERNEL->conveyor= full_conveyor;
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        char line[32];
+        snprintf(line, sizeof(line), "G1 X%d Y%d\n", i, i);
+        data.append(line);
+    }
+
+    size_t sent= 0;
+    for (int i = 0; i < 100 && sent < data.size(); ++i) {
+        int n= host.send(data.substr(sent));
+        if(n == 0) break;
+        sent+= n;
+        Streamd::dispatch_lines();
+    }
+    ASSERT_TRUE(host.wnd == 0);
+    ASSERT_TRUE(sent < data.size());
+    ASSERT_TRUE(dispatched.empty());
+
+    // once there is room again the lines go and the window opens
+    THEKERNEL->conveyor= free_conveyor;
+    for (int i = 0; i < 1000 && dispatched.size() < 1000; ++i) {
+        Streamd::dispatch_lines();
+        host.poll();
+        sent+= host.send(data.substr(sent));
+    }
+    ASSERT_TRUE(sent == data.size());
+    ASSERT_TRUE(dispatched.size() == 1000);
+    ASSERT_TRUE(dispatched[999] == "G1 X999 Y999");
+}
@@ -0,0 +1,167 @@
+#include "Network.h"
+#include "uip.h"
+
+extern "C" {
+#include "httpd.h"
+#include "httpd-fs.h"
+}
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include "easyunit/test.h"
+#include "uip_test_peer.h"
+
+// The test is the other end of a connection to the webserver, and it loses a segment on the way to check that it is
+// retransmitted from the send queue.
+
+// the segment the peer loses, counting the ones with data
+#define LOST_SEGMENT 4
+
+// the receiving side of the peer, it keeps segments that arrive out of order like most stacks do
+class Peer {
+    public:
+        Peer() : rcv_nxt(0), high(0), segments(0), data_segments(0), retransmits(0), lost(false), fin(false) {}
+
+        void receive(const Segment &seg)
+        {
+            uint32_t end= seg.seq + seg.data.size() + ((seg.flags & TCP_FIN) ? 1 : 0);
+            ++segments;
+            if((int32_t)(seg.seq - high) < 0) ++retransmits;
+            else high= end;
+
+            if(seg.data.size() > 0 && ++data_segments == LOST_SEGMENT && !lost) {
+                lost= true;
+                return;
+            }
+
+            if((int32_t)(seg.seq - rcv_nxt) >= 0) held[seg.seq]= seg;
+            for (auto i= held.find(rcv_nxt); i != held.end(); i= held.find(rcv_nxt)) {
+                received.append(i->second.data);
+                rcv_nxt+= i->second.data.size();
+                if(i->second.flags & TCP_FIN) {
+                    ++rcv_nxt;
+                    fin= true;
+                }
+                held.erase(i);
+            }
+        }
+
+        std::map<uint32_t, Segment> held;
+        std::string received;
+        uint32_t rcv_nxt;
+        uint32_t high;
+        int segments;
+        int data_segments;
+        int retransmits;
+        bool lost;
+        bool fin;
+};
+
+static struct uip_conn *find_conn()
+{
+    for (int i = 0; i < UIP_CONNS; ++i) {
+        if(uip_conns[i].tcpstateflags != UIP_CLOSED && uip_conns[i].rport == HTONS(PEER_PORT)) return &uip_conns[i];
+    }
+    return NULL;
+}
+
+DECLARE(UipSendQueue)
+    Network *network;
+END_DECLARE
+
+SETUP(UipSendQueue)
+{
+    // the network is only needed to route the connection to the webserver, nothing is started
+    network= new Network();
+    network->webserver_enabled= true;
+    network->telnet_enabled= false;
+    network->plan9_enabled= false;
+    network->use_dhcp= false;
+
+    uip_init();
+    uip_ipaddr_t addr;
+    uip_ipaddr(addr, 10, 0, 0, 1);
+    uip_sethostaddr(addr);
+    uip_ipaddr(addr, 255, 255, 255, 0);
+    uip_setnetmask(addr);
+    uip_ipaddr(peer_addr, 10, 0, 0, 2);
+    server_port= 80;
+    httpd_init();
+}
+
+TEARDOWN(UipSendQueue)
+{
+    delete network;
+}
+
+TESTF(UipSendQueue, download_with_loss)
+{
+    Peer peer;
+    Segment seg;
+
+    peer_send(TCP_SYN, PEER_ISS, 0, NULL, 0, true);
+    ASSERT_TRUE(take_output(seg));
+    ASSERT_TRUE(seg.flags == (TCP_SYN | TCP_ACK));
+    peer.rcv_nxt= peer.high= seg.seq + 1;
+
+    struct uip_conn *conn= find_conn();
+    ASSERT_TRUE(conn != NULL);
+
+    const char request[]= "GET / HTTP/1.1\r\n\r\n";
+    uint32_t snd_nxt= PEER_ISS + 1;
+    peer_send(TCP_ACK | TCP_PSH, snd_nxt, peer.rcv_nxt, request, strlen(request));
+    snd_nxt+= strlen(request);
+    ASSERT_TRUE(conn->mss == UIP_TCP_MSS);
+
+    int max_in_flight= 0;
+    int ticks= 0;
+    for (int i = 0; i < 1000 && !peer.fin; ++i) {
+        int before= peer.segments;
+
+        // the reply to what the peer sent
+        if(take_output(seg)) peer.receive(seg);
+
+        // what Network::fill_send_queue() does
+        while(uip_sndq_pending(conn)) {
+            uip_poll_conn(conn);
+            if(!take_output(seg)) break;
+            peer.receive(seg);
+        }
+        if(conn->len > max_in_flight) max_in_flight= conn->len;
+
+        if(peer.segments == before) {
+            // nothing more is coming, time passes
+            uip_periodic(conn - uip_conns);
+            ++ticks;
+        } else {
+            peer_send(TCP_ACK, snd_nxt, peer.rcv_nxt);
+        }
+    }
+
+    ASSERT_TRUE(peer.fin);
+    ASSERT_TRUE(peer.lost);
+    ASSERT_TRUE(peer.retransmits > 0);
+
+    // several full segments were in flight at once
+    ASSERT_TRUE(max_in_flight > 2 * UIP_TCP_MSS);
+
+    // the reply is all there and in order
+    struct httpd_fs_file file;
+    ASSERT_TRUE(httpd_fs_open("/index.html", &file));
+    ASSERT_TRUE(peer.received.compare(0, 15, "HTTP/1.0 200 OK") == 0);
+    ASSERT_TRUE(peer.received.size() > (size_t)file.len);
+    ASSERT_TRUE(peer.received.compare(peer.received.size() - file.len, file.len, file.data, file.len) == 0);
+
+    printf("uip send queue: %d bytes in %d segments, up to %d bytes in flight, %d retransmitted, %d timer ticks\n",
+           (int)peer.received.size(), peer.segments, max_in_flight, peer.retransmits, ticks);
+
+    // the peer closes its end too
+    peer_send(TCP_FIN | TCP_ACK, snd_nxt, peer.rcv_nxt);
+    ASSERT_TRUE(take_output(seg));
+    ASSERT_TRUE(seg.flags == TCP_ACK);
+    ASSERT_TRUE((conn->tcpstateflags & UIP_TS_MASK) == UIP_TIME_WAIT);
+}
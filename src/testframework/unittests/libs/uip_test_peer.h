@@ -0,0 +1,103 @@
+#pragma once
+
+// The other end of a TCP connection to uIP, for the tests of the network code. The frames it sends go straight into
+// uip_buf and the ones uIP sends are taken out of it, so it stands in for the ethernet driver.
+// The test sets peer_addr and the server_port it connects to before it sends anything.
+
+#include "uip.h"
+
+#include <string>
+#include <string.h>
+
+#define TCPBUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_RST 0x04
+#define TCP_PSH 0x08
+#define TCP_ACK 0x10
+
+#define PEER_PORT 40000
+#define PEER_WINDOW 8192
+#define PEER_ISS 1000
+
+struct Segment {
+    uint32_t seq;
+    uint32_t ack;
+    uint16_t wnd;
+    uint8_t flags;
+    std::string data;
+};
+
+static uip_ipaddr_t peer_addr;
+static uint16_t server_port;
+
+static inline uint32_t get32(const u8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void put32(u8_t *p, uint32_t v)
+{
+    p[0]= v >> 24;
+    p[1]= v >> 16;
+    p[2]= v >> 8;
+    p[3]= v;
+}
+
+// the peer sends a segment to uIP, which may leave one to send back in uip_buf
+static inline void peer_send(uint8_t flags, uint32_t seq, uint32_t ack, const char *data= NULL, int len= 0, bool mss= false)
+{
+    struct uip_tcpip_hdr *b= TCPBUF;
+    int hlen= UIP_TCPIP_HLEN + (mss ? 4 : 0);
+
+    memset(uip_buf, 0, UIP_LLH_LEN + hlen);
+    b->vhl= 0x45;
+    b->len[0]= (hlen + len) >> 8;
+    b->len[1]= (hlen + len) & 0xFF;
+    b->ttl= 64;
+    b->proto= UIP_PROTO_TCP;
+    uip_ipaddr_copy(b->srcipaddr, peer_addr);
+    uip_ipaddr_copy(b->destipaddr, uip_hostaddr);
+    b->ipchksum= 0;
+    b->ipchksum= ~(uip_ipchksum());
+
+    b->srcport= HTONS(PEER_PORT);
+    b->destport= HTONS(server_port);
+    put32(b->seqno, seq);
+    put32(b->ackno, ack);
+    b->tcpoffset= ((hlen - UIP_IPH_LEN) / 4) << 4;
+    b->flags= flags;
+    b->wnd[0]= PEER_WINDOW >> 8;
+    b->wnd[1]= PEER_WINDOW & 0xFF;
+    if(mss) {
+        // offers a full sized ethernet frame, more than uIP can take
+        b->optdata[0]= 2;
+        b->optdata[1]= 4;
+        b->optdata[2]= 1460 >> 8;
+        b->optdata[3]= 1460 & 0xFF;
+    }
+    if(len > 0) memcpy(&uip_buf[UIP_LLH_LEN + hlen], data, len);
+    b->tcpchksum= 0;
+    b->tcpchksum= ~(uip_tcpchksum());
+
+    uip_len= UIP_LLH_LEN + hlen + len;
+    uip_input();
+}
+
+// takes the segment uIP left in uip_buf, if there is one
+static inline bool take_output(Segment &seg)
+{
+    if(uip_len == 0) return false;
+
+    struct uip_tcpip_hdr *b= TCPBUF;
+    int hlen= UIP_IPH_LEN + (b->tcpoffset >> 4) * 4;
+    int len= ((b->len[0] << 8) | b->len[1]) - hlen;
+    seg.seq= get32(b->seqno);
+    seg.ack= get32(b->ackno);
+    seg.wnd= (b->wnd[0] << 8) | b->wnd[1];
+    seg.flags= b->flags;
+    seg.data.assign((const char *)&uip_buf[UIP_LLH_LEN + hlen], len);
+    uip_len= 0;
+    return true;
+}
@@ -0,0 +1,169 @@
+#include "Kernel.h"
+#include "Test_kernel.h"
+#include "Config.h"
+#include "BaseSolution.h"
+#include "LinearDeltaSolution.h"
+#include "RotaryDeltaSolution.h"
+#include "MorganSCARASolution.h"
+#include "CartesianSolution.h"
+#include "HBotSolution.h"
+#include "FixedKinematics.h"
+#include "ActuatorCoordinates.h"
+#include "nuts_bolts.h"
+#include "us_ticker_api.h"
+#include "system_LPC17xx.h"
+
+#include <stdio.h>
+#include <math.h>
+
+#include "easyunit/test.h"
+
+// the defaults are used for the geometry, so nothing much needs to be set
+const static char arm_config[]= "\
+arm_length 250 \n\
+";
+
+// points are laid out like the segmentation lays them out, XYZ followed by an extruder
+#define STRIDE 4
+#define N_POINTS 64
+
+DECLARE(ArmSolutions)
+    float points[N_POINTS * STRIDE];
+END_DECLARE
+
+SETUP(ArmSolutions)
+{
+    test_kernel_setup_config(arm_config, &arm_config[sizeof(arm_config)]);
+}
+
+TEARDOWN(ArmSolutions)
+{
+    test_kernel_teardown();
+}
+
+// a line of points from x0,y0,z0 to x1,y1,z1 which is what a segmented move looks like
+static void make_points(float *points, float x0, float y0, float z0, float x1, float y1, float z1)
+{
+    for (int i = 0; i < N_POINTS; ++i) {
+        float t= (float)i / (N_POINTS - 1);
+        float *p= &points[i * STRIDE];
+        p[X_AXIS]= x0 + (x1 - x0) * t;
+        p[Y_AXIS]= y0 + (y1 - y0) * t;
+        p[Z_AXIS]= z0 + (z1 - z0) * t;
+        p[3]= 1234.5F; // must not be touched
+    }
+}
+
+// the batch has to give the same answer as one call per point
+static bool check_batch(BaseSolution *solution, const float *points)
+{
+    ActuatorCoordinates batch[N_POINTS];
+    solution->batch_cartesian_to_actuator(points, STRIDE, batch, N_POINTS);
+
+    for (int i = 0; i < N_POINTS; ++i) {
+        ActuatorCoordinates single;
+        solution->cartesian_to_actuator(&points[i * STRIDE], single);
+        for (int a = ALPHA_STEPPER; a <= GAMMA_STEPPER; ++a) {
+            if(fabsf(batch[i][a] - single[a]) > 0.001F) {
+                printf("point %d actuator %d: batch %f single %f\n", i, a, batch[i][a], single[a]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// times n points through each interface and prints the points per second for both
+static void benchmark(const char *name, BaseSolution *solution, const float *points)
+{
+    const int loops= 100;
+    ActuatorCoordinates batch[N_POINTS];
+
+    uint32_t t1= us_ticker_read();
+    for (int l = 0; l < loops; ++l) {
+        for (int i = 0; i < N_POINTS; ++i) {
+            solution->cartesian_to_actuator(&points[i * STRIDE], batch[i]);
+        }
+    }
+    uint32_t t2= us_ticker_read();
+    for (int l = 0; l < loops; ++l) {
+        solution->batch_cartesian_to_actuator(points, STRIDE, batch, N_POINTS);
+    }
+    uint32_t t3= us_ticker_read();
+
+    float n= loops * N_POINTS;
+    printf("%s: single %1.0f points/sec, batch %1.0f points/sec\n", name, n * 1e6F / (t2 - t1), n * 1e6F / (t3 - t2));
+}
+
+TESTF(ArmSolutions, linear_delta)
+{
+    LinearDeltaSolution solution(THEKERNEL->config);
+    make_points(points, -80, -50, 0, 70, 60, 30);
+    ASSERT_TRUE(check_batch(&solution, points));
+    ASSERT_TRUE(points[3] == 1234.5F);
+    benchmark("linear delta", &solution, points);
+}
+
+TESTF(ArmSolutions, rotary_delta)
+{
+    RotaryDeltaSolution solution(THEKERNEL->config);
+    make_points(points, -50, -40, -10, 40, 50, 20);
+    ASSERT_TRUE(check_batch(&solution, points));
+    benchmark("rotary delta", &solution, points);
+}
+
+TESTF(ArmSolutions, morgan_scara)
+{
+    MorganSCARASolution solution(THEKERNEL->config);
+    make_points(points, 20, 10, 0, 160, 120, 10);
+    ASSERT_TRUE(check_batch(&solution, points));
+    benchmark("morgan scara", &solution, points);
+}
+
+// the kinematics built into the move path with make KINEMATICS=xxx have to match the arm solution, and this shows what
+// doing them inline saves on each point against the virtual call
+template<typename K>
+static bool check_fixed(const char *name, BaseSolution *solution, const float *points)
+{
+    const int loops= 100;
+    ActuatorCoordinates fixed[N_POINTS], virt[N_POINTS];
+
+    K::batch_cartesian_to_actuator(points, STRIDE, fixed, N_POINTS);
+    solution->batch_cartesian_to_actuator(points, STRIDE, virt, N_POINTS);
+    for (int i = 0; i < N_POINTS; ++i) {
+        for (int a = ALPHA_STEPPER; a <= GAMMA_STEPPER; ++a) {
+            if(fixed[i][a] != virt[i][a]) {
+                printf("%s point %d actuator %d: fixed %f virtual %f\n", name, i, a, fixed[i][a], virt[i][a]);
+                return false;
+            }
+        }
+    }
+
+    uint32_t t1= us_ticker_read();
+    for (int l = 0; l < loops; ++l) {
+        for (int i = 0; i < N_POINTS; ++i) {
+            solution->cartesian_to_actuator(&points[i * STRIDE], virt[i]);
+        }
+    }
+    uint32_t t2= us_ticker_read();
+    for (int l = 0; l < loops; ++l) {
+        K::batch_cartesian_to_actuator(points, STRIDE, fixed, N_POINTS);
+    }
+    uint32_t t3= us_ticker_read();
+
+    float n= loops * N_POINTS;
+    float cycles_per_us= SystemCoreClock / 1e6F;
+    printf("%s: virtual %1.1f cycles/point, fixed %1.1f cycles/point\n", name, (t2 - t1) * cycles_per_us / n, (t3 - t2) * cycles_per_us / n);
+    return true;
+}
+
+TESTF(ArmSolutions, fixed_kinematics)
+{
+    make_points(points, -80, -50, 0, 70, 60, 30);
+
+    CartesianSolution cartesian(THEKERNEL->config);
+    ASSERT_TRUE(check_fixed<CartesianKinematics>("cartesian", &cartesian, points));
+
+    HBotSolution corexy(THEKERNEL->config);
+    ASSERT_TRUE(check_fixed<CoreXYKinematics>("corexy", &corexy, points));
+}
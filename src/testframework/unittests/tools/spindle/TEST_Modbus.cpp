@@ -0,0 +1,169 @@
+#include "Kernel.h"
+#include "Test_kernel.h"
+#include "Modbus.h"
+#include "ModbusTransport.h"
+#include "wait_api.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "easyunit/test.h"
+
+// A transport with nothing on the other end, what is written is kept so the test can look at the frame
+// and feed it, or anything else, back as the reply
+class StubTransport : public ModbusTransport {
+    public:
+        void baud(int) {}
+        void format(int, PARITY, int) {}
+        void write(const char *data, uint8_t len) { sent.assign(data, data + len); }
+        bool readable() { return rx_index < rx.size(); }
+        char getc() { return rx[rx_index++]; }
+
+        // the frame has gone out
+        void transmit_complete() { tx_complete_fnc(); }
+
+        // a reply arrives one character per interrupt
+        void receive(const std::vector<char> &data)
+        {
+            rx= data;
+            rx_index= 0;
+            while(readable()) rx_fnc();
+        }
+
+        std::vector<char> sent;
+        std::vector<char> rx;
+        size_t rx_index{0};
+};
+
+DECLARE(Modbus)
+    StubTransport *stub;
+    Modbus *modbus;
+    bool called;
+    bool reply_ok;
+    std::vector<char> reply;
+END_DECLARE
+
+SETUP(Modbus)
+{
+    stub= new StubTransport();
+    modbus= new Modbus(stub);
+    modbus->on_module_loaded();
+    modbus->turnaround_time= 0;
+    called= false;
+    reply_ok= false;
+}
+
+TEARDOWN(Modbus)
+{
+    THEKERNEL->unregister_for_event(ON_IDLE, modbus);
+    THEKERNEL->unregister_for_event(ON_HALT, modbus);
+    delete modbus; // deletes the stub
+    test_kernel_teardown();
+}
+
+// the spindle on frame from the Huanyang protocol description
+TESTF(Modbus, crc16)
+{
+    const char msg[]= { 0x01, 0x03, 0x01, 0x01 };
+    ASSERT_TRUE(Modbus::crc16(msg, sizeof(msg)) == 0x8831);
+
+    const char read_freq[]= { 0x01, 0x04, 0x03, 0x00, 0x00, 0x00 };
+    ASSERT_TRUE(Modbus::crc16(read_freq, sizeof(read_freq)) == 0x4EF0);
+}
+
+// write single register is answered with an echo of the request, so the loopback is a valid reply
+TESTF(Modbus, loopback)
+{
+    const char msg[]= { 0x01, 0x06, 0x00, 0x10, 0x12, 0x34 };
+    modbus->send_frame(msg, sizeof(msg), 8, [this](bool ok, const char *r, uint8_t len) {
+        called= true;
+        reply_ok= ok;
+        reply.assign(r, r + len);
+    });
+
+    // nothing goes out until the main loop gets to it
+    ASSERT_TRUE(stub->sent.empty());
+    ASSERT_TRUE(!modbus->is_idle());
+    modbus->on_idle(nullptr);
+
+    // framing is the frame followed by the CRC, low byte first
+    ASSERT_TRUE(stub->sent.size() == 8);
+    ASSERT_TRUE(memcmp(stub->sent.data(), msg, sizeof(msg)) == 0);
+    ASSERT_TRUE(stub->sent[6] == (char)0x85);
+    ASSERT_TRUE(stub->sent[7] == (char)0x78);
+
+    stub->transmit_complete();
+    stub->receive(stub->sent);
+    ASSERT_TRUE(!called);
+    modbus->on_idle(nullptr);
+
+    ASSERT_TRUE(called);
+    ASSERT_TRUE(reply_ok);
+    ASSERT_TRUE(reply == stub->sent);
+}
+
+TESTF(Modbus, corrupt_reply)
+{
+    const char msg[]= { 0x01, 0x06, 0x00, 0x10, 0x12, 0x34 };
+    modbus->send_frame(msg, sizeof(msg), 8, [this](bool ok, const char *r, uint8_t len) { called= true; reply_ok= ok; });
+    modbus->on_idle(nullptr);
+    stub->transmit_complete();
+
+    std::vector<char> bad= stub->sent;
+    bad[4] ^= 0x01;
+    stub->receive(bad);
+    modbus->on_idle(nullptr);
+
+    ASSERT_TRUE(called);
+    ASSERT_TRUE(!reply_ok);
+}
+
+TESTF(Modbus, exception_reply)
+{
+    const char msg[]= { 0x01, 0x06, 0x00, 0x10, 0x12, 0x34 };
+    modbus->send_frame(msg, sizeof(msg), 8, [this](bool ok, const char *r, uint8_t len) { called= true; reply_ok= ok; reply.assign(r, r + len); });
+    modbus->on_idle(nullptr);
+    stub->transmit_complete();
+
+    // illegal data address, only 5 bytes so the reply must not wait for 8
+    char ex[5]= { 0x01, (char)0x86, 0x02, 0x00, 0x00 };
+    unsigned int crc= Modbus::crc16(ex, 3);
+    ex[3]= crc;
+    ex[4]= crc >> 8;
+    stub->receive(std::vector<char>(ex, ex + 5));
+    modbus->on_idle(nullptr);
+
+    ASSERT_TRUE(called);
+    ASSERT_TRUE(!reply_ok);
+    ASSERT_TRUE(reply.size() == 5);
+}
+
+// frames are sent one at a time in the order they were queued
+TESTF(Modbus, queued_in_order)
+{
+    const char first[]= { 0x01, 0x03, 0x01, 0x01 };
+    const char second[]= { 0x01, 0x03, 0x01, 0x08 };
+    modbus->send_frame(first, sizeof(first));
+    modbus->send_frame(second, sizeof(second));
+
+    modbus->on_idle(nullptr);
+    ASSERT_TRUE(stub->sent[3] == 0x01);
+    stub->sent.clear();
+
+    // still on the wire
+    modbus->on_idle(nullptr);
+    ASSERT_TRUE(stub->sent.empty());
+
+    stub->transmit_complete();
+    modbus->on_idle(nullptr); // hands back the first, starts the turnaround
+    wait_us(1000);
+    modbus->on_idle(nullptr);
+    ASSERT_TRUE(stub->sent.size() == 6);
+    ASSERT_TRUE(stub->sent[3] == 0x08);
+
+    stub->transmit_complete();
+    modbus->on_idle(nullptr);
+    wait_us(1000);
+    ASSERT_TRUE(modbus->is_idle());
+}